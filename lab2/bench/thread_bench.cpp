@@ -0,0 +1,159 @@
+#include "thread_lab.h"
+#include "parallel_lab.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if __has_include(<tbb/global_control.h>) && !defined(PARALLEL_LAB_SEQUENTIAL)
+#include <tbb/global_control.h>
+#define THREAD_BENCH_HAS_TBB 1
+#endif
+
+// Prints CSV: engine,phase,size,threads,median_ms,melems_per_sec
+//   seq     - single-threaded loop (auto-vectorized by the compiler)
+//   threads - hand-rolled std::thread workers, one chunk each
+//   par     - std::execution::par_unseq algorithms
+//   workers - min_max_thread + average_thread with simulated work disabled
+
+namespace {
+
+volatile long long sink;
+
+std::vector<size_t> parseList(const std::string& text) {
+    std::vector<size_t> values;
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        values.push_back(static_cast<size_t>(std::stoull(item)));
+    }
+    return values;
+}
+
+template<typename F>
+double medianMs(int repeat, F&& body) {
+    std::vector<double> samples;
+    for (int r = 0; r < repeat; r++) {
+        auto start = std::chrono::steady_clock::now();
+        body();
+        auto stop = std::chrono::steady_clock::now();
+        samples.push_back(std::chrono::duration<double, std::milli>(stop - start).count());
+    }
+    std::sort(samples.begin(), samples.end());
+    return samples[samples.size() / 2];
+}
+
+void report(const char* engine, const char* phase, size_t size, size_t threads, double ms) {
+    double rate = ms > 0 ? size / ms / 1000.0 : 0.0;
+    std::cout << engine << "," << phase << "," << size << "," << threads << ","
+        << ms << "," << rate << std::endl;
+}
+
+void sinkStats(const ArrayStats& s) {
+    sink = s.min + s.max + static_cast<long long>(s.average);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::vector<size_t> sizes = { 1000, 10000, 100000, 1000000, 10000000 };
+    std::vector<size_t> threadCounts;
+    int repeat = 5;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--sizes" && i + 1 < argc) {
+            sizes = parseList(argv[++i]);
+        }
+        else if (arg == "--threads" && i + 1 < argc) {
+            threadCounts = parseList(argv[++i]);
+        }
+        else if (arg == "--repeat" && i + 1 < argc) {
+            repeat = std::max(1, std::atoi(argv[++i]));
+        }
+        else {
+            std::cerr << "Usage: ThreadBench [--sizes a,b,..] [--threads a,b,..] [--repeat N]" << std::endl;
+            return 1;
+        }
+    }
+
+    if (threadCounts.empty()) {
+        size_t hw = std::max(1u, std::thread::hardware_concurrency());
+        for (size_t t = 1; t < hw; t *= 2) threadCounts.push_back(t);
+        threadCounts.push_back(hw);
+    }
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> dist(-1000000, 1000000);
+
+    std::cout << "engine,phase,size,threads,median_ms,melems_per_sec" << std::endl;
+
+    for (size_t size : sizes) {
+        std::vector<int> source(size);
+        for (auto& v : source) v = dist(rng);
+
+        ArrayStats reference = computeStatsSequential(source);
+
+        report("seq", "stats", size, 1, medianMs(repeat, [&]() {
+            sinkStats(computeStatsSequential(source));
+        }));
+
+        report("workers", "stats", size, 2, medianMs(repeat, [&]() {
+            int minVal, maxVal;
+            double avgVal;
+            bool errorFlag = false;
+            std::string errorMessage;
+
+            ThreadData data;
+            data.array = &source;
+            data.min = &minVal;
+            data.max = &maxVal;
+            data.average = &avgVal;
+            data.errorFlag = &errorFlag;
+            data.errorMessage = &errorMessage;
+            data.minMaxWorkUs = 0;
+            data.averageWorkUs = 0;
+
+            std::thread minMax(min_max_thread, &data);
+            std::thread average(average_thread, &data);
+            minMax.join();
+            average.join();
+            sink = minVal + maxVal + static_cast<long long>(avgVal);
+        }));
+
+        std::vector<int> work;
+        report("seq", "replace", size, 1, medianMs(repeat, [&]() {
+            work = source;
+            replaceMinMaxWithAverage(work, reference.min, reference.max, reference.average);
+        }));
+
+        for (size_t threads : threadCounts) {
+            report("threads", "stats", size, threads, medianMs(repeat, [&]() {
+                sinkStats(computeStatsThreaded(source, static_cast<unsigned>(threads)));
+            }));
+
+#ifdef THREAD_BENCH_HAS_TBB
+            tbb::global_control limit(tbb::global_control::max_allowed_parallelism, threads);
+            size_t parThreads = threads;
+#else
+            size_t parThreads = 0;
+            if (threads != threadCounts.front()) continue;
+#endif
+            report("par", "stats", size, parThreads, medianMs(repeat, [&]() {
+                sinkStats(computeStatsParallel(source));
+            }));
+
+            report("par", "replace", size, parThreads, medianMs(repeat, [&]() {
+                work = source;
+                replaceMinMaxWithAverageParallel(work, reference.min, reference.max, reference.average);
+            }));
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "cpu_placement.h"
+#include "thread_trace.h"
+
+struct BatchJob {
+    std::string name;
+    std::vector<int> array;
+};
+
+struct BatchResult {
+    std::string name;
+    int min;
+    int max;
+    double average;
+    std::vector<int> array;
+    bool errorFlag;
+    std::string errorMessage;
+};
+
+struct BatchOptions {
+    unsigned workers;        // 0 = one per hardware thread
+    size_t smallArrayLimit;  // arrays up to this size are packed together
+    size_t packElements;     // element budget of one packed work unit
+    ThreadTracer* tracer;    // optional; one chunk span per work unit
+    const ThreadPlacement* placement;  // optional; workers pin themselves before the first unit
+};
+
+BatchOptions defaultBatchOptions();
+
+// Each regular file holds one array as whitespace-separated integers.
+// Jobs are ordered by file name.
+std::vector<BatchJob> loadBatchDirectory(const std::string& path);
+
+// Framed binary stream: repeated [uint32 count][int32 x count] in native byte order.
+std::vector<BatchJob> loadBatchStream(std::istream& in);
+void writeBatchFrame(std::ostream& out, const std::vector<int>& array);
+
+// Results come back in job order regardless of which worker ran them.
+std::vector<BatchResult> runBatch(const std::vector<BatchJob>& jobs, const BatchOptions& options);
+
+void writeBatchReport(std::ostream& out, const std::vector<BatchResult>& results);
+// Result frame: [uint32 count][int32 min][int32 max][double average][int32 x count].
+// Failed jobs are written with count = 0.
+void writeBatchResults(std::ostream& out, const std::vector<BatchResult>& results);
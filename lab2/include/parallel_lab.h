@@ -0,0 +1,21 @@
+#pragma once
+
+#include <vector>
+
+struct ArrayStats {
+    int min;
+    int max;
+    double average;
+};
+
+// C++17 parallel-algorithm backend (par_unseq). On Linux libstdc++ runs these on TBB,
+// so the worker count is whatever the TBB arena allows; a build without TBB
+// (PARALLEL_LAB_SEQUENTIAL) runs the same algorithms sequentially.
+ArrayStats computeStatsParallel(const std::vector<int>& arr);
+void replaceMinMaxWithAverageParallel(std::vector<int>& arr, int minVal, int maxVal, double avgVal);
+
+// Same computation with hand-rolled threads, one contiguous chunk per thread.
+ArrayStats computeStatsThreaded(const std::vector<int>& arr, unsigned threads);
+
+// Single-threaded reference; the loop is left to the compiler's auto-vectorizer.
+ArrayStats computeStatsSequential(const std::vector<int>& arr);
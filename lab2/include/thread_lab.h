@@ -1,11 +1,19 @@
 #pragma once
 
+#ifdef _WIN32
 #include <windows.h>
+#else
+#include <cstdint>
+typedef uint32_t DWORD;
+typedef void* LPVOID;
+#define WINAPI
+#endif
 #include <vector>
 #include <iostream>
 #include <string>
 #include <limits>
 #include <exception>
+#include "thread_trace.h"
 
 struct ThreadData {
     std::vector<int>* array;
@@ -14,6 +22,10 @@ struct ThreadData {
     double* average;
     bool* errorFlag; 
     std::string* errorMessage;
+    // Simulated work per element; 0 measures the bare loops.
+    unsigned minMaxWorkUs = 7000;
+    unsigned averageWorkUs = 12000;
+    ThreadTracer* tracer = nullptr;
 };
 
 bool validateArray(const std::vector<int>& arr);
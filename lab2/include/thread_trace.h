@@ -0,0 +1,78 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+typedef std::chrono::steady_clock TraceClock;
+
+enum TraceSpanKind {
+    TRACE_WORKER,
+    TRACE_CHUNK,
+    TRACE_WAIT
+};
+
+struct TraceSpan {
+    TraceSpanKind kind;
+    int64_t startNs;
+    int64_t durationNs;
+    size_t elements;
+    int64_t waitNs;
+};
+
+struct WorkerTraceLog {
+    std::string name;
+    std::vector<TraceSpan> spans;
+};
+
+// Collects spans from any number of workers. Each worker appends only to its own
+// log, so recording takes no lock; registration is the only synchronized step.
+class ThreadTracer {
+public:
+    explicit ThreadTracer(size_t chunkElements = 1024);
+
+    size_t chunkElements() const { return chunk; }
+    int64_t sinceEpochNs(TraceClock::time_point t) const;
+
+    WorkerTraceLog* registerWorker(const std::string& name);
+
+    void writeChromeTrace(std::ostream& out) const;
+    void writeSummary(std::ostream& out) const;
+
+private:
+    TraceClock::time_point epoch;
+    size_t chunk;
+    mutable std::mutex registryLock;
+    std::vector<std::unique_ptr<WorkerTraceLog>> workers;
+};
+
+// Per-thread recorder. With a null tracer every call is a no-op apart from the
+// simulated work itself, so untraced runs pay one branch per element.
+class WorkerTrace {
+public:
+    WorkerTrace(ThreadTracer* tracer, const std::string& name);
+    ~WorkerTrace();
+
+    WorkerTrace(const WorkerTrace&) = delete;
+    WorkerTrace& operator=(const WorkerTrace&) = delete;
+
+    void element();
+    void chunk(size_t elements);
+    void simulateWork(unsigned microseconds);
+    void recordWait(TraceClock::time_point start);
+
+private:
+    void closeChunk(TraceClock::time_point now);
+
+    ThreadTracer* tracer;
+    WorkerTraceLog* log;
+    TraceClock::time_point workerStart;
+    TraceClock::time_point chunkStart;
+    size_t chunkCount;
+    int64_t chunkWaitNs;
+};
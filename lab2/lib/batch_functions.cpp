@@ -0,0 +1,301 @@
+#include "batch_lab.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+const uint32_t kMaxBatchArraySize = 1000000;
+
+struct WorkUnit {
+    size_t first;
+    size_t last;
+    bool packed;
+};
+
+void computeStats(const int* data, size_t count, BatchResult& result) {
+    int minVal = data[0];
+    int maxVal = data[0];
+    long long sum = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        if (data[i] < minVal) minVal = data[i];
+        if (data[i] > maxVal) maxVal = data[i];
+        sum += data[i];
+    }
+
+    result.min = minVal;
+    result.max = maxVal;
+    result.average = static_cast<double>(sum) / count;
+}
+
+void replaceRange(int* data, size_t count, int minVal, int maxVal, double avgVal) {
+    for (size_t i = 0; i < count; i++) {
+        if (data[i] == minVal || data[i] == maxVal) {
+            data[i] = static_cast<int>(avgVal);
+        }
+    }
+}
+
+bool processInPlace(int* data, size_t count, BatchResult& result) {
+    if (count == 0) {
+        result.errorFlag = true;
+        result.errorMessage = "Array is empty";
+        return false;
+    }
+
+    computeStats(data, count, result);
+    replaceRange(data, count, result.min, result.max, result.average);
+    return true;
+}
+
+std::vector<WorkUnit> planWorkUnits(const std::vector<BatchJob>& jobs, const BatchOptions& options) {
+    std::vector<WorkUnit> units;
+    WorkUnit pack = { 0, 0, true };
+    size_t packSize = 0;
+
+    for (size_t i = 0; i < jobs.size(); i++) {
+        size_t size = jobs[i].array.size();
+
+        if (size > options.smallArrayLimit) {
+            if (pack.last > pack.first) units.push_back(pack);
+            units.push_back({ i, i + 1, false });
+            pack = { i + 1, i + 1, true };
+            packSize = 0;
+            continue;
+        }
+
+        if (pack.last > pack.first && packSize + size > options.packElements) {
+            units.push_back(pack);
+            pack = { i, i, true };
+            packSize = 0;
+        }
+
+        pack.last = i + 1;
+        packSize += size;
+    }
+
+    if (pack.last > pack.first) units.push_back(pack);
+    return units;
+}
+
+// Small arrays of one unit are copied back to back into the worker's arena so the
+// whole pack is scanned from one contiguous block that stays hot in that core's cache.
+void runPackedUnit(const std::vector<BatchJob>& jobs, const WorkUnit& unit,
+    std::vector<int>& arena, std::vector<BatchResult>& results) {
+    arena.clear();
+    for (size_t j = unit.first; j < unit.last; j++) {
+        arena.insert(arena.end(), jobs[j].array.begin(), jobs[j].array.end());
+    }
+
+    size_t offset = 0;
+    for (size_t j = unit.first; j < unit.last; j++) {
+        size_t count = jobs[j].array.size();
+        int* segment = arena.data() + offset;
+
+        if (processInPlace(segment, count, results[j])) {
+            results[j].array.assign(segment, segment + count);
+        }
+        offset += count;
+    }
+}
+
+void runSingleUnit(const std::vector<BatchJob>& jobs, const WorkUnit& unit,
+    std::vector<BatchResult>& results) {
+    BatchResult& result = results[unit.first];
+    result.array = jobs[unit.first].array;
+
+    if (!processInPlace(result.array.data(), result.array.size(), result)) {
+        result.array.clear();
+    }
+}
+
+void batchWorker(const std::vector<BatchJob>& jobs, const std::vector<WorkUnit>& units,
+    std::atomic<size_t>& nextUnit, std::vector<BatchResult>& results,
+    ThreadTracer* tracer, const ThreadPlacement* placement, unsigned workerIndex, unsigned workers) {
+    // Pinning first means the arena and the result arrays this worker
+    // allocates are first touched, and so placed, on its own node.
+    if (placement) placement->Apply((int)workerIndex, (int)workers);
+
+    WorkerTrace trace(tracer, "batch " + std::to_string(workerIndex));
+    std::vector<int> arena;
+
+    for (;;) {
+        size_t u = nextUnit.fetch_add(1, std::memory_order_relaxed);
+        if (u >= units.size()) break;
+
+        const WorkUnit& unit = units[u];
+        try {
+            if (unit.packed) {
+                runPackedUnit(jobs, unit, arena, results);
+            }
+            else {
+                runSingleUnit(jobs, unit, results);
+            }
+        }
+        catch (const std::exception& e) {
+            for (size_t j = unit.first; j < unit.last; j++) {
+                results[j].errorFlag = true;
+                results[j].errorMessage = e.what();
+                results[j].array.clear();
+            }
+        }
+
+        if (tracer) {
+            size_t elements = 0;
+            for (size_t j = unit.first; j < unit.last; j++) elements += jobs[j].array.size();
+            trace.chunk(elements);
+        }
+    }
+}
+
+} // namespace
+
+BatchOptions defaultBatchOptions() {
+    BatchOptions options;
+    options.workers = 0;
+    options.smallArrayLimit = 4096;
+    options.packElements = 64 * 1024;
+    options.tracer = nullptr;
+    options.placement = nullptr;
+    return options;
+}
+
+std::vector<BatchJob> loadBatchDirectory(const std::string& path) {
+    namespace fs = std::filesystem;
+
+    if (!fs::is_directory(path)) {
+        throw std::runtime_error("Not a directory: " + path);
+    }
+
+    std::vector<fs::path> files;
+    for (const auto& entry : fs::directory_iterator(path)) {
+        if (entry.is_regular_file()) files.push_back(entry.path());
+    }
+    std::sort(files.begin(), files.end());
+
+    std::vector<BatchJob> jobs;
+    jobs.reserve(files.size());
+
+    for (const auto& file : files) {
+        std::ifstream in(file);
+        if (!in) {
+            throw std::runtime_error("Cannot open " + file.string());
+        }
+
+        BatchJob job;
+        job.name = file.filename().string();
+
+        int value;
+        while (in >> value) {
+            job.array.push_back(value);
+        }
+        if (!in.eof()) {
+            throw std::runtime_error("Invalid integer in " + file.string());
+        }
+
+        jobs.push_back(std::move(job));
+    }
+
+    return jobs;
+}
+
+std::vector<BatchJob> loadBatchStream(std::istream& in) {
+    std::vector<BatchJob> jobs;
+
+    for (;;) {
+        uint32_t count = 0;
+        in.read(reinterpret_cast<char*>(&count), sizeof(count));
+        if (in.gcount() == 0) break;
+        if (in.gcount() != sizeof(count)) {
+            throw std::runtime_error("Truncated frame header");
+        }
+        if (count > kMaxBatchArraySize) {
+            throw std::runtime_error("Frame too large: " + std::to_string(count) + " elements");
+        }
+
+        BatchJob job;
+        job.name = "#" + std::to_string(jobs.size());
+        job.array.resize(count);
+
+        std::streamsize bytes = static_cast<std::streamsize>(count * sizeof(int32_t));
+        in.read(reinterpret_cast<char*>(job.array.data()), bytes);
+        if (in.gcount() != bytes) {
+            throw std::runtime_error("Truncated frame " + job.name);
+        }
+
+        jobs.push_back(std::move(job));
+    }
+
+    return jobs;
+}
+
+void writeBatchFrame(std::ostream& out, const std::vector<int>& array) {
+    uint32_t count = static_cast<uint32_t>(array.size());
+    out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    out.write(reinterpret_cast<const char*>(array.data()), count * sizeof(int32_t));
+}
+
+std::vector<BatchResult> runBatch(const std::vector<BatchJob>& jobs, const BatchOptions& options) {
+    std::vector<BatchResult> results(jobs.size());
+    for (size_t i = 0; i < jobs.size(); i++) {
+        results[i].name = jobs[i].name;
+        results[i].min = 0;
+        results[i].max = 0;
+        results[i].average = 0.0;
+        results[i].errorFlag = false;
+    }
+
+    std::vector<WorkUnit> units = planWorkUnits(jobs, options);
+    if (units.empty()) return results;
+
+    unsigned workers = options.workers;
+    if (workers == 0) workers = std::max(1u, std::thread::hardware_concurrency());
+    workers = static_cast<unsigned>(std::min<size_t>(workers, units.size()));
+
+    std::atomic<size_t> nextUnit(0);
+    std::vector<std::thread> threads;
+    threads.reserve(workers);
+
+    for (unsigned i = 0; i < workers; i++) {
+        threads.emplace_back(batchWorker, std::cref(jobs), std::cref(units),
+            std::ref(nextUnit), std::ref(results), options.tracer, options.placement, i, workers);
+    }
+    for (auto& t : threads) t.join();
+
+    return results;
+}
+
+void writeBatchReport(std::ostream& out, const std::vector<BatchResult>& results) {
+    for (const auto& r : results) {
+        if (r.errorFlag) {
+            out << r.name << ": error: " << r.errorMessage << "\n";
+            continue;
+        }
+
+        out << r.name << ": min=" << r.min << " max=" << r.max
+            << " avg=" << r.average << " |";
+        for (int v : r.array) out << " " << v;
+        out << "\n";
+    }
+}
+
+void writeBatchResults(std::ostream& out, const std::vector<BatchResult>& results) {
+    for (const auto& r : results) {
+        uint32_t count = r.errorFlag ? 0 : static_cast<uint32_t>(r.array.size());
+        int32_t minVal = r.min;
+        int32_t maxVal = r.max;
+        double average = r.average;
+
+        out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+        out.write(reinterpret_cast<const char*>(&minVal), sizeof(minVal));
+        out.write(reinterpret_cast<const char*>(&maxVal), sizeof(maxVal));
+        out.write(reinterpret_cast<const char*>(&average), sizeof(average));
+        out.write(reinterpret_cast<const char*>(r.array.data()), count * sizeof(int32_t));
+    }
+}
@@ -0,0 +1,115 @@
+#include "parallel_lab.h"
+#include <algorithm>
+#ifndef PARALLEL_LAB_SEQUENTIAL
+#include <execution>
+#endif
+#include <functional>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+struct PartialStats {
+    int min;
+    int max;
+    long long sum;
+};
+
+PartialStats scanRange(const int* data, size_t count) {
+    PartialStats p = { data[0], data[0], 0 };
+    for (size_t i = 0; i < count; i++) {
+        p.min = std::min(p.min, data[i]);
+        p.max = std::max(p.max, data[i]);
+        p.sum += data[i];
+    }
+    return p;
+}
+
+void requireNonEmpty(const std::vector<int>& arr) {
+    if (arr.empty()) {
+        throw std::runtime_error("Array is empty");
+    }
+}
+
+} // namespace
+
+ArrayStats computeStatsParallel(const std::vector<int>& arr) {
+    requireNonEmpty(arr);
+
+#ifdef PARALLEL_LAB_SEQUENTIAL
+    auto minMax = std::minmax_element(arr.begin(), arr.end());
+    long long sum = std::transform_reduce(arr.begin(), arr.end(),
+        0LL, std::plus<>(), [](int v) { return static_cast<long long>(v); });
+#else
+    auto minMax = std::minmax_element(std::execution::par_unseq, arr.begin(), arr.end());
+    long long sum = std::transform_reduce(std::execution::par_unseq, arr.begin(), arr.end(),
+        0LL, std::plus<>(), [](int v) { return static_cast<long long>(v); });
+#endif
+
+    ArrayStats stats;
+    stats.min = *minMax.first;
+    stats.max = *minMax.second;
+    stats.average = static_cast<double>(sum) / arr.size();
+    return stats;
+}
+
+void replaceMinMaxWithAverageParallel(std::vector<int>& arr, int minVal, int maxVal, double avgVal) {
+    int replacement = static_cast<int>(avgVal);
+    auto replace = [=](int v) { return (v == minVal || v == maxVal) ? replacement : v; };
+#ifdef PARALLEL_LAB_SEQUENTIAL
+    std::transform(arr.begin(), arr.end(), arr.begin(), replace);
+#else
+    std::transform(std::execution::par_unseq, arr.begin(), arr.end(), arr.begin(), replace);
+#endif
+}
+
+ArrayStats computeStatsThreaded(const std::vector<int>& arr, unsigned threads) {
+    requireNonEmpty(arr);
+
+    if (threads == 0) threads = 1;
+    threads = static_cast<unsigned>(std::min<size_t>(threads, arr.size()));
+
+    std::vector<PartialStats> partials(threads);
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+
+    size_t chunk = arr.size() / threads;
+    size_t extra = arr.size() % threads;
+    size_t begin = 0;
+
+    for (unsigned t = 0; t < threads; t++) {
+        size_t count = chunk + (t < extra ? 1 : 0);
+        const int* data = arr.data() + begin;
+        workers.emplace_back([&partials, t, data, count]() {
+            partials[t] = scanRange(data, count);
+        });
+        begin += count;
+    }
+    for (auto& w : workers) w.join();
+
+    PartialStats total = partials[0];
+    for (unsigned t = 1; t < threads; t++) {
+        total.min = std::min(total.min, partials[t].min);
+        total.max = std::max(total.max, partials[t].max);
+        total.sum += partials[t].sum;
+    }
+
+    ArrayStats stats;
+    stats.min = total.min;
+    stats.max = total.max;
+    stats.average = static_cast<double>(total.sum) / arr.size();
+    return stats;
+}
+
+ArrayStats computeStatsSequential(const std::vector<int>& arr) {
+    requireNonEmpty(arr);
+
+    PartialStats p = scanRange(arr.data(), arr.size());
+
+    ArrayStats stats;
+    stats.min = p.min;
+    stats.max = p.max;
+    stats.average = static_cast<double>(p.sum) / arr.size();
+    return stats;
+}
@@ -1,11 +1,13 @@
 #define NOMINMAX
 #include "thread_lab.h"
-#include <windows.h>
 #include <vector>
 #include <iostream>
 #include <string>
 #include <limits>
+#include <cerrno>
+#include <cstring>
 
+#ifdef _WIN32
 std::string GetLastErrorAsString() {
     DWORD error = GetLastError();
     if (error == 0) return "No error";
@@ -19,6 +21,12 @@ std::string GetLastErrorAsString() {
     LocalFree(messageBuffer);
     return message;
 }
+#else
+std::string GetLastErrorAsString() {
+    if (errno == 0) return "No error";
+    return std::strerror(errno);
+}
+#endif
 
 void clearInput() {
     std::cin.clear();
@@ -39,6 +47,7 @@ void replaceMinMaxWithAverage(std::vector<int>& arr, int minVal, int maxVal, dou
 
 DWORD WINAPI min_max_thread(LPVOID lpParam) {
     ThreadData* data = static_cast<ThreadData*>(lpParam);
+    WorkerTrace trace(data->tracer, "min_max");
 
     try {
         if (data->array->empty()) {
@@ -57,7 +66,8 @@ DWORD WINAPI min_max_thread(LPVOID lpParam) {
             if ((*data->array)[i] > *data->max) {
                 *data->max = (*data->array)[i];
             }
-            Sleep(7);
+            trace.simulateWork(data->minMaxWorkUs);
+            trace.element();
         }
 
         return 0;
@@ -71,6 +81,7 @@ DWORD WINAPI min_max_thread(LPVOID lpParam) {
 
 DWORD WINAPI average_thread(LPVOID lpParam) {
     ThreadData* data = static_cast<ThreadData*>(lpParam);
+    WorkerTrace trace(data->tracer, "average");
 
     try {
         if (data->array->empty()) {
@@ -83,7 +94,8 @@ DWORD WINAPI average_thread(LPVOID lpParam) {
 
         for (size_t i = 0; i < data->array->size(); i++) {
             sum += (*data->array)[i];
-            Sleep(12);
+            trace.simulateWork(data->averageWorkUs);
+            trace.element();
         }
 
         *data->average = static_cast<double>(sum) / data->array->size();
@@ -0,0 +1,218 @@
+#include "thread_trace.h"
+#include <algorithm>
+#include <iomanip>
+#include <thread>
+
+namespace {
+
+const int kHistogramBuckets = 32;
+
+int bucketOf(int64_t ns) {
+    int64_t us = ns / 1000;
+    int bucket = 0;
+    while (us > 0 && bucket < kHistogramBuckets - 1) {
+        us >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+double toMs(int64_t ns) {
+    return ns / 1e6;
+}
+
+void writeJsonString(std::ostream& out, const std::string& text) {
+    out << '"';
+    for (char c : text) {
+        if (c == '"' || c == '\\') out << '\\';
+        out << c;
+    }
+    out << '"';
+}
+
+const char* spanName(TraceSpanKind kind) {
+    switch (kind) {
+    case TRACE_WORKER: return "worker";
+    case TRACE_CHUNK: return "chunk";
+    default: return "wait";
+    }
+}
+
+} // namespace
+
+ThreadTracer::ThreadTracer(size_t chunkElements)
+    : epoch(TraceClock::now()), chunk(chunkElements == 0 ? 1 : chunkElements) {
+}
+
+int64_t ThreadTracer::sinceEpochNs(TraceClock::time_point t) const {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(t - epoch).count();
+}
+
+WorkerTraceLog* ThreadTracer::registerWorker(const std::string& name) {
+    std::lock_guard<std::mutex> guard(registryLock);
+    workers.push_back(std::make_unique<WorkerTraceLog>());
+    workers.back()->name = name;
+    return workers.back().get();
+}
+
+void ThreadTracer::writeChromeTrace(std::ostream& out) const {
+    std::lock_guard<std::mutex> guard(registryLock);
+
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    auto separator = [&]() {
+        if (!first) out << ",";
+        out << "\n";
+        first = false;
+    };
+
+    out << std::fixed << std::setprecision(3);
+    for (size_t tid = 0; tid < workers.size(); tid++) {
+        const WorkerTraceLog& worker = *workers[tid];
+
+        separator();
+        out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid
+            << ",\"args\":{\"name\":";
+        writeJsonString(out, worker.name);
+        out << "}}";
+
+        for (const TraceSpan& span : worker.spans) {
+            separator();
+            out << "{\"name\":\"" << spanName(span.kind) << "\",\"cat\":";
+            writeJsonString(out, worker.name);
+            out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << tid
+                << ",\"ts\":" << span.startNs / 1000.0
+                << ",\"dur\":" << span.durationNs / 1000.0;
+            if (span.kind == TRACE_CHUNK) {
+                out << ",\"args\":{\"elements\":" << span.elements
+                    << ",\"wait_us\":" << span.waitNs / 1000.0 << "}";
+            }
+            out << "}";
+        }
+    }
+    out << "\n]}\n";
+    out.unsetf(std::ios::fixed);
+}
+
+void ThreadTracer::writeSummary(std::ostream& out) const {
+    std::lock_guard<std::mutex> guard(registryLock);
+
+    out << std::left << std::setw(12) << "worker"
+        << std::right << std::setw(12) << "wall_ms" << std::setw(12) << "busy_ms"
+        << std::setw(12) << "wait_ms" << std::setw(12) << "idle_ms"
+        << std::setw(10) << "chunks" << std::setw(12) << "elements" << "\n";
+
+    for (const auto& worker : workers) {
+        int64_t wall = 0, chunks = 0, wait = 0, chunkCount = 0;
+        size_t elements = 0;
+        std::vector<size_t> histogram(kHistogramBuckets, 0);
+
+        for (const TraceSpan& span : worker->spans) {
+            if (span.kind == TRACE_WORKER) {
+                wall += span.durationNs;
+            }
+            else if (span.kind == TRACE_CHUNK) {
+                chunks += span.durationNs;
+                wait += span.waitNs;
+                elements += span.elements;
+                chunkCount++;
+                histogram[bucketOf(span.durationNs)]++;
+            }
+            else {
+                wait += span.durationNs;
+            }
+        }
+
+        int64_t busy = chunks - std::min(chunks, wait);
+        int64_t idle = wall - std::min(wall, busy + wait);
+
+        out << std::left << std::setw(12) << worker->name << std::right << std::fixed
+            << std::setprecision(3)
+            << std::setw(12) << toMs(wall) << std::setw(12) << toMs(busy)
+            << std::setw(12) << toMs(wait) << std::setw(12) << toMs(idle)
+            << std::setw(10) << chunkCount << std::setw(12) << elements << "\n";
+        out.unsetf(std::ios::fixed);
+
+        if (chunkCount == 0) continue;
+
+        size_t peak = *std::max_element(histogram.begin(), histogram.end());
+        out << "  chunk duration histogram (us):\n";
+        for (int b = 0; b < kHistogramBuckets; b++) {
+            if (histogram[b] == 0) continue;
+            long long low = b == 0 ? 0 : 1LL << (b - 1);
+            long long high = 1LL << b;
+            size_t bar = std::max<size_t>(1, histogram[b] * 40 / peak);
+            out << "  [" << std::setw(8) << low << ", " << std::setw(8) << high << ") "
+                << std::setw(8) << histogram[b] << " " << std::string(bar, '#') << "\n";
+        }
+    }
+}
+
+WorkerTrace::WorkerTrace(ThreadTracer* tracer, const std::string& name)
+    : tracer(tracer), log(nullptr), chunkCount(0), chunkWaitNs(0) {
+    if (!tracer) return;
+
+    log = tracer->registerWorker(name);
+    workerStart = TraceClock::now();
+    chunkStart = workerStart;
+}
+
+WorkerTrace::~WorkerTrace() {
+    if (!tracer) return;
+
+    TraceClock::time_point now = TraceClock::now();
+    if (chunkCount > 0) closeChunk(now);
+
+    TraceSpan span = { TRACE_WORKER, tracer->sinceEpochNs(workerStart),
+        std::chrono::duration_cast<std::chrono::nanoseconds>(now - workerStart).count(), 0, 0 };
+    log->spans.push_back(span);
+}
+
+void WorkerTrace::element() {
+    if (!tracer) return;
+
+    if (++chunkCount >= tracer->chunkElements()) {
+        closeChunk(TraceClock::now());
+    }
+}
+
+void WorkerTrace::chunk(size_t elements) {
+    if (!tracer) return;
+
+    chunkCount += elements;
+    closeChunk(TraceClock::now());
+}
+
+void WorkerTrace::simulateWork(unsigned microseconds) {
+    if (microseconds == 0) return;
+
+    if (!tracer) {
+        std::this_thread::sleep_for(std::chrono::microseconds(microseconds));
+        return;
+    }
+
+    TraceClock::time_point start = TraceClock::now();
+    std::this_thread::sleep_for(std::chrono::microseconds(microseconds));
+    chunkWaitNs += std::chrono::duration_cast<std::chrono::nanoseconds>(TraceClock::now() - start).count();
+}
+
+void WorkerTrace::recordWait(TraceClock::time_point start) {
+    if (!tracer) return;
+
+    TraceClock::time_point now = TraceClock::now();
+    TraceSpan span = { TRACE_WAIT, tracer->sinceEpochNs(start),
+        std::chrono::duration_cast<std::chrono::nanoseconds>(now - start).count(), 0, 0 };
+    log->spans.push_back(span);
+    chunkStart = now;
+}
+
+void WorkerTrace::closeChunk(TraceClock::time_point now) {
+    TraceSpan span = { TRACE_CHUNK, tracer->sinceEpochNs(chunkStart),
+        std::chrono::duration_cast<std::chrono::nanoseconds>(now - chunkStart).count(),
+        chunkCount, chunkWaitNs };
+    log->spans.push_back(span);
+
+    chunkStart = now;
+    chunkCount = 0;
+    chunkWaitNs = 0;
+}
@@ -1,11 +1,136 @@
 #define NOMINMAX
 #include "thread_lab.h"
+#include "batch_lab.h"
 #include <iostream>
+#include <fstream>
+#include <filesystem>
 #include <vector>
 #include <windows.h>
+#include <io.h>
+#include <fcntl.h>
+
+static void writeTrace(const ThreadTracer& tracer, const std::string& path, std::ostream& summary) {
+    std::ofstream file(path);
+    if (!file) throw std::runtime_error("Cannot create " + path);
+    tracer.writeChromeTrace(file);
+
+    summary << "\nTrace written to " << path << std::endl;
+    tracer.writeSummary(summary);
+}
+
+static int runBatchMode(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::cerr << "Usage: ThreadLab --batch <directory|stream file|-> [--workers N] [--output file] [--binary] [--trace file]"
+            << " [--placement none|compact|scatter|numa]" << std::endl;
+        return 1;
+    }
 
-int main() {
+    std::string input = argv[2];
+    std::string output;
+    std::string tracePath;
+    bool binary = false;
+    BatchOptions options = defaultBatchOptions();
+    ThreadTracer tracer;
+    PlacementPolicy policy = PLACEMENT_NONE;
+
+    for (int i = 3; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--workers" && i + 1 < argc) {
+            options.workers = static_cast<unsigned>(std::stoul(argv[++i]));
+        }
+        else if (arg == "--output" && i + 1 < argc) {
+            output = argv[++i];
+        }
+        else if (arg == "--binary") {
+            binary = true;
+        }
+        else if (arg == "--trace" && i + 1 < argc) {
+            tracePath = argv[++i];
+            options.tracer = &tracer;
+        }
+        else if (arg == "--placement" && i + 1 < argc) {
+            std::string name = argv[++i];
+            if (!ParsePlacementPolicy(name, policy)) throw std::runtime_error("Unknown placement: " + name);
+        }
+        else {
+            throw std::runtime_error("Unknown batch option: " + arg);
+        }
+    }
+
+    std::vector<BatchJob> jobs;
+    if (input == "-") {
+        _setmode(_fileno(stdin), _O_BINARY);
+        jobs = loadBatchStream(std::cin);
+    }
+    else if (std::filesystem::is_directory(input)) {
+        jobs = loadBatchDirectory(input);
+    }
+    else {
+        std::ifstream in(input, std::ios::binary);
+        if (!in) throw std::runtime_error("Cannot open " + input);
+        jobs = loadBatchStream(in);
+    }
+
+    ThreadPlacement placement(policy, DiscoverTopology());
+    options.placement = &placement;
+    std::vector<BatchResult> results = runBatch(jobs, options);
+
+    std::ofstream file;
+    if (!output.empty()) {
+        file.open(output, binary ? std::ios::binary : std::ios::out);
+        if (!file) throw std::runtime_error("Cannot create " + output);
+    }
+    else if (binary) {
+        _setmode(_fileno(stdout), _O_BINARY);
+    }
+    std::ostream& out = output.empty() ? std::cout : file;
+
+    if (binary) {
+        writeBatchResults(out, results);
+    }
+    else {
+        writeBatchReport(out, results);
+    }
+
+    size_t failed = 0;
+    for (const auto& r : results) {
+        if (r.errorFlag) failed++;
+    }
+    std::cerr << "Processed " << results.size() << " arrays, " << failed << " failed ("
+        << placement.Describe() << ")" << std::endl;
+
+    if (!tracePath.empty()) writeTrace(tracer, tracePath, std::cerr);
+
+    return failed == 0 ? 0 : 1;
+}
+
+int main(int argc, char* argv[]) {
     try {
+        if (argc > 1 && std::string(argv[1]) == "--batch") {
+            return runBatchMode(argc, argv);
+        }
+
+        ThreadData data;
+        std::string tracePath;
+        ThreadTracer tracer(1);
+
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--min-max-work-us" && i + 1 < argc) {
+                data.minMaxWorkUs = static_cast<unsigned>(std::stoul(argv[++i]));
+            }
+            else if (arg == "--average-work-us" && i + 1 < argc) {
+                data.averageWorkUs = static_cast<unsigned>(std::stoul(argv[++i]));
+            }
+            else if (arg == "--trace" && i + 1 < argc) {
+                tracePath = argv[++i];
+                data.tracer = &tracer;
+            }
+            else {
+                throw std::runtime_error("Unknown option: " + arg);
+            }
+        }
+
         setlocale(LC_ALL, "Russian");
 
         int size;
@@ -29,7 +154,6 @@ int main() {
         bool errorFlag = false;
         std::string errorMessage;
 
-        ThreadData data;
         data.array = &arr;
         data.min = &minVal;
         data.max = &maxVal;
@@ -50,8 +174,13 @@ int main() {
 
         std::cout << "\nWaiting for threads to finish..." << std::endl;
 
-        WaitForSingleObject(hMinMax, INFINITE);
-        WaitForSingleObject(hAverage, INFINITE);
+        {
+            WorkerTrace mainTrace(data.tracer, "main");
+            TraceClock::time_point waitStart = TraceClock::now();
+            WaitForSingleObject(hMinMax, INFINITE);
+            WaitForSingleObject(hAverage, INFINITE);
+            mainTrace.recordWait(waitStart);
+        }
 
         if (errorFlag) {
             throw std::runtime_error("Thread error: " + errorMessage);
@@ -77,6 +206,8 @@ int main() {
         CloseHandle(hMinMax);
         CloseHandle(hAverage);
 
+        if (!tracePath.empty()) writeTrace(tracer, tracePath, std::cout);
+
         std::cout << "\nProgram completed successfully!" << std::endl;
     }
     catch (const std::exception& e) {
@@ -1,8 +1,10 @@
 #include "thread_lab.h"
+#include "batch_lab.h"
+#include "parallel_lab.h"
 #include <cassert>
 #include <iostream>
-#include <windows.h>
 #include <vector>
+#include <sstream>
 
 void test_array_validation() {
     std::cout << "\nTest 1: Array validation" << std::endl;
@@ -22,6 +24,7 @@ void test_array_validation() {
     std::cout << "PASSED" << std::endl;
 }
 
+#ifdef _WIN32
 void test_min_max_thread() {
     std::cout << "\nTest 2: min_max thread" << std::endl;
 
@@ -90,6 +93,8 @@ void test_average_thread() {
     std::cout << "PASSED" << std::endl;
 }
 
+#endif
+
 void test_replace_function() {
     std::cout << "\nTest 4: replace function" << std::endl;
 
@@ -109,6 +114,7 @@ void test_replace_function() {
     std::cout << "PASSED" << std::endl;
 }
 
+#ifdef _WIN32
 void test_error_handling() {
     std::cout << "\nTest 5: error handling" << std::endl;
 
@@ -141,14 +147,197 @@ void test_error_handling() {
     std::cout << "PASSED" << std::endl;
 }
 
+#endif
+
+void test_batch_processing() {
+    std::cout << "\nTest 6: batch processing" << std::endl;
+
+    std::vector<BatchJob> jobs(5000);
+    for (size_t i = 0; i < jobs.size(); i++) {
+        jobs[i].name = "#" + std::to_string(i);
+        jobs[i].array = { 1, static_cast<int>(i) + 10, 5 };
+    }
+    jobs[7].array.clear();
+    jobs[9].array.assign(10000, 4);
+    jobs[9].array[0] = 0;
+    jobs[9].array[1] = 8;
+
+    BatchOptions options = defaultBatchOptions();
+    options.workers = 4;
+    options.packElements = 64;
+    std::cout << "Input: 5000 arrays, 4 workers, one empty, one large" << std::endl;
+
+    std::vector<BatchResult> results = runBatch(jobs, options);
+    assert(results.size() == jobs.size());
+
+    for (size_t i = 0; i < results.size(); i++) {
+        assert(results[i].name == jobs[i].name);
+        if (i == 7 || i == 9) continue;
+
+        int top = static_cast<int>(i) + 10;
+        double avg = (1 + top + 5) / 3.0;
+        assert(!results[i].errorFlag);
+        assert(results[i].min == 1);
+        assert(results[i].max == top);
+        assert(results[i].average == avg);
+        std::vector<int> expected = { static_cast<int>(avg), static_cast<int>(avg), 5 };
+        assert(results[i].array == expected);
+    }
+
+    std::cout << "Output #7 error: " << results[7].errorMessage << " (expected: Array is empty)" << std::endl;
+    assert(results[7].errorFlag);
+
+    std::cout << "Output #9: min=" << results[9].min << " max=" << results[9].max
+        << " avg=" << results[9].average << " (expected: 0 8 4)" << std::endl;
+    assert(results[9].min == 0 && results[9].max == 8 && results[9].average == 4.0);
+    assert(results[9].array[0] == 4 && results[9].array[1] == 4);
+
+    ThreadPlacement placement(PLACEMENT_SCATTER, DiscoverTopology());
+    options.placement = &placement;
+    std::vector<BatchResult> placed = runBatch(jobs, options);
+    std::cout << "Output with " << placement.Describe() << ": " << placed.size() << " results" << std::endl;
+    for (size_t i = 0; i < placed.size(); i++) assert(placed[i].array == results[i].array);
+
+    std::cout << "PASSED" << std::endl;
+}
+
+void test_batch_stream() {
+    std::cout << "\nTest 7: batch framed stream" << std::endl;
+
+    std::stringstream stream;
+    writeBatchFrame(stream, { 3, -2, 7 });
+    writeBatchFrame(stream, { 42 });
+    std::cout << "Input: frames [3,-2,7] [42]" << std::endl;
+
+    std::vector<BatchJob> jobs = loadBatchStream(stream);
+    std::cout << "Output: " << jobs.size() << " jobs (expected: 2)" << std::endl;
+    assert(jobs.size() == 2);
+    assert((jobs[0].array == std::vector<int>{ 3, -2, 7 }));
+    assert((jobs[1].array == std::vector<int>{ 42 }));
+
+    std::stringstream truncated;
+    writeBatchFrame(truncated, { 1, 2, 3 });
+    std::string bytes = truncated.str();
+    truncated.str(bytes.substr(0, bytes.size() - 2));
+
+    bool thrown = false;
+    try {
+        loadBatchStream(truncated);
+    }
+    catch (const std::exception&) {
+        thrown = true;
+    }
+    std::cout << "Truncated frame rejected: " << thrown << " (expected: true)" << std::endl;
+    assert(thrown);
+
+    std::cout << "PASSED" << std::endl;
+}
+
+void test_parallel_backend() {
+    std::cout << "\nTest 8: parallel backend" << std::endl;
+
+    std::vector<int> arr(100000);
+    for (size_t i = 0; i < arr.size(); i++) {
+        arr[i] = static_cast<int>((i * 7919) % 1000) - 500;
+    }
+    arr[31337] = -9000;
+    arr[4242] = 9000;
+    std::cout << "Input: 100000 elements, min -9000 at 31337, max 9000 at 4242" << std::endl;
+
+    ArrayStats seq = computeStatsSequential(arr);
+    ArrayStats par = computeStatsParallel(arr);
+    ArrayStats thr = computeStatsThreaded(arr, 3);
+
+    std::cout << "Output par: min=" << par.min << " max=" << par.max << " avg=" << par.average << std::endl;
+    assert(seq.min == -9000 && seq.max == 9000);
+    assert(par.min == seq.min && par.max == seq.max && par.average == seq.average);
+    assert(thr.min == seq.min && thr.max == seq.max && thr.average == seq.average);
+
+    std::vector<int> expected = arr;
+    replaceMinMaxWithAverage(expected, seq.min, seq.max, seq.average);
+    replaceMinMaxWithAverageParallel(arr, par.min, par.max, par.average);
+    assert(arr == expected);
+
+    bool thrown = false;
+    try {
+        computeStatsParallel(std::vector<int>());
+    }
+    catch (const std::exception&) {
+        thrown = true;
+    }
+    std::cout << "Empty array rejected: " << thrown << " (expected: true)" << std::endl;
+    assert(thrown);
+
+    std::cout << "PASSED" << std::endl;
+}
+
+void test_trace_instrumentation() {
+    std::cout << "\nTest 9: trace instrumentation" << std::endl;
+
+    std::vector<int> arr(2500);
+    for (size_t i = 0; i < arr.size(); i++) arr[i] = static_cast<int>(i % 100);
+    std::cout << "Input: 2500 elements 0..99, no simulated work, chunk 1000" << std::endl;
+
+    int minVal, maxVal;
+    double avgVal;
+    bool errorFlag = false;
+    std::string errorMessage;
+    ThreadTracer tracer(1000);
+
+    ThreadData data;
+    data.array = &arr;
+    data.min = &minVal;
+    data.max = &maxVal;
+    data.average = &avgVal;
+    data.errorFlag = &errorFlag;
+    data.errorMessage = &errorMessage;
+    data.minMaxWorkUs = 0;
+    data.averageWorkUs = 0;
+    data.tracer = &tracer;
+
+    assert(min_max_thread(&data) == 0);
+    assert(average_thread(&data) == 0);
+    std::cout << "Output: min=" << minVal << " max=" << maxVal << " avg=" << avgVal
+        << " (expected: 0 99 49.5)" << std::endl;
+    assert(minVal == 0 && maxVal == 99 && avgVal == 49.5);
+
+    std::stringstream json;
+    tracer.writeChromeTrace(json);
+    std::string trace = json.str();
+    assert(trace.find("\"traceEvents\"") != std::string::npos);
+    assert(trace.find("\"name\":\"min_max\"") != std::string::npos);
+    assert(trace.find("\"name\":\"average\"") != std::string::npos);
+
+    size_t chunks = 0;
+    for (size_t pos = trace.find("\"chunk\""); pos != std::string::npos; pos = trace.find("\"chunk\"", pos + 1)) {
+        chunks++;
+    }
+    std::cout << "Output chunks: " << chunks << " (expected: 6)" << std::endl;
+    assert(chunks == 6);
+
+    std::stringstream summary;
+    tracer.writeSummary(summary);
+    assert(summary.str().find("histogram") != std::string::npos);
+
+    std::cout << "PASSED" << std::endl;
+}
+
 int main() {
     std::cout << "THREAD TESTS" << std::endl;
 
     test_array_validation();
+#ifdef _WIN32
     test_min_max_thread();
     test_average_thread();
+#endif
     test_replace_function();
+#ifdef _WIN32
     test_error_handling();
+#endif
+    test_batch_processing();
+    test_batch_stream();
+    test_parallel_backend();
+    test_trace_instrumentation();
 
     std::cout << "\nALL TESTS PASSED" << std::endl;
     return 0;
@@ -0,0 +1,202 @@
+#include "marker_engine.h"
+#include "sync_lab.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Prints CSV: engine,select,markers,size,width,median_ms,marked,marks_per_sec
+// Time runs from the start signal until every marker has reported itself blocked.
+// Every engine is the same RunMarker loop over an ObservableArray, driven by a
+// MarkerCoordinator; only the Sync and Select policies differ:
+//   mutex    - one ProfiledMutex for the whole array
+//   adaptive - one AdaptiveMutex (spin, then park)
+//   striped  - one spin lock per cache line of cells, claims of --width cells
+//   lockfree - compare_exchange on the cells
+//   random   - probe random cells, block after --block-after misses in a row
+//   index    - claim from a FreeCellIndex, block as soon as it runs empty
+
+namespace {
+
+struct BenchConfig {
+    size_t size = 4096;
+    std::vector<int> markerCounts = { 2, 4, 8, 16, 32, 64, 128, 256 };
+    std::vector<std::string> engines = { "mutex", "adaptive", "striped", "lockfree" };
+    std::vector<std::string> selects = { "random", "index" };
+    int width = 1;
+    int repeat = 3;
+    unsigned blockAfter = 0;  // 0 = 2 * size + 1, i.e. only once the array is nearly full
+};
+
+struct RunResult {
+    double ms;
+    size_t marked;
+};
+
+std::vector<std::string> splitList(const std::string& text) {
+    std::vector<std::string> items;
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ',')) items.push_back(item);
+    return items;
+}
+
+struct BenchShared {
+    ObservableArray* cells;
+    MarkerCoordinator* coordinator;
+    ProfiledMutex* mutex;
+    ProfiledAdaptiveMutex* adaptive;
+    StripedLockTable* locks;
+    FreeCellIndex* freeCells;
+    MarkerEngineKind engine;
+    size_t width;
+    unsigned blockAfter;
+};
+
+template<class Sync>
+void runWith(const BenchShared& s, int marker, OwnedCells& owned, Sync sync) {
+    CoordinatorControl control(*s.coordinator, marker);
+    MarkerSettings settings = { marker + 1, 0, s.blockAfter, false };
+
+    if (s.freeCells) {
+        IndexedCells select(*s.freeCells, marker + 1);
+        RunMarker(settings, sync, select, control, owned);
+    }
+    else {
+        RandomCells select(marker + 1, 0, s.cells->Size() - sync.Width() + 1);
+        RunMarker(settings, sync, select, control, owned);
+    }
+}
+
+void benchMarker(const BenchShared* s, int marker, OwnedCells* owned) {
+    switch (s->engine) {
+    case ENGINE_ADAPTIVE:
+        runWith(*s, marker, *owned, LockedSync<ObservableArray, ProfiledAdaptiveMutex>(*s->cells, *s->adaptive));
+        break;
+    case ENGINE_STRIPED:
+        runWith(*s, marker, *owned, StripedSync<ObservableArray>(*s->cells, *s->locks, s->width));
+        break;
+    case ENGINE_LOCKFREE:
+        runWith(*s, marker, *owned, AtomicSync<ObservableArray>(*s->cells));
+        break;
+    default:
+        runWith(*s, marker, *owned, LockedSync<ObservableArray, ProfiledMutex>(*s->cells, *s->mutex));
+        break;
+    }
+}
+
+RunResult runEngine(MarkerEngineKind engine, bool index, int markers, const BenchConfig& config) {
+    ObservableArray cells(config.size);
+    MarkerCoordinator coordinator(markers);
+    ProfiledMutex mutex("SyncBench.mutex");
+    ProfiledAdaptiveMutex adaptive("SyncBench.adaptive");
+    StripedLockTable locks(config.size);
+    std::unique_ptr<FreeCellIndex> freeCells;
+    if (index) freeCells.reset(new FreeCellIndex(config.size));
+
+    BenchShared shared = { &cells, &coordinator, &mutex, &adaptive, &locks, freeCells.get(), engine,
+        engine == ENGINE_STRIPED ? (size_t)config.width : 1,
+        config.blockAfter ? config.blockAfter : (unsigned)(config.size * 2 + 1) };
+
+    std::vector<OwnedCells> owned(markers);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < markers; i++) threads.emplace_back(benchMarker, &shared, i, &owned[i]);
+
+    auto begin = std::chrono::steady_clock::now();
+    coordinator.Start();
+    coordinator.WaitAllBlocked();
+    auto end = std::chrono::steady_clock::now();
+
+    RunResult result;
+    result.ms = std::chrono::duration<double, std::milli>(end - begin).count();
+    result.marked = 0;
+    for (const auto& o : owned) result.marked += o.size();
+
+    for (int i = 0; i < markers; i++) {
+        coordinator.Terminate(i);
+        threads[i].join();
+    }
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    BenchConfig config;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--size" && i + 1 < argc) {
+            config.size = static_cast<size_t>(std::stoull(argv[++i]));
+        }
+        else if (arg == "--markers" && i + 1 < argc) {
+            config.markerCounts.clear();
+            for (const auto& m : splitList(argv[++i])) config.markerCounts.push_back(std::stoi(m));
+        }
+        else if (arg == "--engines" && i + 1 < argc) {
+            config.engines = splitList(argv[++i]);
+        }
+        else if (arg == "--select" && i + 1 < argc) {
+            config.selects = splitList(argv[++i]);
+        }
+        else if (arg == "--width" && i + 1 < argc) {
+            config.width = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (arg == "--index") {
+            config.selects = { "index" };
+        }
+        else if (arg == "--block-after" && i + 1 < argc) {
+            config.blockAfter = static_cast<unsigned>(std::max(1, std::atoi(argv[++i])));
+        }
+        else if (arg == "--repeat" && i + 1 < argc) {
+            config.repeat = std::max(1, std::atoi(argv[++i]));
+        }
+        else {
+            std::cerr << "Usage: SyncBench [--size N] [--markers a,b,..]"
+                << " [--engines mutex,adaptive,striped,lockfree] [--select random,index]"
+                << " [--width N] [--block-after N] [--repeat N]" << std::endl;
+            return 1;
+        }
+    }
+
+    std::cout << "engine,select,markers,size,width,median_ms,marked,marks_per_sec" << std::endl;
+
+    for (const auto& name : config.engines) {
+        MarkerEngineKind engine;
+        if (!ParseMarkerEngine(name, engine)) {
+            std::cerr << "Unknown engine: " << name << std::endl;
+            return 1;
+        }
+        int width = engine == ENGINE_STRIPED ? config.width : 1;
+
+        for (const auto& select : config.selects) {
+            if (select != "random" && select != "index") {
+                std::cerr << "Unknown select: " << select << std::endl;
+                return 1;
+            }
+            // The index hands out single cells.
+            if (select == "index" && width > 1) continue;
+
+            for (int markers : config.markerCounts) {
+                std::vector<RunResult> runs;
+                for (int r = 0; r < config.repeat; r++) {
+                    runs.push_back(runEngine(engine, select == "index", markers, config));
+                }
+                std::sort(runs.begin(), runs.end(),
+                    [](const RunResult& a, const RunResult& b) { return a.ms < b.ms; });
+
+                const RunResult& median = runs[runs.size() / 2];
+                double rate = median.ms > 0 ? median.marked / (median.ms / 1000.0) : 0.0;
+                std::cout << name << "," << select << "," << markers << "," << config.size << ","
+                    << width << "," << median.ms << "," << median.marked << "," << rate << std::endl;
+            }
+        }
+    }
+
+    return 0;
+}
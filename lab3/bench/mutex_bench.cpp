@@ -0,0 +1,143 @@
+#include "adaptive_mutex.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Prints CSV: mutex,threads,oversubscription,hold_ns,ops,median_ms,mops_per_sec
+// Every thread repeats lock / busy-wait hold_ns / unlock / busy-wait outside_ns
+// until the run's ops are used up. oversubscription = threads / hardware threads.
+//   std      - std::mutex (SRWLOCK on Windows, a futex mutex in glibc)
+//   adaptive - AdaptiveMutex, spin with learned budget then park
+
+namespace {
+
+struct BenchConfig {
+    std::vector<std::string> mutexes = { "std", "adaptive" };
+    std::vector<int> threadCounts;
+    std::vector<long> holdNs = { 0, 100, 1000, 10000 };
+    long outsideNs = 200;
+    long ops = 200000;
+    int repeat = 3;
+};
+
+std::vector<std::string> splitList(const std::string& text) {
+    std::vector<std::string> items;
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ',')) items.push_back(item);
+    return items;
+}
+
+void busyWait(long ns) {
+    if (ns <= 0) return;
+    auto until = std::chrono::steady_clock::now() + std::chrono::nanoseconds(ns);
+    while (std::chrono::steady_clock::now() < until) {}
+}
+
+template<typename Mutex>
+double runOnce(int threads, long holdNs, const BenchConfig& config) {
+    Mutex mutex;
+    long long counter = 0;
+    long perThread = std::max(1L, config.ops / threads);
+    std::vector<std::thread> workers;
+
+    auto begin = std::chrono::steady_clock::now();
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&]() {
+            for (long i = 0; i < perThread; i++) {
+                mutex.lock();
+                counter++;
+                busyWait(holdNs);
+                mutex.unlock();
+                busyWait(config.outsideNs);
+            }
+        });
+    }
+    for (auto& w : workers) w.join();
+    auto end = std::chrono::steady_clock::now();
+
+    if (counter != (long long)perThread * threads) {
+        std::cerr << "Lost updates: " << counter << std::endl;
+        std::exit(1);
+    }
+    return std::chrono::duration<double, std::milli>(end - begin).count();
+}
+
+double runMedian(const std::string& mutex, int threads, long holdNs, const BenchConfig& config) {
+    std::vector<double> runs;
+    for (int r = 0; r < config.repeat; r++) {
+        runs.push_back(mutex == "adaptive"
+            ? runOnce<AdaptiveMutex>(threads, holdNs, config)
+            : runOnce<std::mutex>(threads, holdNs, config));
+    }
+    std::sort(runs.begin(), runs.end());
+    return runs[runs.size() / 2];
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    BenchConfig config;
+    int hardware = std::max(1u, std::thread::hardware_concurrency());
+    config.threadCounts = { 1, 2, 4, hardware, hardware * 2, hardware * 4 };
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--mutexes" && i + 1 < argc) {
+            config.mutexes = splitList(argv[++i]);
+        }
+        else if (arg == "--threads" && i + 1 < argc) {
+            config.threadCounts.clear();
+            for (const auto& t : splitList(argv[++i])) config.threadCounts.push_back(std::max(1, std::stoi(t)));
+        }
+        else if (arg == "--hold-ns" && i + 1 < argc) {
+            config.holdNs.clear();
+            for (const auto& h : splitList(argv[++i])) config.holdNs.push_back(std::stol(h));
+        }
+        else if (arg == "--outside-ns" && i + 1 < argc) {
+            config.outsideNs = std::atol(argv[++i]);
+        }
+        else if (arg == "--ops" && i + 1 < argc) {
+            config.ops = std::max(1L, std::atol(argv[++i]));
+        }
+        else if (arg == "--repeat" && i + 1 < argc) {
+            config.repeat = std::max(1, std::atoi(argv[++i]));
+        }
+        else {
+            std::cerr << "Usage: MutexBench [--mutexes std,adaptive] [--threads a,b,..] [--hold-ns a,b,..]"
+                << " [--outside-ns N] [--ops N] [--repeat N]" << std::endl;
+            return 1;
+        }
+    }
+
+    std::sort(config.threadCounts.begin(), config.threadCounts.end());
+    config.threadCounts.erase(std::unique(config.threadCounts.begin(), config.threadCounts.end()),
+        config.threadCounts.end());
+
+    std::cout << "mutex,threads,oversubscription,hold_ns,ops,median_ms,mops_per_sec" << std::endl;
+
+    for (const auto& mutex : config.mutexes) {
+        if (mutex != "std" && mutex != "adaptive") {
+            std::cerr << "Unknown mutex: " << mutex << std::endl;
+            return 1;
+        }
+
+        for (long hold : config.holdNs) {
+            for (int threads : config.threadCounts) {
+                double ms = runMedian(mutex, threads, hold, config);
+                long ops = std::max(1L, config.ops / threads) * threads;
+                std::cout << mutex << "," << threads << "," << (double)threads / hardware << ","
+                    << hold << "," << ops << "," << ms << "," << (ms > 0 ? ops / (ms * 1000.0) : 0.0)
+                    << std::endl;
+            }
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>
+inline void CpuRelax() { _mm_pause(); }
+#elif defined(__aarch64__) || defined(__arm__)
+inline void CpuRelax() { __asm__ __volatile__("yield"); }
+#else
+inline void CpuRelax() {}
+#endif
+
+// Spin-then-park mutex. A contended lock() first spins with exponential
+// backoff (CpuRelax between probes) for at most the lock's spin budget, then
+// parks on the state word with a futex. The budget follows a running average
+// of recent hold times (one acquisition in 16 is timed): a waiter spins for
+// about twice the average hold, for holds up to kParkHoldNs (50 us). A 100 ns
+// hold gets only the kMinSpin floor; holds over 50 us, such as SyncLab's
+// sleeping simulated work, park almost at once.
+//
+// State word: 0 = free, 1 = locked, 2 = locked and somebody may be parked.
+class AdaptiveMutex {
+public:
+    AdaptiveMutex() : state(0), spinBudget(kInitialSpin), acquisitions(0), acquiredAt(0), holdAverageNs(0) {}
+
+    AdaptiveMutex(const AdaptiveMutex&) = delete;
+    AdaptiveMutex& operator=(const AdaptiveMutex&) = delete;
+
+    void lock() {
+        uint32_t expected = 0;
+        if (!state.compare_exchange_strong(expected, 1, std::memory_order_acquire)) LockSlow();
+        Acquired();
+    }
+
+    bool try_lock() {
+        uint32_t expected = 0;
+        if (!state.compare_exchange_strong(expected, 1, std::memory_order_acquire)) return false;
+        Acquired();
+        return true;
+    }
+
+    void unlock();
+
+    // Pause iterations a waiter currently spends before parking.
+    uint32_t SpinBudget() const { return spinBudget.load(std::memory_order_relaxed); }
+
+    static constexpr uint32_t kMinSpin = 16;
+    static constexpr uint32_t kInitialSpin = 512;
+    static constexpr uint32_t kMaxSpin = 1 << 14;
+
+private:
+    static int64_t Now();
+    void LockSlow();
+    void Acquired() { acquiredAt = (++acquisitions & 15) == 0 ? Now() : 0; }
+    void LearnHold();
+
+    std::atomic<uint32_t> state;
+    std::atomic<uint32_t> spinBudget;
+    uint32_t acquisitions;  // holder only
+    int64_t acquiredAt;     // holder only, 0 when this hold is not timed
+    int64_t holdAverageNs;  // holder only
+};
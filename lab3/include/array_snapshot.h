@@ -0,0 +1,62 @@
+#pragma once
+
+#include "cache_aligned.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+struct ArraySnapshot {
+    std::vector<int> cells;
+    std::vector<size_t> owned;  // owned[id] = cells holding id, owned[0] = free cells
+    bool consistent;            // false: each stripe is consistent on its own
+    unsigned attempts;
+};
+
+// Marker array readable while markers keep writing. Every stripe of cells has a
+// sequence word (seqlock): the low half counts writes in progress, the high
+// half counts finished writes. An observer copies stripes without taking any
+// lock and retries only the stripes that were busy or changed under it.
+// Because writers only add to the word, they need no serialisation of their
+// own, so lock-free markers (CompareAndSet) keep snapshots consistent too.
+class ObservableArray {
+public:
+    // With initialize = false the cells are allocated but not written, and the
+    // caller zeroes them with InitializeRange, e.g. from threads pinned to the
+    // NUMA node that should own each part (first touch places the pages).
+    explicit ObservableArray(size_t cells, size_t cellsPerStripe = kCacheLine / sizeof(int),
+        bool initialize = true);
+
+    ObservableArray(const ObservableArray&) = delete;
+    ObservableArray& operator=(const ObservableArray&) = delete;
+
+    size_t Size() const { return size; }
+    size_t StripeCount() const { return stripes.size(); }
+    int Get(size_t cell) const { return cells[cell].load(std::memory_order_relaxed); }
+    void Set(size_t cell, int value);
+    bool CompareAndSet(size_t cell, int expected, int value);
+    void InitializeRange(size_t first, size_t last);
+    // Zeroes the cells of `mask` in [first, first + 64), one stripe write each.
+    void ClearMasked(size_t first, uint64_t mask);
+
+    // Copies every stripe, then checks that no stripe changed since it was
+    // copied; if one did, starts over up to `attempts` times. The result is
+    // a state the whole array really had, or per-stripe consistent if the
+    // attempts ran out. Ownership counts cover marker ids 1..markers.
+    void Snapshot(ArraySnapshot& out, int markers, unsigned attempts = 8) const;
+
+private:
+    struct alignas(kCacheLine) Stripe {
+        std::atomic<uint64_t> sequence;
+    };
+
+    uint64_t CopyStripe(size_t stripe, int* out) const;
+    std::atomic<uint64_t>& BeginWrite(size_t cell);
+    static void EndWrite(std::atomic<uint64_t>& sequence);
+
+    size_t size;
+    size_t cellsPerStripe;
+    std::unique_ptr<std::atomic<int>[]> cells;  // default-initialised: no page is touched
+    std::vector<Stripe, CacheAlignedAllocator<Stripe>> stripes;
+};
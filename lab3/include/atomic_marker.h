@@ -0,0 +1,24 @@
+#pragma once
+
+#include "free_cell_index.h"
+#include "owned_cells.h"
+#include "sync_event.h"
+#include <atomic>
+#include <vector>
+
+// Lock-free marker: cells are claimed with compare_exchange (0 -> id) and
+// released with plain stores, so markers never serialize on a shared lock.
+struct AtomicMarkerData {
+    int id;
+    std::vector<std::atomic<int>>* array;
+    OwnedCells markedIndices;  // ownership bitmap, sized by the engine
+    Event* startEvent;
+    Event* stopEvent;
+    Event* continueEvent;
+    Event* terminateEvent;
+    unsigned workUs;   // simulated work per mark, in place of the two Sleep(5) calls
+    bool verbose;
+    FreeCellIndex* freeCells = nullptr;  // claim from the index instead of probing
+};
+
+void atomic_marker_thread(AtomicMarkerData* data);
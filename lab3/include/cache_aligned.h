@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+const size_t kCacheLine = 64;
+
+template<typename T>
+struct CacheAlignedAllocator {
+    typedef T value_type;
+
+    CacheAlignedAllocator() = default;
+    template<typename U>
+    CacheAlignedAllocator(const CacheAlignedAllocator<U>&) {}
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(kCacheLine)));
+    }
+
+    void deallocate(T* p, size_t) {
+        ::operator delete(p, std::align_val_t(kCacheLine));
+    }
+
+    template<typename U>
+    bool operator==(const CacheAlignedAllocator<U>&) const { return true; }
+    template<typename U>
+    bool operator!=(const CacheAlignedAllocator<U>&) const { return false; }
+};
+
+typedef std::vector<int, CacheAlignedAllocator<int>> AlignedArray;
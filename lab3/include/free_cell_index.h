@@ -0,0 +1,39 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Concurrent hierarchical bitmap of free cells. Level 0 has one bit per cell
+// (1 = free); every higher level has one bit per word of the level below
+// (1 = that word may still have free bits), up to a single top word. A claim
+// descends from the top picking a random set bit per level, so it costs
+// O(log64 n) word operations no matter how full the array is.
+class FreeCellIndex {
+public:
+    explicit FreeCellIndex(size_t cells);
+
+    FreeCellIndex(const FreeCellIndex&) = delete;
+    FreeCellIndex& operator=(const FreeCellIndex&) = delete;
+
+    size_t Size() const { return cells; }
+    size_t FreeCount() const { return freeCount.load(); }
+
+    // Claims a free cell chosen with the given random value. Returns -1 only
+    // once FreeCount() is 0; a claim racing a release retries until then.
+    long ClaimRandom(uint64_t random);
+    bool Claim(size_t cell);
+    void Release(size_t cell);
+    // Releases the cells of `mask` in the level-0 word starting at `first`
+    // (a multiple of 64) with one fetch_or.
+    void ReleaseMask(size_t first, uint64_t mask);
+
+private:
+    void clearUp(size_t level, size_t word);
+    void setUp(size_t level, size_t word);
+
+    size_t cells;
+    std::vector<std::vector<std::atomic<uint64_t>>> levels;
+    std::atomic<size_t> freeCount;
+};
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Thin wrappers over the OS address-wait primitive: futex(2) on Linux,
+// WaitOnAddress on Windows. Callers keep their own fast path and only come
+// here when they actually have to sleep or someone is known to be sleeping.
+
+// Sleeps while *word == expected. May return spuriously.
+void FutexWait(std::atomic<uint32_t>* word, uint32_t expected);
+void FutexWakeOne(std::atomic<uint32_t>* word);
+void FutexWakeAll(std::atomic<uint32_t>* word);
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <mutex>
+#include <ostream>
+
+// Lock contention profiler, compiled in with -DSYNC_LOCK_PROFILE=ON. Every
+// ProfiledLock acquisition records its wait time, hold time and whether it
+// had to wait into a buffer owned by the calling thread, so recording takes no
+// shared lock. The report (per lock, per thread, log2 histograms) goes to
+// stderr when the program exits; if LOCK_PROFILE_FOLDED names a file, the
+// same data is also written there as folded stacks for flamegraph.pl.
+// Without the option ProfiledLock is the bare mutex and the profiler calls are
+// empty inline functions.
+
+#ifdef SYNC_LOCK_PROFILE
+
+#include <chrono>
+#include <cstdint>
+
+class LockProfiler {
+public:
+    static int RegisterLock(const char* name);
+    // Names the calling thread in the report ("marker 3"); unnamed threads
+    // are reported as "thread N".
+    static void SetThreadName(const char* prefix, int index);
+
+    static void RecordAcquire(int lock, int64_t waitNs, bool contended);
+    static void RecordRelease(int lock, int64_t holdNs);
+
+    // Call only when the profiled threads are idle or joined.
+    static void WriteReport(std::ostream& out);
+    static void WriteFolded(std::ostream& out);
+
+    static int64_t Now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+};
+
+template <class Mutex>
+class ProfiledLock {
+public:
+    explicit ProfiledLock(const char* name) : id(LockProfiler::RegisterLock(name)), acquiredAt(0) {}
+
+    ProfiledLock(const ProfiledLock&) = delete;
+    ProfiledLock& operator=(const ProfiledLock&) = delete;
+
+    void lock() {
+        if (mutex.try_lock()) {
+            acquiredAt = LockProfiler::Now();
+            LockProfiler::RecordAcquire(id, 0, false);
+            return;
+        }
+
+        int64_t start = LockProfiler::Now();
+        mutex.lock();
+        acquiredAt = LockProfiler::Now();
+        LockProfiler::RecordAcquire(id, acquiredAt - start, true);
+    }
+
+    bool try_lock() {
+        if (!mutex.try_lock()) return false;
+        acquiredAt = LockProfiler::Now();
+        LockProfiler::RecordAcquire(id, 0, false);
+        return true;
+    }
+
+    void unlock() {
+        int64_t hold = LockProfiler::Now() - acquiredAt;
+        mutex.unlock();
+        LockProfiler::RecordRelease(id, hold);
+    }
+
+private:
+    Mutex mutex;
+    int id;
+    int64_t acquiredAt;  // written and read only by the holder
+};
+
+#else
+
+class LockProfiler {
+public:
+    static void SetThreadName(const char*, int) {}
+    static void WriteReport(std::ostream&) {}
+    static void WriteFolded(std::ostream&) {}
+};
+
+template <class Mutex>
+class ProfiledLock {
+public:
+    explicit ProfiledLock(const char*) {}
+
+    ProfiledLock(const ProfiledLock&) = delete;
+    ProfiledLock& operator=(const ProfiledLock&) = delete;
+
+    void lock() { mutex.lock(); }
+    bool try_lock() { return mutex.try_lock(); }
+    void unlock() { mutex.unlock(); }
+
+private:
+    Mutex mutex;
+};
+
+#endif
+
+typedef ProfiledLock<std::mutex> ProfiledMutex;
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "cache_aligned.h"
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+enum MarkerCommand : uint32_t {
+    MARKER_RUNNING = 0,
+    MARKER_BLOCKED = 1,
+    MARKER_SLEEPING = 2,   // blocked and parked on its command word
+    MARKER_CONTINUE = 3,
+    MARKER_TERMINATE = 4
+};
+
+// Start / "all blocked" / resume / terminate protocol for any number of markers
+// without one kernel object per marker. Markers report themselves blocked on a
+// shared counter the controller sleeps on, and each marker parks on its own
+// cache-line-sized command word, so only markers that actually sleep cost a wake.
+class MarkerCoordinator {
+public:
+    explicit MarkerCoordinator(int markers);
+
+    MarkerCoordinator(const MarkerCoordinator&) = delete;
+    MarkerCoordinator& operator=(const MarkerCoordinator&) = delete;
+
+    // Marker side; markers are numbered from 0.
+    void WaitStart();
+    // Blocks until the controller answers; returns MARKER_CONTINUE or MARKER_TERMINATE.
+    MarkerCommand Block(int marker);
+
+    // Controller side.
+    void Start();
+    void WaitAllBlocked();
+    void ResumeAll();
+    // The marker must be blocked; it leaves the active set immediately.
+    void Terminate(int marker);
+
+    int Markers() const { return (int)slots.size(); }
+    int Active() const { return (int)active.load(); }
+    bool IsActive(int marker) const { return slots[marker].alive; }
+
+private:
+    struct alignas(kCacheLine) Slot {
+        std::atomic<uint32_t> command;
+        bool alive;  // controller-owned
+    };
+
+    void Send(int marker, MarkerCommand command);
+
+    std::vector<Slot, CacheAlignedAllocator<Slot>> slots;
+    alignas(kCacheLine) std::atomic<uint32_t> blocked;
+    alignas(kCacheLine) std::atomic<uint32_t> active;
+    alignas(kCacheLine) std::atomic<uint32_t> started;
+};
@@ -0,0 +1,353 @@
+#pragma once
+
+#include "array_snapshot.h"
+#include "cache_aligned.h"
+#include "free_cell_index.h"
+#include "marker_coordinator.h"
+#include "owned_cells.h"
+#include "striped_lock.h"
+#include "sync_event.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// One marker loop for every variant. RunMarker is templated on three small
+// policy classes, so each combination compiles to its own straight-line code:
+//   Sync    - how a cell is claimed and released (one lock, stripe locks, CAS)
+//   Select  - which cell to try next (random probing, FreeCellIndex)
+//   Control - how the marker reports itself blocked and learns what to do next
+//             (Win32-style events, MarkerCoordinator)
+//
+// Sync:    size_t Size() const; size_t Width() const;
+//          bool TryClaim(size_t cell, int id, unsigned workUs, OwnedCells& owned);
+//          template<class F> void Release(const OwnedCells& owned, F released);
+//                                   // released(first, mask) per cleared 64-cell word
+// Select:  long Next();             // -1: nothing left to try, block now
+//          void Released(size_t first, uint64_t mask);
+// Control: void WaitStart();  bool Block();   // true = terminate
+
+// Cell access for the array types the Sync policies accept.
+inline int CellGet(const std::vector<int>& a, size_t i) { return a[i]; }
+inline void CellSet(std::vector<int>& a, size_t i, int v) { a[i] = v; }
+inline int CellGet(const AlignedArray& a, size_t i) { return a[i]; }
+inline void CellSet(AlignedArray& a, size_t i, int v) { a[i] = v; }
+inline int CellGet(const ObservableArray& a, size_t i) { return a.Get(i); }
+inline void CellSet(ObservableArray& a, size_t i, int v) { a.Set(i, v); }
+
+inline int CellGet(const std::vector<std::atomic<int>>& a, size_t i) {
+    return a[i].load(std::memory_order_acquire);
+}
+inline void CellSet(std::vector<std::atomic<int>>& a, size_t i, int v) {
+    a[i].store(v, std::memory_order_release);
+}
+inline bool CellCompareAndSet(std::vector<std::atomic<int>>& a, size_t i, int expected, int v) {
+    return a[i].compare_exchange_strong(expected, v, std::memory_order_acq_rel);
+}
+inline bool CellCompareAndSet(ObservableArray& a, size_t i, int expected, int v) {
+    return a.CompareAndSet(i, expected, v);
+}
+
+// Zeroes the cells of `mask` in the 64-cell word starting at `first`. The
+// plain-int loop has no branch on the mask, so it compiles to a masked vector
+// blend instead of up to 64 separate stores.
+inline void ClearMaskedInts(int* cells, size_t count, uint64_t mask) {
+    for (size_t j = 0; j < count; j++) cells[j] = (mask >> j) & 1 ? 0 : cells[j];
+}
+inline void CellClearMasked(std::vector<int>& a, size_t first, uint64_t mask) {
+    ClearMaskedInts(a.data() + first, std::min<size_t>(64, a.size() - first), mask);
+}
+inline void CellClearMasked(AlignedArray& a, size_t first, uint64_t mask) {
+    ClearMaskedInts(a.data() + first, std::min<size_t>(64, a.size() - first), mask);
+}
+inline void CellClearMasked(ObservableArray& a, size_t first, uint64_t mask) {
+    a.ClearMasked(first, mask);
+}
+inline void CellClearMasked(std::vector<std::atomic<int>>& a, size_t first, uint64_t mask) {
+    for (; mask; mask &= mask - 1) a[first + LowestSetBit(mask)].store(0, std::memory_order_release);
+}
+
+inline size_t CellCount(const ObservableArray& a) { return a.Size(); }
+template<class Array>
+size_t CellCount(const Array& a) { return a.size(); }
+
+inline void SimulateWork(unsigned workUs) {
+    if (workUs) std::this_thread::sleep_for(std::chrono::microseconds(workUs));
+}
+
+inline long long MarkerClockNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// ---- Sync policies
+
+// Every claim and release under one lock; the work is simulated before and
+// after the write, inside the lock, like the original Sleep(5) pair. Release
+// gives the lock up every kReleaseWords words of the ownership bitmap, so a
+// marker holding a large array stalls the others for a bounded time only.
+template<class Array, class Lock>
+class LockedSync {
+public:
+    static constexpr size_t kReleaseWords = 16;  // 1024 cells per lock hold
+
+    LockedSync(Array& array, Lock& lock) : array(array), lock(lock) {}
+
+    size_t Size() const { return CellCount(array); }
+    size_t Width() const { return 1; }
+
+    bool TryClaim(size_t cell, int id, unsigned workUs, OwnedCells& owned) {
+        lock.lock();
+        bool free = CellGet(array, cell) == 0;
+        if (free) {
+            SimulateWork(workUs);
+            CellSet(array, cell, id);
+            SimulateWork(workUs);
+            owned.push_back((int)cell);
+        }
+        lock.unlock();
+        return free;
+    }
+
+    template<class F>
+    void Release(const OwnedCells& owned, F released) {
+        size_t words = owned.WordCount();
+        size_t w = 0;
+
+        while (w < words) {
+            if (!owned.Word(w)) {
+                w++;
+                continue;
+            }
+
+            lock.lock();
+            for (size_t end = std::min(words, w + kReleaseWords); w < end; w++) {
+                uint64_t mask = owned.Word(w);
+                if (!mask) continue;
+                CellClearMasked(array, w * 64, mask);
+                released(w * 64, mask);
+            }
+            lock.unlock();
+        }
+    }
+
+private:
+    Array& array;
+    Lock& lock;
+};
+
+// Locks only the stripes covering a claim of `width` adjacent cells.
+template<class Array>
+class StripedSync {
+public:
+    StripedSync(Array& array, StripedLockTable& locks, size_t width)
+        : array(array), locks(locks), width(std::max<size_t>(1, std::min(width, CellCount(array)))) {}
+
+    size_t Size() const { return CellCount(array); }
+    size_t Width() const { return width; }
+
+    bool TryClaim(size_t cell, int id, unsigned workUs, OwnedCells& owned) {
+        locks.LockRange(cell, width);
+
+        bool free = true;
+        for (size_t i = cell; i < cell + width && free; i++) {
+            free = CellGet(array, i) == 0;
+        }
+
+        if (free) {
+            SimulateWork(workUs);
+            for (size_t i = cell; i < cell + width; i++) {
+                CellSet(array, i, id);
+                owned.push_back((int)i);
+            }
+            SimulateWork(workUs);
+        }
+
+        locks.UnlockRange(cell, width);
+        return free;
+    }
+
+    // One bitmap word at a time, holding only the stripes between its lowest
+    // and highest owned cell (taken in ascending order, as claims do).
+    template<class F>
+    void Release(const OwnedCells& owned, F released) {
+        for (size_t w = 0; w < owned.WordCount(); w++) {
+            uint64_t mask = owned.Word(w);
+            if (!mask) continue;
+
+            size_t first = w * 64 + LowestSetBit(mask);
+            size_t count = HighestSetBit(mask) - LowestSetBit(mask) + 1;
+            locks.LockRange(first, count);
+            CellClearMasked(array, w * 64, mask);
+            released(w * 64, mask);
+            locks.UnlockRange(first, count);
+        }
+    }
+
+private:
+    Array& array;
+    StripedLockTable& locks;
+    size_t width;
+};
+
+// compare_exchange 0 -> id; no lock anywhere. The work is simulated after the
+// claim since there is nothing to hold.
+template<class Array>
+class AtomicSync {
+public:
+    explicit AtomicSync(Array& array) : array(array) {}
+
+    size_t Size() const { return CellCount(array); }
+    size_t Width() const { return 1; }
+
+    bool TryClaim(size_t cell, int id, unsigned workUs, OwnedCells& owned) {
+        if (!CellCompareAndSet(array, cell, 0, id)) return false;
+        SimulateWork(workUs);
+        owned.push_back((int)cell);
+        return true;
+    }
+
+    template<class F>
+    void Release(const OwnedCells& owned, F released) {
+        for (size_t w = 0; w < owned.WordCount(); w++) {
+            uint64_t mask = owned.Word(w);
+            if (!mask) continue;
+            CellClearMasked(array, w * 64, mask);
+            released(w * 64, mask);
+        }
+    }
+
+private:
+    Array& array;
+};
+
+// ---- Select policies
+
+// Uniform random probing of claim positions [first, last).
+class RandomCells {
+public:
+    RandomCells(unsigned seed, size_t first, size_t last)
+        : rng(seed), first(first), span(last > first ? last - first : 1) {}
+
+    long Next() { return (long)(first + rng() % span); }
+    void Released(size_t, uint64_t) {}
+
+private:
+    std::minstd_rand rng;
+    size_t first;
+    size_t span;
+};
+
+// Claims a free cell from a shared FreeCellIndex; single-cell claims only.
+class IndexedCells {
+public:
+    IndexedCells(FreeCellIndex& index, unsigned seed) : index(index), rng(seed) {}
+
+    long Next() { return index.ClaimRandom(((uint64_t)rng() << 32) ^ rng()); }
+    void Released(size_t first, uint64_t mask) { index.ReleaseMask(first, mask); }
+
+private:
+    FreeCellIndex& index;
+    std::minstd_rand rng;
+};
+
+// ---- Control policies
+
+// Per-marker stop/terminate events and a shared continue event.
+class EventControl {
+public:
+    EventControl(Event* start, Event* stop, Event* cont, Event* terminate)
+        : start(start), stop(stop), cont(cont), terminate(terminate) {}
+
+    void WaitStart() { start->Wait(); }
+    bool Block();
+
+private:
+    Event* start;
+    Event* stop;
+    Event* cont;
+    Event* terminate;
+};
+
+struct MarkerTimes {
+    long long blockedAt = 0;   // last time the marker blocked
+    long long resumes = 0;
+    long long resumeNs = 0;    // sum of resumedAt -> running latencies
+    long long resumeMaxNs = 0;
+};
+
+// MarkerCoordinator slot `marker`; optionally measures resume latency
+// against the controller's resumedAt timestamp.
+class CoordinatorControl {
+public:
+    CoordinatorControl(MarkerCoordinator& coordinator, int marker,
+        const std::atomic<long long>* resumedAt = nullptr, MarkerTimes* times = nullptr)
+        : coordinator(coordinator), marker(marker), resumedAt(resumedAt), times(times) {}
+
+    void WaitStart() { coordinator.WaitStart(); }
+    bool Block();
+
+private:
+    MarkerCoordinator& coordinator;
+    int marker;
+    const std::atomic<long long>* resumedAt;
+    MarkerTimes* times;
+};
+
+// ---- Engine
+
+struct MarkerSettings {
+    int id;               // written into claimed cells, 1-based
+    unsigned workUs;      // simulated work per claim
+    unsigned blockAfter;  // failed probes in a row before blocking; 1 = first collision
+    bool verbose;         // print "Marker id | owned | cell" when blocking
+};
+
+void PrintMarkerBlocked(int id, size_t owned, long cell);
+
+// Runs one marker until it is told to terminate; its cells are cleared and
+// `owned` is emptied on the way out. Returns how many cells it marked in total.
+template<class Sync, class Select, class Control>
+size_t RunMarker(const MarkerSettings& settings, Sync& sync, Select& select, Control& control,
+    OwnedCells& owned) {
+    owned.Reset(sync.Size());
+    control.WaitStart();
+
+    size_t marks = 0;
+    unsigned failures = 0;
+
+    for (;;) {
+        size_t before = owned.size();
+        long cell = select.Next();
+
+        if (cell >= 0 && sync.TryClaim((size_t)cell, settings.id, settings.workUs, owned)) {
+            marks += owned.size() - before;
+            failures = 0;
+            continue;
+        }
+        if (cell >= 0 && ++failures < settings.blockAfter) continue;
+
+        if (settings.verbose) PrintMarkerBlocked(settings.id, owned.size(), cell);
+
+        if (control.Block()) {
+            sync.Release(owned, [&select](size_t first, uint64_t mask) { select.Released(first, mask); });
+            owned.clear();
+            return marks;
+        }
+        failures = 0;
+    }
+}
+
+enum MarkerEngineKind {
+    ENGINE_MUTEX,     // LockedSync<ProfiledMutex>
+    ENGINE_ADAPTIVE,  // LockedSync<AdaptiveMutex>
+    ENGINE_STRIPED,   // StripedSync
+    ENGINE_LOCKFREE   // AtomicSync
+};
+
+bool ParseMarkerEngine(const std::string& name, MarkerEngineKind& kind);
+const char* MarkerEngineName(MarkerEngineKind kind);
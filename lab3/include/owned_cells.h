@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+inline int LowestSetBit(uint64_t bits) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, bits);
+    return (int)index;
+#else
+    return __builtin_ctzll(bits);
+#endif
+}
+
+inline int HighestSetBit(uint64_t bits) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse64(&index, bits);
+    return (int)index;
+#else
+    return 63 - __builtin_clzll(bits);
+#endif
+}
+
+// Cells held by one marker, one bit per array cell. Sized once for the whole
+// array, so marking never reallocates, and termination clears the marker's
+// cells a 64-cell word at a time: the cost is O(size / 64) whatever the count.
+// push_back/size/empty/clear and ascending iteration keep it a drop-in for
+// the std::vector<int> the lab API used to hold.
+class OwnedCells {
+public:
+    class const_iterator {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef int value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const int* pointer;
+        typedef int reference;
+
+        const_iterator(const std::vector<uint64_t>& words, size_t word)
+            : words(&words), word(word), bits(word < words.size() ? words[word] : 0) {
+            Settle();
+        }
+
+        int operator*() const { return (int)(word * 64 + LowestSetBit(bits)); }
+        const_iterator& operator++() {
+            bits &= bits - 1;
+            Settle();
+            return *this;
+        }
+        bool operator==(const const_iterator& other) const { return word == other.word && bits == other.bits; }
+        bool operator!=(const const_iterator& other) const { return !(*this == other); }
+
+    private:
+        void Settle() {
+            while (!bits && word < words->size()) {
+                word++;
+                bits = word < words->size() ? (*words)[word] : 0;
+            }
+        }
+
+        const std::vector<uint64_t>* words;
+        size_t word;
+        uint64_t bits;
+    };
+
+    OwnedCells() : count(0) {}
+    explicit OwnedCells(size_t cells) : count(0) { Reset(cells); }
+
+    // Room for cells [0, cells); drops whatever was held.
+    void Reset(size_t cells);
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    void push_back(int cell);
+    void clear();
+
+    bool Contains(size_t cell) const {
+        return cell / 64 < words.size() && (words[cell / 64] >> (cell & 63) & 1);
+    }
+
+    // Word w covers cells [w * 64, w * 64 + 64).
+    size_t WordCount() const { return words.size(); }
+    uint64_t Word(size_t w) const { return words[w]; }
+
+    const_iterator begin() const { return const_iterator(words, 0); }
+    const_iterator end() const { return const_iterator(words, words.size()); }
+
+private:
+    size_t count;
+    std::vector<uint64_t> words;
+};
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "cache_aligned.h"
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+class SpinLock {
+public:
+    void lock() {
+        while (flag.exchange(true, std::memory_order_acquire)) {
+            while (flag.load(std::memory_order_relaxed)) std::this_thread::yield();
+        }
+    }
+
+    bool try_lock() {
+        return !flag.load(std::memory_order_relaxed)
+            && !flag.exchange(true, std::memory_order_acquire);
+    }
+
+    void unlock() {
+        flag.store(false, std::memory_order_release);
+    }
+
+private:
+    std::atomic<bool> flag{ false };
+};
+
+struct alignas(kCacheLine) LockStripe {
+    SpinLock lock;
+};
+
+// One lock per stripe of consecutive cells. With the default stripe width a stripe
+// is exactly one cache line of an AlignedArray, so markers working on different
+// stripes share neither a lock nor a line of the array.
+class StripedLockTable {
+public:
+    explicit StripedLockTable(size_t cells, size_t cellsPerStripe = kCacheLine / sizeof(int));
+
+    size_t StripeCount() const { return stripes.size(); }
+    size_t CellsPerStripe() const { return cellsPerStripe; }
+    size_t StripeOf(size_t cell) const { return cell / cellsPerStripe; }
+    SpinLock& Stripe(size_t stripe) { return stripes[stripe].lock; }
+
+    // Locks all stripes covering [first, first + count) in ascending order, so
+    // multi-cell claims cannot deadlock against each other.
+    void LockRange(size_t first, size_t count);
+    void UnlockRange(size_t first, size_t count);
+
+private:
+    size_t cellsPerStripe;
+    std::vector<LockStripe, CacheAlignedAllocator<LockStripe>> stripes;
+};
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "cache_aligned.h"
+#include "free_cell_index.h"
+#include "owned_cells.h"
+#include "striped_lock.h"
+#include "sync_event.h"
+#include <vector>
+
+// Marker that locks only the stripe(s) it probes. A claim covers claimWidth
+// adjacent cells, all checked and written under the covering stripe locks.
+struct StripedMarkerData {
+    int id;
+    AlignedArray* array;
+    StripedLockTable* locks;
+    OwnedCells markedIndices;  // ownership bitmap, sized by the engine
+    Event* startEvent;
+    Event* stopEvent;
+    Event* continueEvent;
+    Event* terminateEvent;
+    int claimWidth;
+    unsigned workUs;
+    bool verbose;
+    FreeCellIndex* freeCells = nullptr;  // single-cell claims only (claimWidth 1)
+};
+
+void striped_marker_thread(StripedMarkerData* data);
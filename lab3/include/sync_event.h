@@ -0,0 +1,45 @@
+#pragma once
+
+#include "striped_lock.h"
+#include <atomic>
+#include <cstdint>
+
+struct EventWaitNode;
+
+// Portable replacement for Win32 event objects, built on futex words.
+// Set() only enters the kernel when some thread is registered as waiting, and
+// Wait() on a signaled event never does.
+class Event {
+public:
+    Event(bool manualReset, bool initialState);
+
+    Event(const Event&) = delete;
+    Event& operator=(const Event&) = delete;
+
+    void Set();
+    void Reset();
+    void Wait();
+    bool IsSet() const;
+
+private:
+    friend struct EventWaitBlock;
+    friend int WaitAny(Event* const* events, int count);
+    friend void WaitAll(Event* const* events, int count);
+
+    bool TryAcquire();
+    static bool TryAcquireAll(Event* const* events, int count);
+
+    const bool manual;
+    std::atomic<uint32_t> state;    // 1 = signaled
+    std::atomic<uint32_t> waiters;  // threads sleeping on state or registered below
+    SpinLock listLock;
+    EventWaitNode* waitList;        // multi-object waiters
+};
+
+// Returns the index of the event that satisfied the wait, like WAIT_OBJECT_0 + i.
+// Auto-reset events are consumed by the wait.
+int WaitAny(Event* const* events, int count);
+
+// Returns once every event is signaled at the same time; auto-reset events are
+// consumed together.
+void WaitAll(Event* const* events, int count);
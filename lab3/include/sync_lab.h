@@ -1,21 +1,31 @@
 #pragma once
 
-#define NOMINMAX
-#include <windows.h>
 #include <vector>
 #include <iostream>
 #include <string>
+#include <mutex>
+#include "adaptive_mutex.h"
+#include "free_cell_index.h"
+#include "lock_profiler.h"
+#include "owned_cells.h"
+#include "sync_event.h"
+
+typedef ProfiledLock<AdaptiveMutex> ProfiledAdaptiveMutex;
 
 struct MarkerData {
     int id;
     std::vector<int>* array;
-    std::vector<int> markedIndices;
-    HANDLE startEvent;
-    HANDLE stopEvent;
-    HANDLE continueEvent;
-    HANDLE terminateEvent;
-    CRITICAL_SECTION* cs;
-    bool active;
+    OwnedCells markedIndices;  // ownership bitmap, sized by the engine
+    Event* startEvent;
+    Event* stopEvent;
+    Event* continueEvent;
+    Event* terminateEvent;
+    ProfiledMutex* cs;
+    bool active;                         // unused by the engine, kept for the lab API
+    FreeCellIndex* freeCells = nullptr;  // when set, cells are claimed from the index
+    unsigned workUs = 5000;              // slept before and after writing a cell
+    ProfiledAdaptiveMutex* adaptiveCs = nullptr;  // when set, used instead of cs
 };
 
-DWORD WINAPI marker_thread(LPVOID lpParam);
\ No newline at end of file
+// RunMarker with LockedSync over cs (or adaptiveCs) and event control.
+void marker_thread(MarkerData* data);
\ No newline at end of file
@@ -0,0 +1,51 @@
+#include "adaptive_mutex.h"
+#include "futex.h"
+#include <algorithm>
+#include <chrono>
+
+// Rough cost of one CpuRelax(); only used to turn hold times into spin counts.
+static const int64_t kPauseNs = 20;
+// Holds longer than this are not worth spinning for at all.
+static const int64_t kParkHoldNs = 50000;
+
+int64_t AdaptiveMutex::Now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void AdaptiveMutex::LockSlow() {
+    uint32_t budget = spinBudget.load(std::memory_order_relaxed);
+    uint32_t backoff = 1;
+
+    for (uint32_t spent = 0; spent < budget; spent += backoff, backoff = std::min(backoff * 2, 64u)) {
+        for (uint32_t i = 0; i < backoff; i++) CpuRelax();
+
+        uint32_t expected = 0;
+        if (state.load(std::memory_order_relaxed) == 0
+            && state.compare_exchange_weak(expected, 1, std::memory_order_acquire)) {
+            return;
+        }
+    }
+
+    // Taking the lock as 2 keeps a later unlock() waking the next parked thread.
+    while (state.exchange(2, std::memory_order_acquire) != 0) {
+        FutexWait(&state, 2);
+    }
+}
+
+void AdaptiveMutex::LearnHold() {
+    int64_t hold = Now() - acquiredAt;
+    holdAverageNs += (hold - holdAverageNs) / 4;
+
+    int64_t spins = holdAverageNs > kParkHoldNs ? kMinSpin : 2 * holdAverageNs / kPauseNs;
+    spinBudget.store((uint32_t)std::max<int64_t>(kMinSpin, std::min<int64_t>(kMaxSpin, spins)),
+        std::memory_order_relaxed);
+}
+
+void AdaptiveMutex::unlock() {
+    if (acquiredAt) LearnHold();
+
+    if (state.exchange(0, std::memory_order_release) == 2) {
+        FutexWakeOne(&state);
+    }
+}
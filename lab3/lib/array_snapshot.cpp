@@ -0,0 +1,106 @@
+#include "array_snapshot.h"
+#include "owned_cells.h"
+#include <algorithm>
+#include <thread>
+
+static const uint64_t kWriteStarted = 1;
+static const uint64_t kWriteFinished = (uint64_t)1 << 32;
+static const uint64_t kWritesInProgress = kWriteFinished - 1;
+
+ObservableArray::ObservableArray(size_t cellCount, size_t cellsPerStripe, bool initialize)
+    : size(cellCount), cellsPerStripe(cellsPerStripe), cells(new std::atomic<int>[cellCount]),
+      stripes((cellCount + cellsPerStripe - 1) / cellsPerStripe) {
+    for (auto& stripe : stripes) stripe.sequence.store(0, std::memory_order_relaxed);
+    if (initialize) InitializeRange(0, cellCount);
+}
+
+void ObservableArray::InitializeRange(size_t first, size_t last) {
+    for (size_t i = first; i < last; i++) cells[i].store(0, std::memory_order_relaxed);
+}
+
+std::atomic<uint64_t>& ObservableArray::BeginWrite(size_t cell) {
+    std::atomic<uint64_t>& sequence = stripes[cell / cellsPerStripe].sequence;
+    sequence.fetch_add(kWriteStarted, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    return sequence;
+}
+
+void ObservableArray::EndWrite(std::atomic<uint64_t>& sequence) {
+    sequence.fetch_add(kWriteFinished - kWriteStarted, std::memory_order_release);
+}
+
+void ObservableArray::Set(size_t cell, int value) {
+    std::atomic<uint64_t>& sequence = BeginWrite(cell);
+    cells[cell].store(value, std::memory_order_relaxed);
+    EndWrite(sequence);
+}
+
+bool ObservableArray::CompareAndSet(size_t cell, int expected, int value) {
+    std::atomic<uint64_t>& sequence = BeginWrite(cell);
+    bool done = cells[cell].compare_exchange_strong(expected, value, std::memory_order_acq_rel);
+    EndWrite(sequence);
+    return done;
+}
+
+void ObservableArray::ClearMasked(size_t first, uint64_t mask) {
+    while (mask) {
+        size_t cell = first + (size_t)LowestSetBit(mask);
+        size_t stripeEnd = std::min((cell / cellsPerStripe + 1) * cellsPerStripe, size);
+
+        std::atomic<uint64_t>& sequence = BeginWrite(cell);
+        for (; cell < stripeEnd && mask; cell++) {
+            uint64_t bit = 1ULL << (cell - first);
+            if (mask & bit) {
+                cells[cell].store(0, std::memory_order_relaxed);
+                mask &= ~bit;
+            }
+        }
+        EndWrite(sequence);
+    }
+}
+
+uint64_t ObservableArray::CopyStripe(size_t stripe, int* out) const {
+    size_t first = stripe * cellsPerStripe;
+    size_t last = std::min(first + cellsPerStripe, size);
+    const std::atomic<uint64_t>& sequence = stripes[stripe].sequence;
+
+    for (;;) {
+        uint64_t before = sequence.load(std::memory_order_acquire);
+        if (before & kWritesInProgress) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        for (size_t i = first; i < last; i++) {
+            out[i] = cells[i].load(std::memory_order_relaxed);
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (sequence.load(std::memory_order_relaxed) == before) return before;
+    }
+}
+
+void ObservableArray::Snapshot(ArraySnapshot& out, int markers, unsigned attempts) const {
+    std::vector<uint64_t> seen(stripes.size());
+    out.cells.resize(size);
+    out.consistent = false;
+    out.attempts = 0;
+
+    while (!out.consistent && out.attempts < std::max(1u, attempts)) {
+        out.attempts++;
+        for (size_t s = 0; s < stripes.size(); s++) {
+            seen[s] = CopyStripe(s, out.cells.data());
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        out.consistent = true;
+        for (size_t s = 0; s < stripes.size() && out.consistent; s++) {
+            out.consistent = stripes[s].sequence.load(std::memory_order_relaxed) == seen[s];
+        }
+    }
+
+    out.owned.assign(markers + 1, 0);
+    for (int v : out.cells) {
+        if (v >= 0 && v <= markers) out.owned[v]++;
+    }
+}
@@ -0,0 +1,17 @@
+#include "atomic_marker.h"
+#include "marker_engine.h"
+
+void atomic_marker_thread(AtomicMarkerData* data) {
+    AtomicSync<std::vector<std::atomic<int>>> sync(*data->array);
+    EventControl control(data->startEvent, data->stopEvent, data->continueEvent, data->terminateEvent);
+    MarkerSettings settings = { data->id, data->workUs, (unsigned)sync.Size() * 2 + 1, data->verbose };
+
+    if (data->freeCells) {
+        IndexedCells select(*data->freeCells, data->id);
+        RunMarker(settings, sync, select, control, data->markedIndices);
+    }
+    else {
+        RandomCells select(data->id, 0, sync.Size());
+        RunMarker(settings, sync, select, control, data->markedIndices);
+    }
+}
@@ -0,0 +1,135 @@
+#include "free_cell_index.h"
+#include "owned_cells.h"
+#include <bitset>
+
+namespace {
+
+uint64_t mix(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+// Random set bit: rotate by a random amount and take the lowest set bit.
+int pickBit(uint64_t bits, uint64_t random) {
+    int shift = (int)(random & 63);
+    uint64_t rotated = shift ? (bits >> shift) | (bits << (64 - shift)) : bits;
+    return (LowestSetBit(rotated) + shift) & 63;
+}
+
+uint64_t bitOf(size_t index) {
+    return 1ULL << (index & 63);
+}
+
+} // namespace
+
+FreeCellIndex::FreeCellIndex(size_t cells)
+    : cells(cells), freeCount(cells) {
+    size_t count = cells;
+    do {
+        size_t words = (count + 63) / 64;
+        std::vector<std::atomic<uint64_t>> level(words);
+        for (size_t w = 0; w < words; w++) {
+            size_t bits = count - w * 64;
+            level[w].store(bits >= 64 ? ~0ULL : (1ULL << bits) - 1);
+        }
+        levels.push_back(std::move(level));
+        count = words;
+    } while (count > 1);
+}
+
+long FreeCellIndex::ClaimRandom(uint64_t random) {
+    size_t top = levels.size() - 1;
+
+    for (int attempt = 0; freeCount.load() > 0; attempt++) {
+        uint64_t r = mix(random + attempt);
+        size_t word = 0;
+        size_t level = top;
+
+        for (; level > 0; level--) {
+            uint64_t bits = levels[level][word].load();
+            if (bits == 0) break;
+            word = word * 64 + pickBit(bits, r);
+            r = mix(r);
+        }
+
+        // An empty summary word is stale or mid-update while freeCount says a
+        // cell is free (a Release sets the bits before counting, a claim
+        // clears them before uncounting): fix it up and try again. The top
+        // word has no summary above it to fix.
+        if (level > 0) {
+            if (level < top) clearUp(level, word);
+            continue;
+        }
+
+        std::atomic<uint64_t>& leaf = levels[0][word];
+        uint64_t bits = leaf.load();
+        while (bits != 0) {
+            int bit = pickBit(bits, r);
+            uint64_t next = bits & ~(1ULL << bit);
+            if (leaf.compare_exchange_weak(bits, next)) {
+                if (next == 0) clearUp(0, word);
+                freeCount.fetch_sub(1);
+                return (long)(word * 64 + bit);
+            }
+        }
+        clearUp(0, word);
+    }
+    return -1;
+}
+
+bool FreeCellIndex::Claim(size_t cell) {
+    size_t word = cell / 64;
+    uint64_t bit = bitOf(cell);
+    uint64_t prev = levels[0][word].fetch_and(~bit);
+    if ((prev & bit) == 0) return false;
+
+    if ((prev & ~bit) == 0) clearUp(0, word);
+    freeCount.fetch_sub(1);
+    return true;
+}
+
+void FreeCellIndex::Release(size_t cell) {
+    size_t word = cell / 64;
+    levels[0][word].fetch_or(bitOf(cell));
+    setUp(0, word);
+    freeCount.fetch_add(1);
+}
+
+// The word at `level` looked empty: drop its summary bit, then re-check it, since a
+// concurrent Release may have refilled it between our load and the fetch_and.
+void FreeCellIndex::clearUp(size_t level, size_t word) {
+    while (level + 1 < levels.size()) {
+        size_t parent = word / 64;
+        uint64_t remaining = levels[level + 1][parent].fetch_and(~bitOf(word)) & ~bitOf(word);
+
+        if (levels[level][word].load() != 0) {
+            setUp(level, word);
+            return;
+        }
+        if (remaining != 0) return;
+
+        level++;
+        word = parent;
+    }
+}
+
+void FreeCellIndex::ReleaseMask(size_t first, uint64_t mask) {
+    if (!mask) return;
+    size_t word = first / 64;
+    levels[0][word].fetch_or(mask);
+    setUp(0, word);
+    freeCount.fetch_add(std::bitset<64>(mask).count());
+}
+
+void FreeCellIndex::setUp(size_t level, size_t word) {
+    while (level + 1 < levels.size()) {
+        size_t parent = word / 64;
+        uint64_t prev = levels[level + 1][parent].fetch_or(bitOf(word));
+        if (prev & bitOf(word)) return;
+
+        level++;
+        word = parent;
+    }
+}
@@ -0,0 +1,61 @@
+#include "futex.h"
+
+#if defined(__linux__)
+#include <climits>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <thread>
+#endif
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex word must be a plain 32-bit integer");
+
+#if defined(__linux__)
+
+static long futex(std::atomic<uint32_t>* word, int op, uint32_t value) {
+    return syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), op, value, nullptr, nullptr, 0);
+}
+
+void FutexWait(std::atomic<uint32_t>* word, uint32_t expected) {
+    futex(word, FUTEX_WAIT_PRIVATE, expected);
+}
+
+void FutexWakeOne(std::atomic<uint32_t>* word) {
+    futex(word, FUTEX_WAKE_PRIVATE, 1);
+}
+
+void FutexWakeAll(std::atomic<uint32_t>* word) {
+    futex(word, FUTEX_WAKE_PRIVATE, INT_MAX);
+}
+
+#elif defined(_WIN32)
+
+void FutexWait(std::atomic<uint32_t>* word, uint32_t expected) {
+    WaitOnAddress(word, &expected, sizeof(expected), INFINITE);
+}
+
+void FutexWakeOne(std::atomic<uint32_t>* word) {
+    WakeByAddressSingle(word);
+}
+
+void FutexWakeAll(std::atomic<uint32_t>* word) {
+    WakeByAddressAll(word);
+}
+
+#else
+
+void FutexWait(std::atomic<uint32_t>* word, uint32_t expected) {
+    if (word->load() == expected) std::this_thread::yield();
+}
+
+void FutexWakeOne(std::atomic<uint32_t>*) {
+}
+
+void FutexWakeAll(std::atomic<uint32_t>*) {
+}
+
+#endif
@@ -0,0 +1,192 @@
+#include "lock_profiler.h"
+
+#ifdef SYNC_LOCK_PROFILE
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+static const int kHistogramBuckets = 40;
+
+struct LockCounters {
+    uint64_t acquisitions = 0;
+    uint64_t contended = 0;
+    int64_t waitNs = 0;
+    int64_t waitMaxNs = 0;
+    int64_t holdNs = 0;
+    int64_t holdMaxNs = 0;
+    uint64_t waitHistogram[kHistogramBuckets] = {};
+    uint64_t holdHistogram[kHistogramBuckets] = {};
+
+    void Add(const LockCounters& other) {
+        acquisitions += other.acquisitions;
+        contended += other.contended;
+        waitNs += other.waitNs;
+        waitMaxNs = std::max(waitMaxNs, other.waitMaxNs);
+        holdNs += other.holdNs;
+        holdMaxNs = std::max(holdMaxNs, other.holdMaxNs);
+        for (int b = 0; b < kHistogramBuckets; b++) {
+            waitHistogram[b] += other.waitHistogram[b];
+            holdHistogram[b] += other.holdHistogram[b];
+        }
+    }
+};
+
+struct ThreadLockLog {
+    std::string name;
+    std::vector<LockCounters> locks;  // indexed by lock id, grown by the owner only
+};
+
+// Owns every thread's log so the data outlives the threads; prints the report
+// when static objects are destroyed at exit.
+class ProfilerRegistry {
+public:
+    ~ProfilerRegistry() {
+        LockProfiler::WriteReport(std::cerr);
+
+        const char* folded = std::getenv("LOCK_PROFILE_FOLDED");
+        if (folded && *folded) {
+            std::ofstream out(folded);
+            LockProfiler::WriteFolded(out);
+        }
+    }
+
+    std::mutex lock;
+    std::vector<std::string> lockNames;
+    std::vector<std::unique_ptr<ThreadLockLog>> threads;
+};
+
+static ProfilerRegistry& Registry() {
+    static ProfilerRegistry registry;
+    return registry;
+}
+
+static thread_local ThreadLockLog* currentThread = nullptr;
+
+static ThreadLockLog& CurrentThread() {
+    if (!currentThread) {
+        ProfilerRegistry& registry = Registry();
+        std::lock_guard<std::mutex> guard(registry.lock);
+        registry.threads.emplace_back(new ThreadLockLog());
+        currentThread = registry.threads.back().get();
+        currentThread->name = "thread " + std::to_string(registry.threads.size());
+    }
+    return *currentThread;
+}
+
+static LockCounters& Counters(int lock) {
+    ThreadLockLog& log = CurrentThread();
+    if ((size_t)lock >= log.locks.size()) log.locks.resize(lock + 1);
+    return log.locks[lock];
+}
+
+static int BucketOf(int64_t ns) {
+    int bucket = 0;
+    while (ns > 0 && bucket < kHistogramBuckets - 1) {
+        ns >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+static void WriteHistogram(std::ostream& out, const char* title, const uint64_t* histogram) {
+    uint64_t peak = *std::max_element(histogram, histogram + kHistogramBuckets);
+    if (peak == 0) return;
+
+    out << "  " << title << " histogram (ns):\n";
+    for (int b = 0; b < kHistogramBuckets; b++) {
+        if (histogram[b] == 0) continue;
+        long long low = b == 0 ? 0 : 1LL << (b - 1);
+        long long high = 1LL << b;
+        size_t bar = std::max<size_t>(1, (size_t)(histogram[b] * 40 / peak));
+        out << "  [" << std::setw(11) << low << ", " << std::setw(11) << high << ") "
+            << std::setw(10) << histogram[b] << " " << std::string(bar, '#') << "\n";
+    }
+}
+
+static void WriteCounters(std::ostream& out, const LockCounters& c) {
+    double avgWait = c.acquisitions ? (double)c.waitNs / c.acquisitions : 0.0;
+    double avgHold = c.acquisitions ? (double)c.holdNs / c.acquisitions : 0.0;
+
+    out << "acquisitions=" << c.acquisitions << " contended=" << c.contended
+        << " (" << (c.acquisitions ? 100.0 * c.contended / c.acquisitions : 0.0) << "%)"
+        << " wait_ms=" << c.waitNs / 1e6 << " wait_avg_us=" << avgWait / 1e3
+        << " wait_max_us=" << c.waitMaxNs / 1e3
+        << " hold_ms=" << c.holdNs / 1e6 << " hold_avg_us=" << avgHold / 1e3
+        << " hold_max_us=" << c.holdMaxNs / 1e3 << "\n";
+}
+
+int LockProfiler::RegisterLock(const char* name) {
+    ProfilerRegistry& registry = Registry();
+    std::lock_guard<std::mutex> guard(registry.lock);
+    registry.lockNames.push_back(name);
+    return (int)registry.lockNames.size() - 1;
+}
+
+void LockProfiler::SetThreadName(const char* prefix, int index) {
+    CurrentThread().name = std::string(prefix) + " " + std::to_string(index);
+}
+
+void LockProfiler::RecordAcquire(int lock, int64_t waitNs, bool contended) {
+    LockCounters& c = Counters(lock);
+    c.acquisitions++;
+    c.waitNs += waitNs;
+    c.waitMaxNs = std::max(c.waitMaxNs, waitNs);
+    c.waitHistogram[BucketOf(waitNs)]++;
+    if (contended) c.contended++;
+}
+
+void LockProfiler::RecordRelease(int lock, int64_t holdNs) {
+    LockCounters& c = Counters(lock);
+    c.holdNs += holdNs;
+    c.holdMaxNs = std::max(c.holdMaxNs, holdNs);
+    c.holdHistogram[BucketOf(holdNs)]++;
+}
+
+void LockProfiler::WriteReport(std::ostream& out) {
+    ProfilerRegistry& registry = Registry();
+    std::lock_guard<std::mutex> guard(registry.lock);
+
+    out << "Lock profile\n";
+    for (size_t id = 0; id < registry.lockNames.size(); id++) {
+        LockCounters total;
+        for (const auto& thread : registry.threads) {
+            if (id < thread->locks.size()) total.Add(thread->locks[id]);
+        }
+        if (total.acquisitions == 0) continue;
+
+        out << "lock " << registry.lockNames[id] << ": ";
+        WriteCounters(out, total);
+        WriteHistogram(out, "wait", total.waitHistogram);
+        WriteHistogram(out, "hold", total.holdHistogram);
+
+        for (const auto& thread : registry.threads) {
+            if (id >= thread->locks.size() || thread->locks[id].acquisitions == 0) continue;
+            out << "  " << thread->name << ": ";
+            WriteCounters(out, thread->locks[id]);
+        }
+    }
+}
+
+// One line per thread, lock and phase: "marker 3;SyncLab.cs;wait 12345" with
+// the time in nanoseconds as the sample count.
+void LockProfiler::WriteFolded(std::ostream& out) {
+    ProfilerRegistry& registry = Registry();
+    std::lock_guard<std::mutex> guard(registry.lock);
+
+    for (const auto& thread : registry.threads) {
+        for (size_t id = 0; id < thread->locks.size(); id++) {
+            const LockCounters& c = thread->locks[id];
+            if (c.waitNs) out << thread->name << ";" << registry.lockNames[id] << ";wait " << c.waitNs << "\n";
+            if (c.holdNs) out << thread->name << ";" << registry.lockNames[id] << ";hold " << c.holdNs << "\n";
+        }
+    }
+}
+
+#endif
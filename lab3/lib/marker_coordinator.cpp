@@ -0,0 +1,75 @@
+#include "marker_coordinator.h"
+#include "futex.h"
+
+MarkerCoordinator::MarkerCoordinator(int markers)
+    : slots(markers), blocked(0), active(markers), started(0) {
+    for (Slot& slot : slots) {
+        slot.command.store(MARKER_RUNNING);
+        slot.alive = true;
+    }
+}
+
+void MarkerCoordinator::WaitStart() {
+    while (started.load() == 0) {
+        FutexWait(&started, 0);
+    }
+}
+
+void MarkerCoordinator::Start() {
+    started.store(1);
+    FutexWakeAll(&started);
+}
+
+MarkerCommand MarkerCoordinator::Block(int marker) {
+    std::atomic<uint32_t>& command = slots[marker].command;
+    command.store(MARKER_BLOCKED);
+
+    if (blocked.fetch_add(1) + 1 >= active.load()) {
+        FutexWakeOne(&blocked);
+    }
+
+    for (;;) {
+        uint32_t current = MARKER_BLOCKED;
+        if (command.compare_exchange_strong(current, MARKER_SLEEPING)) {
+            current = MARKER_SLEEPING;
+        }
+        if (current != MARKER_SLEEPING) {
+            command.store(MARKER_RUNNING);
+            return (MarkerCommand)current;
+        }
+        FutexWait(&command, MARKER_SLEEPING);
+        current = command.load();
+        if (current == MARKER_CONTINUE || current == MARKER_TERMINATE) {
+            command.store(MARKER_RUNNING);
+            return (MarkerCommand)current;
+        }
+    }
+}
+
+void MarkerCoordinator::WaitAllBlocked() {
+    for (;;) {
+        uint32_t seen = blocked.load();
+        if (seen >= active.load()) return;
+        FutexWait(&blocked, seen);
+    }
+}
+
+void MarkerCoordinator::Send(int marker, MarkerCommand command) {
+    if (slots[marker].command.exchange(command) == MARKER_SLEEPING) {
+        FutexWakeOne(&slots[marker].command);
+    }
+}
+
+void MarkerCoordinator::ResumeAll() {
+    blocked.store(0);
+    for (int i = 0; i < (int)slots.size(); i++) {
+        if (slots[i].alive) Send(i, MARKER_CONTINUE);
+    }
+}
+
+void MarkerCoordinator::Terminate(int marker) {
+    slots[marker].alive = false;
+    active.fetch_sub(1);
+    blocked.fetch_sub(1);
+    Send(marker, MARKER_TERMINATE);
+}
@@ -0,0 +1,50 @@
+#include "marker_engine.h"
+#include <iostream>
+#include <sstream>
+
+bool EventControl::Block() {
+    stop->Set();
+    Event* events[2] = { cont, terminate };
+    return WaitAny(events, 2) == 1;
+}
+
+bool CoordinatorControl::Block() {
+    if (times) times->blockedAt = MarkerClockNs();
+    if (coordinator.Block(marker) == MARKER_TERMINATE) return true;
+
+    if (times && resumedAt) {
+        long long latency = MarkerClockNs() - resumedAt->load();
+        times->resumes++;
+        times->resumeNs += latency;
+        times->resumeMaxNs = std::max(times->resumeMaxNs, latency);
+    }
+    return false;
+}
+
+void PrintMarkerBlocked(int id, size_t owned, long cell) {
+    // One write per line, so lines of different markers do not interleave.
+    std::ostringstream line;
+    line << "Marker " << id << " | " << owned << " | ";
+    if (cell >= 0) line << cell;
+    else line << "no free cells";
+    line << "\n";
+    std::cout << line.str() << std::flush;
+}
+
+bool ParseMarkerEngine(const std::string& name, MarkerEngineKind& kind) {
+    if (name == "mutex") kind = ENGINE_MUTEX;
+    else if (name == "adaptive") kind = ENGINE_ADAPTIVE;
+    else if (name == "striped") kind = ENGINE_STRIPED;
+    else if (name == "lockfree") kind = ENGINE_LOCKFREE;
+    else return false;
+    return true;
+}
+
+const char* MarkerEngineName(MarkerEngineKind kind) {
+    switch (kind) {
+    case ENGINE_ADAPTIVE: return "adaptive";
+    case ENGINE_STRIPED: return "striped";
+    case ENGINE_LOCKFREE: return "lockfree";
+    default: return "mutex";
+    }
+}
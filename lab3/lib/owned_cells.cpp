@@ -0,0 +1,24 @@
+#include "owned_cells.h"
+#include <algorithm>
+
+void OwnedCells::Reset(size_t cells) {
+    words.assign((cells + 63) / 64, 0);
+    count = 0;
+}
+
+void OwnedCells::push_back(int cell) {
+    size_t word = (size_t)cell / 64;
+    // Only reached when the owner skipped Reset.
+    if (word >= words.size()) words.resize(word + 1, 0);
+
+    uint64_t bit = 1ULL << (cell & 63);
+    if (!(words[word] & bit)) {
+        words[word] |= bit;
+        count++;
+    }
+}
+
+void OwnedCells::clear() {
+    std::fill(words.begin(), words.end(), 0);
+    count = 0;
+}
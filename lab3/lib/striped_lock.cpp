@@ -0,0 +1,21 @@
+#include "striped_lock.h"
+#include <algorithm>
+
+StripedLockTable::StripedLockTable(size_t cells, size_t cellsPerStripe)
+    : cellsPerStripe(std::max<size_t>(1, cellsPerStripe)) {
+    stripes = decltype(stripes)(std::max<size_t>(1, (cells + this->cellsPerStripe - 1) / this->cellsPerStripe));
+}
+
+void StripedLockTable::LockRange(size_t first, size_t count) {
+    size_t last = StripeOf(first + (count ? count - 1 : 0));
+    for (size_t s = StripeOf(first); s <= last; s++) {
+        stripes[s].lock.lock();
+    }
+}
+
+void StripedLockTable::UnlockRange(size_t first, size_t count) {
+    size_t last = StripeOf(first + (count ? count - 1 : 0));
+    for (size_t s = StripeOf(first); s <= last; s++) {
+        stripes[s].lock.unlock();
+    }
+}
@@ -0,0 +1,17 @@
+#include "striped_marker.h"
+#include "marker_engine.h"
+
+void striped_marker_thread(StripedMarkerData* data) {
+    StripedSync<AlignedArray> sync(*data->array, *data->locks, data->claimWidth);
+    EventControl control(data->startEvent, data->stopEvent, data->continueEvent, data->terminateEvent);
+    MarkerSettings settings = { data->id, data->workUs, (unsigned)sync.Size() * 2 + 1, data->verbose };
+
+    if (data->freeCells && sync.Width() == 1) {
+        IndexedCells select(*data->freeCells, data->id);
+        RunMarker(settings, sync, select, control, data->markedIndices);
+    }
+    else {
+        RandomCells select(data->id, 0, sync.Size() - sync.Width() + 1);
+        RunMarker(settings, sync, select, control, data->markedIndices);
+    }
+}
@@ -0,0 +1,139 @@
+#include "sync_event.h"
+#include "futex.h"
+#include <mutex>
+#include <vector>
+
+struct EventWaitNode {
+    std::atomic<uint32_t>* signal;
+    EventWaitNode* prev;
+    EventWaitNode* next;
+};
+
+// A multi-object wait registers one node per event. Every Set() on any of them
+// bumps the shared signal word, so the waiter sleeps on a single futex.
+struct EventWaitBlock {
+    std::atomic<uint32_t> signal;
+    std::vector<EventWaitNode> nodes;
+    Event* const* events;
+    int count;
+
+    EventWaitBlock(Event* const* events, int count)
+        : signal(0), nodes(count), events(events), count(count) {
+        for (int i = 0; i < count; i++) {
+            Event* e = events[i];
+            EventWaitNode& node = nodes[i];
+            node.signal = &signal;
+            node.prev = nullptr;
+
+            {
+                std::lock_guard<SpinLock> guard(e->listLock);
+                node.next = e->waitList;
+                if (e->waitList) e->waitList->prev = &node;
+                e->waitList = &node;
+            }
+            e->waiters.fetch_add(1);
+        }
+    }
+
+    ~EventWaitBlock() {
+        for (int i = 0; i < count; i++) {
+            Event* e = events[i];
+            EventWaitNode& node = nodes[i];
+            e->waiters.fetch_sub(1);
+
+            std::lock_guard<SpinLock> guard(e->listLock);
+            if (node.prev) node.prev->next = node.next;
+            else e->waitList = node.next;
+            if (node.next) node.next->prev = node.prev;
+        }
+    }
+};
+
+Event::Event(bool manualReset, bool initialState)
+    : manual(manualReset), state(initialState ? 1 : 0), waiters(0), waitList(nullptr) {
+}
+
+// Set publishes the state before reading the waiter count and waiters register
+// before re-checking the state, so one side always sees the other.
+void Event::Set() {
+    state.store(1);
+    if (waiters.load() == 0) return;
+
+    if (manual) FutexWakeAll(&state);
+    else FutexWakeOne(&state);
+
+    std::lock_guard<SpinLock> guard(listLock);
+    for (EventWaitNode* node = waitList; node; node = node->next) {
+        node->signal->fetch_add(1);
+        FutexWakeOne(node->signal);
+    }
+}
+
+void Event::Reset() {
+    state.store(0);
+}
+
+bool Event::IsSet() const {
+    return state.load() == 1;
+}
+
+bool Event::TryAcquire() {
+    if (manual) return state.load() == 1;
+
+    uint32_t expected = 1;
+    return state.compare_exchange_strong(expected, 0);
+}
+
+void Event::Wait() {
+    if (TryAcquire()) return;
+
+    waiters.fetch_add(1);
+    while (!TryAcquire()) {
+        FutexWait(&state, 0);
+    }
+    waiters.fetch_sub(1);
+}
+
+// All-or-nothing: if another thread steals an auto-reset event half way through,
+// the ones already taken are put back.
+bool Event::TryAcquireAll(Event* const* events, int count) {
+    for (int i = 0; i < count; i++) {
+        if (events[i]->state.load() == 0) return false;
+    }
+
+    for (int i = 0; i < count; i++) {
+        if (events[i]->manual || events[i]->TryAcquire()) continue;
+
+        for (int j = 0; j < i; j++) {
+            if (!events[j]->manual) events[j]->Set();
+        }
+        return false;
+    }
+    return true;
+}
+
+int WaitAny(Event* const* events, int count) {
+    for (int i = 0; i < count; i++) {
+        if (events[i]->TryAcquire()) return i;
+    }
+
+    EventWaitBlock block(events, count);
+    for (;;) {
+        uint32_t seen = block.signal.load();
+        for (int i = 0; i < count; i++) {
+            if (events[i]->TryAcquire()) return i;
+        }
+        FutexWait(&block.signal, seen);
+    }
+}
+
+void WaitAll(Event* const* events, int count) {
+    if (Event::TryAcquireAll(events, count)) return;
+
+    EventWaitBlock block(events, count);
+    for (;;) {
+        uint32_t seen = block.signal.load();
+        if (Event::TryAcquireAll(events, count)) return;
+        FutexWait(&block.signal, seen);
+    }
+}
@@ -1,57 +1,25 @@
-#define NOMINMAX
 #include "sync_lab.h"
-#include <cstdlib>
-#include <ctime>
+#include "marker_engine.h"
 
-DWORD WINAPI marker_thread(LPVOID lpParam) {
-    MarkerData* data = (MarkerData*)lpParam;
+template<class Lock>
+static void runMarker(MarkerData* data, Lock& lock) {
+    LockedSync<std::vector<int>, Lock> sync(*data->array, lock);
+    EventControl control(data->startEvent, data->stopEvent, data->continueEvent, data->terminateEvent);
+    MarkerSettings settings = { data->id, data->workUs, (unsigned)sync.Size() * 2 + 1, true };
 
-    srand(data->id);
-    WaitForSingleObject(data->startEvent, INFINITE);
-
-    int size = (int)data->array->size();
-    int failCount = 0;
-
-    while (data->active) {
-        int index = rand() % size;
-
-        EnterCriticalSection(data->cs);
-
-        if ((*data->array)[index] == 0) {
-            Sleep(5);
-            (*data->array)[index] = data->id;
-            Sleep(5);
-            data->markedIndices.push_back(index);
-            failCount = 0;
-            LeaveCriticalSection(data->cs);
-        }
-        else {
-            failCount++;
-            LeaveCriticalSection(data->cs);
-
-            if (failCount > size * 2) {
-                std::cout << "Marker " << data->id
-                    << " | " << data->markedIndices.size()
-                    << " | blocked: no free cells" << std::endl;
-
-                SetEvent(data->stopEvent);
+    if (data->freeCells) {
+        IndexedCells select(*data->freeCells, data->id);
+        RunMarker(settings, sync, select, control, data->markedIndices);
+    }
+    else {
+        RandomCells select(data->id, 0, sync.Size());
+        RunMarker(settings, sync, select, control, data->markedIndices);
+    }
+}
 
-                HANDLE events[2] = { data->continueEvent, data->terminateEvent };
-                DWORD result = WaitForMultipleObjects(2, events, FALSE, INFINITE);
+void marker_thread(MarkerData* data) {
+    LockProfiler::SetThreadName("marker", data->id);
 
-                if (result == WAIT_OBJECT_0 + 1) {
-                    EnterCriticalSection(data->cs);
-                    for (int idx : data->markedIndices) {
-                        (*data->array)[idx] = 0;
-                    }
-                    LeaveCriticalSection(data->cs);
-                    return 0;
-                }
-                else if (result == WAIT_OBJECT_0) {
-                    failCount = 0;
-                }
-            }
-        }
-    }
-    return 0;
+    if (data->adaptiveCs) runMarker(data, *data->adaptiveCs);
+    else runMarker(data, *data->cs);
 }
\ No newline at end of file
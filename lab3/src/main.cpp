@@ -1,133 +1,437 @@
-#define NOMINMAX
-#include <windows.h>
+#include "array_snapshot.h"
+#include "cpu_placement.h"
+#include "lock_profiler.h"
+#include "marker_coordinator.h"
+#include "marker_engine.h"
+#include "sync_lab.h"
 #include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
 #include <vector>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cstdlib>
-#include <ctime>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
 
-struct MarkerData {
+struct LabMarker {
     int id;
-    std::vector<int>* arr;
-    std::vector<int> marked;
-    HANDLE startEvent;
-    HANDLE stopEvent;
-    HANDLE continueEvent;
-    HANDLE terminateEvent;
-    CRITICAL_SECTION* cs;
-    bool active;
+    ObservableArray* arr;
+    OwnedCells marked;
+    size_t marks;  // cells marked over the whole run
+    MarkerCoordinator* coordinator;
+    MarkerEngineKind engine;
+    ProfiledMutex* cs;
+    ProfiledAdaptiveMutex* adaptiveCs;
+    StripedLockTable* locks;
+    FreeCellIndex* freeCells;  // set: claim from the index instead of probing
+    unsigned workMs;
+    unsigned blockAfter;
+    bool verbose;
+    const ThreadPlacement* placement;
+    int markers;
+    int first;  // cells [first, last) this marker probes
+    int last;
+    const std::atomic<long long>* resumedAt;
+    MarkerTimes times;
 };
 
-DWORD WINAPI Marker(LPVOID p) {
-    MarkerData* d = (MarkerData*)p;
-    srand(d->id);
-    WaitForSingleObject(d->startEvent, INFINITE);
-    int size = (int)d->arr->size();
+struct SyncLabOptions {
+    int size = 0;
+    int markers = 0;
+    bool headless = false;
+    std::string order = "first";  // first, last, random or a list like 3,1,2
+    unsigned seed = 1;
+    unsigned durationMs = 0;      // 0 = until every marker is terminated
+    unsigned workMs = 5;
+    unsigned monitorMs = 0;
+    PlacementPolicy placement = PLACEMENT_NONE;
+    MarkerEngineKind engine = ENGINE_MUTEX;
+    bool index = false;
+    unsigned blockAfter = 1;      // 1 = block on the first occupied cell
+};
+
+static long long NowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+template<class Sync>
+static void RunMarkerWith(LabMarker* d, Sync sync) {
+    CoordinatorControl control(*d->coordinator, d->id - 1, d->resumedAt, &d->times);
+    MarkerSettings settings = { d->id, d->workMs * 1000, d->blockAfter, d->verbose };
+
+    if (d->freeCells) {
+        IndexedCells select(*d->freeCells, d->id);
+        d->marks = RunMarker(settings, sync, select, control, d->marked);
+    }
+    else {
+        RandomCells select(d->id, d->first, d->last);
+        d->marks = RunMarker(settings, sync, select, control, d->marked);
+    }
+}
 
-    while (d->active) {
-        int idx = rand() % size;
+void Marker(LabMarker* d) {
+    LockProfiler::SetThreadName("marker", d->id);
+    d->placement->Apply(d->id - 1, d->markers);
 
-        EnterCriticalSection(d->cs);
-        if ((*d->arr)[idx] == 0) {
-            Sleep(5);
-            (*d->arr)[idx] = d->id;
-            Sleep(5);
-            d->marked.push_back(idx);
-            LeaveCriticalSection(d->cs);
+    switch (d->engine) {
+    case ENGINE_ADAPTIVE:
+        RunMarkerWith(d, LockedSync<ObservableArray, ProfiledAdaptiveMutex>(*d->arr, *d->adaptiveCs));
+        break;
+    case ENGINE_STRIPED:
+        RunMarkerWith(d, StripedSync<ObservableArray>(*d->arr, *d->locks, 1));
+        break;
+    case ENGINE_LOCKFREE:
+        RunMarkerWith(d, AtomicSync<ObservableArray>(*d->arr));
+        break;
+    default:
+        RunMarkerWith(d, LockedSync<ObservableArray, ProfiledMutex>(*d->arr, *d->cs));
+        break;
+    }
+}
+
+static void PrintArray(const char* title, const ObservableArray& arr) {
+    std::cout << title;
+    for (size_t i = 0; i < arr.Size(); i++) std::cout << arr.Get(i) << " ";
+    std::cout << std::endl;
+}
+
+// Prints a live snapshot every `periodMs` while the markers keep running.
+static void Monitor(const ObservableArray* arr, int markers, unsigned periodMs,
+    const std::atomic<bool>* done) {
+    ArraySnapshot snapshot;
+
+    while (!done->load()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(periodMs));
+        arr->Snapshot(snapshot, markers);
+
+        std::ostringstream line;
+        line << "[monitor] " << (snapshot.consistent ? "consistent" : "per-stripe")
+             << " free=" << snapshot.owned[0];
+        for (int id = 1; id <= markers; id++) {
+            if (snapshot.owned[id]) line << " " << id << ":" << snapshot.owned[id];
         }
-        else {
-            std::cout << "Marker " << d->id << " | " << d->marked.size() << " | " << idx << std::endl;
-            LeaveCriticalSection(d->cs);
-            SetEvent(d->stopEvent);
-
-            HANDLE ev[2] = { d->continueEvent, d->terminateEvent };
-            DWORD res = WaitForMultipleObjects(2, ev, FALSE, INFINITE);
-
-            if (res == WAIT_OBJECT_0 + 1) {
-                EnterCriticalSection(d->cs);
-                for (int i : d->marked) (*d->arr)[i] = 0;
-                LeaveCriticalSection(d->cs);
-                return 0;
+        line << "\n";
+        std::cout << line.str() << std::flush;
+    }
+}
+
+static bool ParseUnsigned(const std::string& text, unsigned& value) {
+    if (text.empty() || text.find_first_not_of("0123456789") != std::string::npos) return false;
+    value = (unsigned)std::strtoul(text.c_str(), nullptr, 10);
+    return true;
+}
+
+static bool SetOption(SyncLabOptions& options, const std::string& key, const std::string& value) {
+    unsigned number;
+    if (key == "order") {
+        options.order = value;
+        return !value.empty();
+    }
+    if (key == "placement") return ParsePlacementPolicy(value, options.placement);
+    if (key == "engine") return ParseMarkerEngine(value, options.engine);
+    if (key == "select") {
+        options.index = value == "index";
+        return value == "index" || value == "random";
+    }
+    if (!ParseUnsigned(value, number)) return false;
+
+    if (key == "size") { options.size = (int)number; options.headless = true; }
+    else if (key == "markers") { options.markers = (int)number; options.headless = true; }
+    else if (key == "seed") options.seed = number;
+    else if (key == "duration-ms") options.durationMs = number;
+    else if (key == "work-ms") options.workMs = number;
+    else if (key == "monitor") options.monitorMs = number;
+    else if (key == "block-after") options.blockAfter = std::max(1u, number);
+    else return false;
+    return true;
+}
+
+// Scenario file: one "key value" or "key=value" per line, keys as the flags
+// without the leading dashes; '#' starts a comment.
+static bool LoadScenario(SyncLabOptions& options, const std::string& path) {
+    std::ifstream in(path);
+    if (!in) {
+        std::cerr << "Cannot open " << path << std::endl;
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(in, line)) {
+        line = line.substr(0, line.find('#'));
+        std::replace(line.begin(), line.end(), '=', ' ');
+        std::istringstream fields(line);
+        std::string key, value;
+        if (!(fields >> key)) continue;
+        if (!(fields >> value) || !SetOption(options, key, value)) {
+            std::cerr << "Invalid scenario line: " << line << std::endl;
+            return false;
+        }
+    }
+    options.headless = true;
+    return true;
+}
+
+static bool ParseArguments(int argc, char* argv[], SyncLabOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.compare(0, 2, "--") != 0 || i + 1 >= argc) return false;
+
+        std::string value = argv[++i];
+        if (arg == "--scenario") {
+            if (!LoadScenario(options, value)) return false;
+        }
+        else if (!SetOption(options, arg.substr(2), value)) {
+            return false;
+        }
+    }
+
+    if (options.headless && (options.size <= 0 || options.markers <= 0)) return false;
+    if (options.order != "first" && options.order != "last" && options.order != "random"
+        && options.order.find_first_not_of("0123456789,") != std::string::npos) {
+        return false;
+    }
+    return true;
+}
+
+// Picks the next marker to terminate (0-based) according to the order policy.
+class TerminationOrder {
+public:
+    TerminationOrder(const SyncLabOptions& options) : policy(options.order), rng(options.seed) {
+        if (policy.find_first_not_of("0123456789,") != std::string::npos) return;
+        std::istringstream items(policy);
+        std::string item;
+        while (std::getline(items, item, ',')) {
+            if (!item.empty()) listed.push_back(std::atoi(item.c_str()) - 1);
+        }
+    }
+
+    int Next(const MarkerCoordinator& coordinator) {
+        int n = coordinator.Markers();
+        while (next < listed.size()) {
+            int id = listed[next++];
+            if (id >= 0 && id < n && coordinator.IsActive(id)) return id;
+        }
+
+        if (policy == "random") {
+            int skip = (int)(rng() % coordinator.Active());
+            for (int i = 0; i < n; i++) {
+                if (coordinator.IsActive(i) && skip-- == 0) return i;
             }
         }
+        if (policy == "last") {
+            int i = n - 1;
+            while (!coordinator.IsActive(i)) i--;
+            return i;
+        }
+        int i = 0;
+        while (!coordinator.IsActive(i)) i++;
+        return i;
     }
-    return 0;
+
+private:
+    std::string policy;
+    std::minstd_rand rng;
+    std::vector<int> listed;
+    size_t next = 0;
+};
+
+static void PrintUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [--monitor ms] [--placement none|compact|scatter|numa]\n"
+              << "           [--engine mutex|adaptive|striped|lockfree] [--select random|index] [--block-after N]\n"
+              << "       " << program << " --size N --markers N [--order first|last|random|3,1,2]\n"
+              << "           [--duration-ms N] [--work-ms N] [--seed N] [--monitor ms] [--placement P]\n"
+              << "           [--engine E] [--select S] [--block-after N]\n"
+              << "       " << program << " --scenario file" << std::endl;
 }
 
-int main() {
-    int size, n;
-    std::cout << "Size: ";
-    std::cin >> size;
-    std::cout << "Markers: ";
-    std::cin >> n;
+int main(int argc, char* argv[]) {
+    SyncLabOptions options;
+    if (!ParseArguments(argc, argv, options)) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    int size = options.size, n = options.markers;
+    if (!options.headless) {
+        std::cout << "Size: ";
+        std::cin >> size;
+        std::cout << "Markers: ";
+        std::cin >> n;
+    }
+    bool verbose = !options.headless;
+
+    ThreadPlacement placement(options.placement, DiscoverTopology());
+    if (verbose) std::cout << "Placement: " << placement.Describe() << std::endl;
 
-    std::vector<int> arr(size, 0);
-    CRITICAL_SECTION cs;
-    InitializeCriticalSection(&cs);
+    // With numa placement each node gets a contiguous part of the array, zeroed
+    // by a thread running on that node so its pages are allocated there, and
+    // markers on the node probe only that part.
+    bool numa = placement.Policy() == PLACEMENT_NUMA && size >= placement.NodeCount();
+    if (numa && placement.NodeCount() > 1 && options.index) {
+        // The index spans the whole array; it cannot keep a marker to its node's part.
+        std::cerr << "--select index cannot be combined with --placement numa on "
+                  << placement.NodeCount() << " nodes" << std::endl;
+        return 1;
+    }
+    ObservableArray arr(size, kCacheLine / sizeof(int), !numa);
+    if (numa) {
+        for (int node = 0; node < placement.NodeCount(); node++) {
+            std::thread toucher([&arr, &placement, node, size]() {
+                placement.ApplyNode(node);
+                arr.InitializeRange((size_t)size * node / placement.NodeCount(),
+                    (size_t)size * (node + 1) / placement.NodeCount());
+            });
+            toucher.join();
+        }
+    }
+    ProfiledMutex cs("SyncLab.cs");
+    ProfiledAdaptiveMutex adaptiveCs("SyncLab.cs");
+    StripedLockTable locks(size > 0 ? size : 1);
+    std::unique_ptr<FreeCellIndex> freeCells;
+    if (options.index) freeCells.reset(new FreeCellIndex(size));
+    if (verbose) {
+        std::cout << "Engine: " << MarkerEngineName(options.engine)
+                  << (options.index ? " + free-cell index" : "") << std::endl;
+    }
 
-    HANDLE start = CreateEvent(NULL, TRUE, FALSE, NULL);
-    HANDLE cont = CreateEvent(NULL, FALSE, FALSE, NULL);
+    MarkerCoordinator coordinator(n);
+    std::atomic<long long> resumedAt(0);
 
-    std::vector<HANDLE> threads(n);
-    std::vector<HANDLE> stop(n);
-    std::vector<HANDLE> term(n);
-    std::vector<MarkerData> data(n);
-    std::vector<bool> active(n, true);
+    std::vector<std::thread> threads(n);
+    std::vector<LabMarker> data(n);
+    std::vector<long long> cleanupNs(n, 0);
 
     for (int i = 0; i < n; i++) {
-        stop[i] = CreateEvent(NULL, FALSE, FALSE, NULL);
-        term[i] = CreateEvent(NULL, FALSE, FALSE, NULL);
         data[i].id = i + 1;
         data[i].arr = &arr;
-        data[i].startEvent = start;
-        data[i].stopEvent = stop[i];
-        data[i].continueEvent = cont;
-        data[i].terminateEvent = term[i];
+        data[i].coordinator = &coordinator;
+        data[i].marks = 0;
+        data[i].engine = options.engine;
         data[i].cs = &cs;
-        data[i].active = true;
-        threads[i] = CreateThread(NULL, 0, Marker, &data[i], 0, NULL);
+        data[i].adaptiveCs = &adaptiveCs;
+        data[i].locks = &locks;
+        data[i].freeCells = freeCells.get();
+        data[i].workMs = options.workMs;
+        data[i].blockAfter = options.blockAfter;
+        data[i].verbose = verbose;
+        data[i].resumedAt = &resumedAt;
+        data[i].placement = &placement;
+        data[i].markers = n;
+        data[i].first = 0;
+        data[i].last = size;
+        if (numa) {
+            int node = placement.NodeFor(i, n);
+            data[i].first = (int)((long long)size * node / placement.NodeCount());
+            data[i].last = (int)((long long)size * (node + 1) / placement.NodeCount());
+        }
+        threads[i] = std::thread(Marker, &data[i]);
     }
 
-    SetEvent(start);
+    std::atomic<bool> done(false);
+    std::thread monitor;
+    if (options.monitorMs) monitor = std::thread(Monitor, &arr, n, options.monitorMs, &done);
 
-    int left = n;
+    TerminationOrder order(options);
+    long long started = NowNs();
+    long long deadline = options.durationMs ? started + options.durationMs * 1000000LL : 0;
+    long long notifyNs = 0;
+    int rounds = 0;
+    bool running = true;
 
-    std::vector<HANDLE> firstWait;
-    for (int i = 0; i < n; i++) firstWait.push_back(stop[i]);
+    coordinator.Start();
 
-    std::cout << "\nWaiting for all markers to block...\n";
-    WaitForMultipleObjects(n, firstWait.data(), TRUE, INFINITE);
+    for (int k = 0; k < n; k++) {
+        if (running) {
+            if (verbose) std::cout << "\nWaiting for all markers to block...\n";
+            coordinator.WaitAllBlocked();
 
-    std::cout << "Array: ";
-    for (int v : arr) std::cout << v << " ";
-    std::cout << std::endl;
+            long long lastBlocked = 0;
+            for (int i = 0; i < n; i++) {
+                if (coordinator.IsActive(i)) lastBlocked = std::max(lastBlocked, data[i].times.blockedAt);
+            }
+            notifyNs += NowNs() - lastBlocked;
+            rounds++;
+        }
+
+        if (verbose) PrintArray("Array: ", arr);
 
-    for (int k = 0; k < n; k++) {
         int kill;
-        if (k == 0) {
-            std::cout << "Enter marker number to terminate: ";
-            std::cin >> kill;
-            kill--;
+        if (options.headless) {
+            kill = order.Next(coordinator);
+        }
+        else if (k == 0) {
+            do {
+                std::cout << "Enter marker number to terminate: ";
+                std::cin >> kill;
+                kill--;
+            } while (std::cin && (kill < 0 || kill >= n));
+            if (!std::cin) kill = 0;
         }
         else {
-            kill = k;
+            kill = order.Next(coordinator);
             std::cout << "Terminating marker " << kill + 1 << " automatically..." << std::endl;
         }
 
-        active[kill] = false;
-        SetEvent(term[kill]);
-        WaitForSingleObject(threads[kill], INFINITE);
-        CloseHandle(threads[kill]);
+        long long terminated = NowNs();
+        coordinator.Terminate(kill);
+        threads[kill].join();
+        cleanupNs[kill] = NowNs() - terminated;
 
-        std::cout << "Array after termination: ";
-        for (int v : arr) std::cout << v << " ";
-        std::cout << std::endl;
+        if (verbose) PrintArray("Array after termination: ", arr);
 
-        if (k < n - 1) {
-            SetEvent(cont);
+        // Once the duration is over the remaining markers stay blocked and are
+        // only terminated.
+        running = !(deadline && NowNs() >= deadline);
+        if (running) {
+            resumedAt.store(NowNs());
+            coordinator.ResumeAll();
         }
     }
 
-    DeleteCriticalSection(&cs);
+    long long elapsed = NowNs() - started;
+    done.store(true);
+    if (monitor.joinable()) monitor.join();
+
+    if (options.headless) {
+        long long marks = 0, resumes = 0, resumeNs = 0, totalCleanupNs = 0;
+
+        std::cout << "size=" << size << " markers=" << n << " order=" << options.order
+                  << " engine=" << MarkerEngineName(options.engine)
+                  << " select=" << (options.index ? "index" : "random")
+                  << " block_after=" << options.blockAfter
+                  << " work_ms=" << options.workMs << " duration_ms=" << options.durationMs
+                  << " placement=" << PlacementPolicyName(placement.Policy())
+                  << " nodes=" << placement.NodeCount() << "\n";
+        std::cout << "marker,marks,resumes,resume_avg_us,resume_max_us,cleanup_us\n";
+        for (int i = 0; i < n; i++) {
+            const LabMarker& d = data[i];
+            const MarkerTimes& t = d.times;
+            marks += d.marks;
+            resumes += t.resumes;
+            resumeNs += t.resumeNs;
+            totalCleanupNs += cleanupNs[i];
+            std::cout << d.id << "," << d.marks << "," << t.resumes << ","
+                      << (t.resumes ? t.resumeNs / t.resumes / 1000.0 : 0.0) << ","
+                      << t.resumeMaxNs / 1000.0 << "," << cleanupNs[i] / 1000.0 << "\n";
+        }
+
+        std::cout << "elapsed_ms=" << elapsed / 1e6
+                  << " marks=" << marks
+                  << " marks_per_sec=" << (elapsed ? marks * 1e9 / elapsed : 0.0)
+                  << " rounds=" << rounds
+                  << " block_notify_avg_us=" << (rounds ? notifyNs / rounds / 1000.0 : 0.0)
+                  << " resume_avg_us=" << (resumes ? resumeNs / resumes / 1000.0 : 0.0)
+                  << " cleanup_avg_us=" << totalCleanupNs / n / 1000.0 << std::endl;
+        return 0;
+    }
+
     std::cout << "Done\n";
     return 0;
 }
\ No newline at end of file
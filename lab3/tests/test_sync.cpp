@@ -1,7 +1,26 @@
 #define NOMINMAX
+#ifdef _WIN32
+#include <windows.h>
+#endif
 #include "sync_lab.h"
+#include "adaptive_mutex.h"
+#include "atomic_marker.h"
+#include "striped_marker.h"
+#include "free_cell_index.h"
+#include "marker_coordinator.h"
+#include "marker_engine.h"
+#include "owned_cells.h"
+#include "array_snapshot.h"
+#include "lock_profiler.h"
+#include "cpu_placement.h"
 #include <cassert>
+#include <cstdint>
 #include <iostream>
+#include <thread>
+#include <chrono>
+#include <memory>
+#include <sstream>
+#include <mutex>
 #include <vector>
 
 void test_array_initialization() {
@@ -15,6 +34,7 @@ void test_array_initialization() {
     std::cout << "PASSED" << std::endl;
 }
 
+#ifdef _WIN32
 void test_event_creation() {
     std::cout << "\n=== Test 2: Event creation ===" << std::endl;
     HANDLE hEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
@@ -25,10 +45,657 @@ void test_event_creation() {
     std::cout << "PASSED" << std::endl;
 }
 
+#endif
+
+void test_atomic_markers() {
+    std::cout << "\n=== Test 3: Lock-free markers ===" << std::endl;
+    const int size = 2000;
+    const int markers = 8;
+
+    std::vector<std::atomic<int>> arr(size);
+    Event start(true, false);
+    Event cont(true, false);
+    std::vector<Event*> stop, term;
+    std::vector<AtomicMarkerData> data(markers);
+    std::vector<std::thread> threads;
+
+    for (int i = 0; i < markers; i++) {
+        stop.push_back(new Event(false, false));
+        term.push_back(new Event(false, false));
+        data[i].id = i + 1;
+        data[i].array = &arr;
+        data[i].startEvent = &start;
+        data[i].stopEvent = stop[i];
+        data[i].continueEvent = &cont;
+        data[i].terminateEvent = term[i];
+        data[i].workUs = 0;
+        data[i].verbose = false;
+    }
+    for (int i = 0; i < markers; i++) threads.emplace_back(atomic_marker_thread, &data[i]);
+
+    start.Set();
+    for (int i = 0; i < markers; i++) stop[i]->Wait();
+
+    size_t marked = 0;
+    for (int i = 0; i < markers; i++) {
+        marked += data[i].markedIndices.size();
+        for (int idx : data[i].markedIndices) assert(arr[idx].load() == i + 1);
+    }
+    size_t nonZero = 0;
+    for (int i = 0; i < size; i++) {
+        if (arr[i].load() != 0) nonZero++;
+    }
+    std::cout << "Input: size=" << size << ", markers=" << markers << std::endl;
+    std::cout << "Output: marked=" << marked << ", non-zero cells=" << nonZero << std::endl;
+    assert(marked == nonZero);
+
+    term[2]->Set();
+    threads[2].join();
+    for (int i = 0; i < size; i++) assert(arr[i].load() != 3);
+    std::cout << "Output: marker 3 cells cleared" << std::endl;
+
+    for (int i = 0; i < markers; i++) {
+        if (i != 2) {
+            term[i]->Set();
+            threads[i].join();
+        }
+    }
+    for (int i = 0; i < size; i++) assert(arr[i].load() == 0);
+    for (int i = 0; i < markers; i++) {
+        delete stop[i];
+        delete term[i];
+    }
+    std::cout << "PASSED" << std::endl;
+}
+
+void test_striped_markers() {
+    std::cout << "\n=== Test 4: Striped markers, 3-cell claims ===" << std::endl;
+    const int size = 1000;
+    const int markers = 6;
+    const int width = 3;
+
+    AlignedArray arr(size, 0);
+    StripedLockTable locks(size);
+    Event start(true, false);
+    Event cont(true, false);
+    std::vector<Event*> stop, term;
+    std::vector<StripedMarkerData> data(markers);
+    std::vector<std::thread> threads;
+
+    assert(reinterpret_cast<uintptr_t>(arr.data()) % kCacheLine == 0);
+    assert(locks.StripeCount() == (size + 15) / 16);
+
+    for (int i = 0; i < markers; i++) {
+        stop.push_back(new Event(false, false));
+        term.push_back(new Event(false, false));
+        data[i].id = i + 1;
+        data[i].array = &arr;
+        data[i].locks = &locks;
+        data[i].startEvent = &start;
+        data[i].stopEvent = stop[i];
+        data[i].continueEvent = &cont;
+        data[i].terminateEvent = term[i];
+        data[i].claimWidth = width;
+        data[i].workUs = 0;
+        data[i].verbose = false;
+    }
+    for (int i = 0; i < markers; i++) threads.emplace_back(striped_marker_thread, &data[i]);
+
+    start.Set();
+    for (int i = 0; i < markers; i++) stop[i]->Wait();
+
+    size_t marked = 0;
+    for (int i = 0; i < markers; i++) {
+        std::vector<int> idx(data[i].markedIndices.begin(), data[i].markedIndices.end());
+        assert(idx.size() % width == 0);
+        for (size_t k = 0; k < idx.size(); k += width) {
+            for (int w = 0; w < width; w++) {
+                assert(idx[k + w] == idx[k] + w);
+                assert(arr[idx[k + w]] == i + 1);
+            }
+        }
+        marked += idx.size();
+    }
+    std::cout << "Input: size=" << size << ", markers=" << markers << ", width=" << width << std::endl;
+    std::cout << "Output: marked=" << marked << " in runs of " << width << std::endl;
+
+    for (int i = 0; i < markers; i++) {
+        term[i]->Set();
+        threads[i].join();
+        delete stop[i];
+        delete term[i];
+    }
+    for (int i = 0; i < size; i++) assert(arr[i] == 0);
+    std::cout << "Output: all stripes cleared" << std::endl;
+    std::cout << "PASSED" << std::endl;
+}
+
+void test_free_cell_index() {
+    std::cout << "\n=== Test 5: Free-cell index ===" << std::endl;
+    const int size = 5000;
+    const int threads = 4;
+
+    FreeCellIndex index(size);
+    std::vector<std::atomic<int>> owner(size);
+    std::vector<std::thread> workers;
+
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&, t]() {
+            uint64_t random = t;
+            long cell;
+            while ((cell = index.ClaimRandom(random++ * 7919)) >= 0) {
+                int expected = 0;
+                bool first = owner[cell].compare_exchange_strong(expected, t + 1);
+                assert(first);
+                (void)first;
+            }
+        });
+    }
+    for (auto& w : workers) w.join();
+
+    int claimed = 0;
+    for (int i = 0; i < size; i++) {
+        if (owner[i].load() != 0) claimed++;
+    }
+    std::cout << "Input: size=" << size << ", " << threads << " claiming threads" << std::endl;
+    std::cout << "Output: claimed=" << claimed << ", free=" << index.FreeCount() << std::endl;
+    assert(claimed == size);
+    assert(index.FreeCount() == 0);
+    assert(index.ClaimRandom(12345) == -1);
+
+    index.Release(4321);
+    index.Release(17);
+    assert(index.FreeCount() == 2);
+    long a = index.ClaimRandom(1);
+    long b = index.ClaimRandom(2);
+    std::cout << "Output: reclaimed " << a << ", " << b << " (expected: 17 and 4321)" << std::endl;
+    assert(a != b && (a == 17 || a == 4321) && (b == 17 || b == 4321));
+    assert(index.ClaimRandom(3) == -1);
+
+    index.Release(100);
+    assert(!index.Claim(101));
+    assert(index.Claim(100));
+    assert(!index.Claim(100));
+    std::cout << "PASSED" << std::endl;
+}
+
+void test_futex_events() {
+    std::cout << "\n=== Test 6: Futex events ===" << std::endl;
+
+    Event manual(true, false);
+    Event autoReset(false, true);
+    assert(!manual.IsSet() && autoReset.IsSet());
+
+    autoReset.Wait();
+    assert(!autoReset.IsSet());
+    manual.Set();
+    manual.Wait();
+    manual.Wait();
+    assert(manual.IsSet());
+    manual.Reset();
+    std::cout << "Input: manual/auto reset semantics" << std::endl;
+    std::cout << "Output: auto consumed by wait, manual stays signaled" << std::endl;
+
+    Event a(false, false), b(false, false);
+    Event* pair[2] = { &a, &b };
+    std::thread setter([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        b.Set();
+    });
+    int got = WaitAny(pair, 2);
+    setter.join();
+    std::cout << "Output: WaitAny woke on " << got << " (expected: 1)" << std::endl;
+    assert(got == 1 && !b.IsSet());
+
+    const int count = 16;
+    std::vector<std::unique_ptr<Event>> events;
+    std::vector<Event*> raw;
+    for (int i = 0; i < count; i++) {
+        events.emplace_back(new Event(false, false));
+        raw.push_back(events.back().get());
+    }
+    std::vector<std::thread> setters;
+    for (int i = 0; i < count; i++) {
+        setters.emplace_back([&, i]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(i));
+            raw[i]->Set();
+        });
+    }
+    WaitAll(raw.data(), count);
+    for (auto& t : setters) t.join();
+    for (int i = 0; i < count; i++) assert(!raw[i]->IsSet());
+    std::cout << "Output: WaitAll consumed " << count << " auto-reset events" << std::endl;
+
+    a.Set();
+    Event* partial[2] = { &a, &b };
+    std::thread late([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        assert(a.IsSet());
+        b.Set();
+    });
+    WaitAll(partial, 2);
+    late.join();
+    assert(!a.IsSet() && !b.IsSet());
+
+    std::cout << "PASSED" << std::endl;
+}
+
+static void run_marker_threads(bool adaptive) {
+    const int size = 500;
+    const int markers = 4;
+
+    std::vector<int> arr(size, 0);
+    ProfiledMutex cs("test.cs");
+    ProfiledAdaptiveMutex adaptiveCs("test.adaptive_cs");
+    Event start(true, false);
+    Event cont(true, false);
+    std::vector<std::unique_ptr<Event>> stop, term;
+    std::vector<MarkerData> data(markers);
+    std::vector<std::thread> threads;
+
+    for (int i = 0; i < markers; i++) {
+        stop.emplace_back(new Event(false, false));
+        term.emplace_back(new Event(false, false));
+        data[i].id = i + 1;
+        data[i].array = &arr;
+        data[i].startEvent = &start;
+        data[i].stopEvent = stop[i].get();
+        data[i].continueEvent = &cont;
+        data[i].terminateEvent = term[i].get();
+        data[i].cs = &cs;
+        data[i].adaptiveCs = adaptive ? &adaptiveCs : nullptr;
+        data[i].active = true;
+        data[i].workUs = 0;
+    }
+    for (int i = 0; i < markers; i++) threads.emplace_back(marker_thread, &data[i]);
+
+    start.Set();
+    std::vector<Event*> stops;
+    for (auto& e : stop) stops.push_back(e.get());
+    WaitAll(stops.data(), markers);
+
+    size_t marked = 0;
+    for (auto& d : data) marked += d.markedIndices.size();
+    std::cout << "Input: size=" << size << ", markers=" << markers
+              << ", lock=" << (adaptive ? "adaptive" : "std") << std::endl;
+    std::cout << "Output: marked=" << marked << std::endl;
+
+    for (int i = 0; i < markers; i++) {
+        term[i]->Set();
+        threads[i].join();
+    }
+    for (int v : arr) assert(v == 0);
+}
+
+void test_marker_thread() {
+    std::cout << "\n=== Test 7: marker_thread ===" << std::endl;
+    run_marker_threads(false);
+    run_marker_threads(true);
+    std::cout << "PASSED" << std::endl;
+}
+
+void test_marker_coordinator() {
+    std::cout << "\n=== Test 8: Marker coordinator ===" << std::endl;
+    const int markers = 256;
+    MarkerCoordinator coordinator(markers);
+    std::vector<int> resumed(markers, 0);
+    std::vector<std::thread> threads;
+
+    for (int i = 0; i < markers; i++) {
+        threads.emplace_back([&coordinator, &resumed, i]() {
+            coordinator.WaitStart();
+            while (coordinator.Block(i) == MARKER_CONTINUE) resumed[i]++;
+        });
+    }
+
+    coordinator.Start();
+    for (int k = 0; k < markers; k++) {
+        coordinator.WaitAllBlocked();
+        assert(coordinator.Active() == markers - k);
+        coordinator.Terminate(k);
+        threads[k].join();
+        assert(!coordinator.IsActive(k));
+        coordinator.ResumeAll();
+    }
+
+    std::cout << "Input: markers=" << markers << std::endl;
+    std::cout << "Output: active=" << coordinator.Active() << std::endl;
+    assert(coordinator.Active() == 0);
+    for (int i = 0; i < markers; i++) assert(resumed[i] == i);
+    std::cout << "PASSED" << std::endl;
+}
+
+void test_array_snapshot() {
+    std::cout << "\n=== Test 9: Array snapshots ===" << std::endl;
+    const int writers = 4;
+    const size_t size = 1024;
+    const size_t stripe = 16;
+    ObservableArray arr(size, stripe);
+    std::atomic<bool> stop(false);
+    std::vector<std::thread> threads;
+
+    // Each writer owns every writers-th stripe and moves one token through them,
+    // so any real state of the array holds one or two cells per writer. The
+    // tokens are placed before the writers start, so no snapshot misses one.
+    for (int w = 0; w < writers; w++) arr.Set(w * stripe, w + 1);
+    for (int w = 0; w < writers; w++) {
+        threads.emplace_back([&arr, &stop, w]() {
+            size_t pos = w * stripe;
+            while (!stop.load()) {
+                size_t next = (pos + 3 * writers * stripe) % size;
+                arr.Set(next, w + 1);
+                arr.Set(pos, 0);
+                pos = next;
+                std::this_thread::yield();
+            }
+        });
+    }
+
+    ArraySnapshot snapshot;
+    int consistent = 0;
+    for (int i = 0; i < 500; i++) {
+        arr.Snapshot(snapshot, writers);
+        if (!snapshot.consistent) continue;
+        consistent++;
+        for (int w = 1; w <= writers; w++) {
+            assert(snapshot.owned[w] >= 1 && snapshot.owned[w] <= 2);
+        }
+    }
+    assert(consistent > 0);
+
+    stop.store(true);
+    for (auto& t : threads) t.join();
+
+    arr.Snapshot(snapshot, writers);
+    assert(snapshot.consistent && snapshot.attempts == 1);
+    assert(snapshot.owned[0] == size - writers);
+    for (int w = 1; w <= writers; w++) assert(snapshot.owned[w] == 1);
+
+    std::cout << "Input: size=" << size << ", writers=" << writers << std::endl;
+    std::cout << "Output: consistent snapshots while writing=" << consistent << "/500" << std::endl;
+    std::cout << "PASSED" << std::endl;
+}
+
+void test_lock_profiler() {
+    std::cout << "\n=== Test 10: Lock profiler ===" << std::endl;
+    const int threadCount = 4;
+    const int iterations = 2000;
+    ProfiledMutex lock("test.profiled");
+    long long counter = 0;
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < threadCount; t++) {
+        threads.emplace_back([&lock, &counter, t]() {
+            LockProfiler::SetThreadName("worker", t + 1);
+            for (int i = 0; i < iterations; i++) {
+                std::lock_guard<ProfiledMutex> guard(lock);
+                counter++;
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+    assert(counter == threadCount * iterations);
+
+    std::ostringstream report, folded;
+    LockProfiler::WriteReport(report);
+    LockProfiler::WriteFolded(folded);
+#ifdef SYNC_LOCK_PROFILE
+    assert(report.str().find("lock test.profiled: acquisitions=8000") != std::string::npos);
+    assert(report.str().find("  worker 1: acquisitions=2000") != std::string::npos);
+    assert(folded.str().find("worker 1;test.profiled;hold ") != std::string::npos);
+#else
+    assert(report.str().empty() && folded.str().empty());
+    static_assert(sizeof(ProfiledMutex) == sizeof(std::mutex), "profiling off must cost nothing");
+#endif
+
+    std::cout << "Input: threads=" << threadCount << ", iterations=" << iterations << std::endl;
+    std::cout << "Output: counter=" << counter << std::endl;
+    std::cout << "PASSED" << std::endl;
+}
+
+void test_adaptive_mutex() {
+    std::cout << "\n=== Test 11: Adaptive mutex ===" << std::endl;
+    const int threadCount = 4;
+    const int iterations = 20000;
+    AdaptiveMutex mutex;
+    long long counter = 0;
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < threadCount; t++) {
+        threads.emplace_back([&mutex, &counter]() {
+            for (int i = 0; i < iterations; i++) {
+                std::lock_guard<AdaptiveMutex> guard(mutex);
+                counter++;
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+    assert(counter == (long long)threadCount * iterations);
+
+    // Holds of a few microseconds are worth spinning for...
+    for (int i = 0; i < 64; i++) {
+        std::lock_guard<AdaptiveMutex> guard(mutex);
+        auto until = std::chrono::steady_clock::now() + std::chrono::microseconds(5);
+        while (std::chrono::steady_clock::now() < until) {}
+    }
+    uint32_t shortHoldBudget = mutex.SpinBudget();
+    assert(shortHoldBudget > AdaptiveMutex::kMinSpin);
+
+    // ...sleeping ones must teach the lock to park instead.
+    for (int i = 0; i < 64; i++) {
+        std::lock_guard<AdaptiveMutex> guard(mutex);
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    assert(mutex.SpinBudget() == AdaptiveMutex::kMinSpin);
+    assert(mutex.try_lock());
+    assert(!mutex.try_lock());
+    mutex.unlock();
+
+    std::cout << "Input: threads=" << threadCount << ", iterations=" << iterations << std::endl;
+    std::cout << "Output: counter=" << counter << ", spin budget after 5us holds=" << shortHoldBudget
+              << ", after 200us holds=" << mutex.SpinBudget() << std::endl;
+    std::cout << "PASSED" << std::endl;
+}
+
+void test_cpu_placement() {
+    std::cout << "\n=== Test 12: CPU placement ===" << std::endl;
+    // Two nodes, two cores per node, two hardware threads per core; the
+    // siblings are numbered like Linux does it (cpu c and c + 4 share a core).
+    CpuTopology topology;
+    topology.nodeCount = 2;
+    for (int c = 0; c < 8; c++) {
+        int core = c % 4;
+        topology.cpus.push_back({ c, core / 2, core / 2, core % 2, c / 4 });
+    }
+
+    ThreadPlacement compact(PLACEMENT_COMPACT, topology);
+    ThreadPlacement scatter(PLACEMENT_SCATTER, topology);
+    ThreadPlacement numa(PLACEMENT_NUMA, topology);
+    ThreadPlacement none(PLACEMENT_NONE, topology);
+
+    int compactCpus[8] = { 0, 4, 1, 5, 2, 6, 3, 7 };
+    int scatterCpus[8] = { 0, 2, 1, 3, 4, 6, 5, 7 };
+    for (int w = 0; w < 8; w++) {
+        assert(compact.CpuFor(w, 8) == compactCpus[w]);
+        assert(scatter.CpuFor(w, 8) == scatterCpus[w]);
+        assert(numa.NodeFor(w, 8) == w / 4);
+        assert(topology.cpus[numa.CpuFor(w, 8)].node == w / 4);
+        assert(none.CpuFor(w, 8) == -1);
+    }
+
+    int first, last;
+    numa.NodeWorkers(1, 6, first, last);
+    assert(first == 3 && last == 6);
+
+    CpuTopology local = DiscoverTopology();
+    assert(!local.cpus.empty() && local.nodeCount >= 1);
+    ThreadPlacement pinned(PLACEMENT_COMPACT, local);
+    bool applied = false;
+    std::thread worker([&pinned, &applied]() { applied = pinned.Apply(0, 1); });
+    worker.join();
+
+    std::cout << "Input: 2 nodes x 2 cores x 2 threads" << std::endl;
+    std::cout << "Output: this machine " << pinned.Describe() << ", pinned=" << applied << std::endl;
+    std::cout << "PASSED" << std::endl;
+}
+
+void test_marker_engine() {
+    std::cout << "\n=== Test 13: Marker engine ===" << std::endl;
+    const size_t size = 512;
+    const int markers = 6;
+    const char* engines[] = { "mutex", "adaptive", "striped", "lockfree" };
+
+    for (const char* name : engines) {
+        for (int index = 0; index < 2; index++) {
+            MarkerEngineKind engine;
+            assert(ParseMarkerEngine(name, engine));
+            assert(std::string(MarkerEngineName(engine)) == name);
+
+            ObservableArray arr(size);
+            MarkerCoordinator coordinator(markers);
+            ProfiledMutex cs("test.engine_cs");
+            ProfiledAdaptiveMutex adaptiveCs("test.engine_adaptive_cs");
+            StripedLockTable locks(size);
+            FreeCellIndex freeCells(size);
+            std::vector<OwnedCells> owned(markers);
+            std::vector<size_t> marks(markers, 0);
+
+            auto run = [&](int m, auto sync) {
+                CoordinatorControl control(coordinator, m);
+                MarkerSettings settings = { m + 1, 0, (unsigned)size * 2 + 1, false };
+                if (index) {
+                    IndexedCells select(freeCells, m + 1);
+                    marks[m] = RunMarker(settings, sync, select, control, owned[m]);
+                }
+                else {
+                    RandomCells select(m + 1, 0, size);
+                    marks[m] = RunMarker(settings, sync, select, control, owned[m]);
+                }
+            };
+
+            std::vector<std::thread> threads;
+            for (int m = 0; m < markers; m++) {
+                threads.emplace_back([&, m]() {
+                    switch (engine) {
+                    case ENGINE_ADAPTIVE: run(m, LockedSync<ObservableArray, ProfiledAdaptiveMutex>(arr, adaptiveCs)); break;
+                    case ENGINE_STRIPED: run(m, StripedSync<ObservableArray>(arr, locks, 1)); break;
+                    case ENGINE_LOCKFREE: run(m, AtomicSync<ObservableArray>(arr)); break;
+                    default: run(m, LockedSync<ObservableArray, ProfiledMutex>(arr, cs)); break;
+                    }
+                });
+            }
+
+            coordinator.Start();
+            coordinator.WaitAllBlocked();
+
+            // Every cell recorded as owned carries its owner's id, and no
+            // cell is owned twice.
+            size_t claimed = 0;
+            for (int m = 0; m < markers; m++) {
+                for (int cell : owned[m]) assert(arr.Get(cell) == m + 1);
+                claimed += owned[m].size();
+            }
+            size_t nonZero = 0;
+            for (size_t i = 0; i < size; i++) nonZero += arr.Get(i) != 0;
+            assert(claimed == nonZero);
+            if (index) assert(claimed == size);
+
+            for (int m = 0; m < markers; m++) {
+                coordinator.Terminate(m);
+                threads[m].join();
+                assert(owned[m].empty());
+            }
+
+            size_t total = 0;
+            for (size_t n : marks) total += n;
+            assert(total == claimed);
+            for (size_t i = 0; i < size; i++) assert(arr.Get(i) == 0);
+            if (index) assert(freeCells.FreeCount() == size);
+
+            std::cout << name << (index ? "+index" : "+random") << ": " << claimed << " cells" << std::endl;
+        }
+    }
+
+    std::cout << "PASSED" << std::endl;
+}
+
+struct CountingLock {
+    int acquisitions = 0;
+    bool held = false;
+    void lock() { assert(!held); held = true; acquisitions++; }
+    void unlock() { held = false; }
+};
+
+void test_owned_cells() {
+    std::cout << "\n=== Test 14: Ownership bitmap cleanup ===" << std::endl;
+    const size_t size = 10000;
+    OwnedCells owned(size);
+    std::vector<int> arr(size, 0);
+
+    // Every third cell, plus a duplicate push that must not count twice.
+    for (size_t i = 0; i < size; i += 3) {
+        arr[i] = 7;
+        owned.push_back((int)i);
+    }
+    owned.push_back(0);
+    assert(owned.size() == (size + 2) / 3);
+    assert(owned.Contains(9999) && !owned.Contains(9998));
+
+    int previous = -1;
+    size_t listed = 0;
+    for (int cell : owned) {
+        assert(cell > previous && cell % 3 == 0);
+        previous = cell;
+        listed++;
+    }
+    assert(listed == owned.size());
+
+    // The single lock is dropped every kReleaseWords words.
+    CountingLock lock;
+    FreeCellIndex index(size);
+    for (int cell : owned) assert(index.Claim(cell));
+    LockedSync<std::vector<int>, CountingLock> sync(arr, lock);
+    sync.Release(owned, [&index](size_t first, uint64_t mask) { index.ReleaseMask(first, mask); });
+
+    size_t words = (size + 63) / 64;
+    size_t chunk = LockedSync<std::vector<int>, CountingLock>::kReleaseWords;
+    assert(lock.acquisitions == (int)((words + chunk - 1) / chunk));
+    for (size_t i = 0; i < size; i++) assert(arr[i] == 0);
+    assert(index.FreeCount() == size);
+
+    ObservableArray observable(200);
+    for (size_t i = 64; i < 128; i++) observable.Set(i, 3);
+    observable.ClearMasked(64, 0xFFFF0000FFFF0000ULL);
+    for (size_t i = 64; i < 128; i++) {
+        assert(observable.Get(i) == (((i - 64) / 16) % 2 ? 0 : 3));
+    }
+
+    owned.clear();
+    assert(owned.empty() && owned.begin() == owned.end());
+
+    std::cout << "Input: size=" << size << ", every third cell owned" << std::endl;
+    std::cout << "Output: " << listed << " cells cleared in " << lock.acquisitions << " lock holds" << std::endl;
+    std::cout << "PASSED" << std::endl;
+}
+
 int main() {
     std::cout << "SYNCHRONIZATION LAB TESTS" << std::endl;
     test_array_initialization();
+#ifdef _WIN32
     test_event_creation();
+#endif
+    test_atomic_markers();
+    test_striped_markers();
+    test_free_cell_index();
+    test_futex_events();
+    test_marker_thread();
+    test_marker_coordinator();
+    test_array_snapshot();
+    test_lock_profiler();
+    test_adaptive_mutex();
+    test_cpu_placement();
+    test_marker_engine();
+    test_owned_cells();
     std::cout << "\nALL TESTS PASSED" << std::endl;
     return 0;
 }
\ No newline at end of file
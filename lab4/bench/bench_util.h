@@ -0,0 +1,31 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Option parsing and latency percentiles shared by the benchmarks.
+
+inline std::vector<std::string> splitList(const std::string& text) {
+    std::vector<std::string> items;
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ',')) items.push_back(item);
+    return items;
+}
+
+inline std::vector<int> splitInts(const std::string& text) {
+    std::vector<int> values;
+    for (const auto& item : splitList(text)) values.push_back(std::atoi(item.c_str()));
+    return values;
+}
+
+// sortedNs ascending; fraction 0.5 is the median.
+inline double percentileUs(const std::vector<int64_t>& sortedNs, double fraction) {
+    if (sortedNs.empty()) return 0;
+    size_t index = std::min(sortedNs.size() - 1, (size_t)(fraction * sortedNs.size()));
+    return sortedNs[index] / 1000.0;
+}
@@ -0,0 +1,126 @@
+#include "bench_util.h"
+#include "shm_queue.h"
+#include "queue_futex.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Prints CSV: durability,senders,messages,flushes,p50_us,p99_us,max_us,msgs_per_sec
+// Each sender thread times every Send until it returns, i.e. until the
+// message is acknowledged under that mode; one reader drains meanwhile.
+//   memory - ShmQueue in shared memory, never synced
+//   async  - the queue file, synced by the flusher every --interval ms
+//   group  - the queue file, every Send waits for a covering fdatasync
+// Usage: durability_bench [--modes memory,async,group] [--senders 1,2,4,8]
+//        [--messages N] [--capacity N] [--interval MS] [--file PATH]
+
+namespace {
+
+struct BenchConfig {
+    std::vector<std::string> modes = { "memory", "async", "group" };
+    std::vector<int> senderCounts = { 1, 2, 4, 8 };
+    int messages = 2000;  // per sender
+    int capacity = 256;
+    int intervalMs = kDefaultFlushIntervalMs;
+    std::string file = "durability_bench.bin";
+};
+
+bool runMode(const BenchConfig& config, QueueDurability durability, int senders) {
+    ShmQueue queue;
+    std::string regionName = SharedRegionName(config.file);
+    std::remove(config.file.c_str());
+    bool created = durability == DURABILITY_MEMORY
+        ? queue.Create(regionName, config.capacity)
+        : queue.CreateDurable(config.file, config.capacity, durability, config.intervalMs);
+    if (!created) {
+        std::cerr << "Failed to create the " << QueueDurabilityName(durability) << " queue" << std::endl;
+        return false;
+    }
+
+    const size_t total = (size_t)senders * config.messages;
+    std::vector<std::vector<int64_t>> latencies(senders);
+    std::atomic<bool> failed(false);
+    std::atomic<bool> sendersDone(false);
+
+    int64_t start = QueueClockNs();
+    std::thread reader([&queue, &sendersDone, total]() {
+        std::vector<ReceivedMessage> out;
+        for (size_t received = 0; received < total;) {
+            size_t batch = queue.ReadBatch(out, SIZE_MAX, 100);
+            if (batch == 0 && sendersDone) break;
+            received += batch;
+        }
+    });
+
+    std::vector<std::thread> threads;
+    for (int s = 0; s < senders; s++) {
+        threads.emplace_back([&, s]() {
+            latencies[s].reserve(config.messages);
+            for (int i = 0; i < config.messages; i++) {
+                int64_t sent = QueueClockNs();
+                if (!queue.Send("bench")) failed = true;
+                latencies[s].push_back(QueueClockNs() - sent);
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+    sendersDone = true;
+    reader.join();
+    int64_t elapsed = QueueClockNs() - start;
+
+    std::vector<int64_t> all;
+    for (const auto& l : latencies) all.insert(all.end(), l.begin(), l.end());
+    std::sort(all.begin(), all.end());
+
+    std::cout << QueueDurabilityName(durability) << "," << senders << "," << total << ","
+        << queue.Flushes() << "," << percentileUs(all, 0.50) << "," << percentileUs(all, 0.99) << ","
+        << all.back() / 1000.0 << "," << (long long)(total * 1e9 / elapsed) << std::endl;
+
+    queue.Close();
+    if (durability == DURABILITY_MEMORY) ShmQueue::Remove(regionName);
+    else std::remove(config.file.c_str());
+    return !failed;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    BenchConfig config;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string option = argv[i];
+        std::string value = argv[i + 1];
+        if (option == "--modes") config.modes = splitList(value);
+        else if (option == "--senders") config.senderCounts = splitInts(value);
+        else if (option == "--messages") config.messages = std::atoi(value.c_str());
+        else if (option == "--capacity") config.capacity = std::atoi(value.c_str());
+        else if (option == "--interval") config.intervalMs = std::atoi(value.c_str());
+        else if (option == "--file") config.file = value;
+        else {
+            std::cerr << "Unknown option: " << option << std::endl;
+            return 1;
+        }
+    }
+    if (config.messages <= 0 || config.capacity <= 0) {
+        std::cerr << "--messages and --capacity must be positive" << std::endl;
+        return 1;
+    }
+
+    std::cout << "durability,senders,messages,flushes,p50_us,p99_us,max_us,msgs_per_sec" << std::endl;
+    bool ok = true;
+    for (const auto& mode : config.modes) {
+        QueueDurability durability;
+        if (!ParseQueueDurability(mode, durability)) {
+            std::cerr << "Unknown durability: " << mode << std::endl;
+            return 1;
+        }
+        for (int senders : config.senderCounts) {
+            if (senders > 0) ok = runMode(config, durability, senders) && ok;
+        }
+    }
+    return ok ? 0 : 1;
+}
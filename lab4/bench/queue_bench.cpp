@@ -0,0 +1,361 @@
+#include "bench_util.h"
+#include "byte_ring.h"
+#include "mpsc_ring.h"
+#include "partitioned_queue.h"
+#include "priority_queue.h"
+#include "queue_backend.h"
+#include "queue_futex.h"
+#include "shm_queue.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Prints one row per run, CSV or --format json (one object per line):
+//   backend,senders,receivers,size,capacity,batch,messages,seconds,
+//   msgs_per_sec,p50_us,p99_us,p999_us,max_us
+// Every sender and receiver is its own process. Each message starts with
+// its send time on the monotonic clock, which all processes share, and the
+// receiver that takes it records now minus that: the end-to-end latency,
+// queueing included. Throughput runs from releasing the senders to the last
+// message received. Messages are at least 20 bytes, the room the send
+// time takes. A run that fails reports it on stderr and prints no row.
+// Backends:
+//   shm         - ShmQueue, any number of receivers; messages up to MAX_MESSAGE_LEN
+//   ring        - MpscRing sized to the message, one receiver, capacity 2 or more
+//   varlen      - ByteRing with the message size as its maximum, one receiver
+//   partitioned - PartitionedQueue with one partition per receiver
+//   priority    - PriorityQueue, one receiver; the budget is the capacity and
+//                 senders take the levels in turn, strict priority
+// Usage: queue_bench [--backends shm,ring,varlen,partitioned,priority] [--senders 1,4]
+//        [--receivers 1,2] [--sizes 20,256,4096] [--capacities 64,1024]
+//        [--batches 1,16] [--messages N] [--format csv|json]
+
+namespace {
+
+struct BenchConfig {
+    std::vector<std::string> backends = { "shm", "ring", "varlen", "partitioned", "priority" };
+    std::vector<int> senderCounts = { 1, 4 };
+    std::vector<int> receiverCounts = { 1, 2 };
+    std::vector<int> sizes = { 20, 256, 4096 };
+    std::vector<int> capacities = { 64, 1024 };
+    std::vector<int> batches = { 1, 16 };
+    int messages = 20000;  // per sender
+    bool json = false;
+};
+
+struct RunSpec {
+    QueueBackend backend;
+    int senders;
+    int receivers;
+    int size;
+    int capacity;
+    int batch;
+    int messages;
+    std::string queueName;
+};
+
+// Shared between the parent and its workers; latency samples follow it.
+struct BenchShared {
+    std::atomic<uint32_t> ready;     // workers attached to the queue
+    std::atomic<uint32_t> go;        // set by the parent once all are ready
+    std::atomic<uint64_t> received;  // messages taken by all receivers
+    std::atomic<int64_t> startNs;
+    std::atomic<int64_t> finishNs;   // when the last message was received
+    int64_t samples[1];
+};
+
+const int kIdleLimitMs = 5000;  // a receiver gives up after this long without a message
+const int kStampBytes = 20;     // smallest message: room for the send time
+const int kBenchPriorities = 2; // levels of the priority backend
+
+// Send time in decimal, padded to the message size; text so that every
+// backend carries it, ShmQueue's NUL-terminated slots included.
+std::string stampedMessage(int size) {
+    std::string text = std::to_string(QueueClockNs());
+    if ((int)text.size() < size) text.resize(size, 'x');
+    return text;
+}
+
+// One queue handle per worker, whatever the backend.
+class BenchQueue {
+public:
+    BenchQueue(const RunSpec& spec) : spec(spec) {}
+
+    bool Create() {
+        switch (spec.backend) {
+        case BACKEND_SHM: return shm.Create(spec.queueName, spec.capacity);
+        case BACKEND_RING: return ring.Create(spec.queueName, spec.capacity, spec.size);
+        case BACKEND_VARLEN:
+            return varlen.Create(spec.queueName, spec.capacity * ByteRing::RecordBytes(spec.size), spec.size);
+        case BACKEND_PARTITIONED:
+            return partitioned.Create(spec.queueName, spec.receivers,
+                std::max(spec.capacity / spec.receivers, kMinRingCapacity), spec.size);
+        case BACKEND_PRIORITY: return priority.Create(spec.queueName, kBenchPriorities, spec.capacity, 0, 0, spec.size);
+        default: return false;
+        }
+    }
+
+    bool Open(bool receiver) {
+        switch (spec.backend) {
+        case BACKEND_SHM: return shm.Open(spec.queueName);
+        case BACKEND_RING: return ring.Open(spec.queueName);
+        case BACKEND_VARLEN: return varlen.Open(spec.queueName);
+        case BACKEND_PARTITIONED: return partitioned.Open(spec.queueName) && (!receiver || partitioned.Join());
+        case BACKEND_PRIORITY: return priority.Open(spec.queueName);
+        default: return false;
+        }
+    }
+
+    void Remove() {
+        SharedRegion::Remove(spec.queueName);
+    }
+
+    // level is the priority backend's; the others have none.
+    size_t SendBatch(const std::vector<std::string>& texts, int level) {
+        if (spec.backend == BACKEND_SHM) return shm.SendBatch(texts);
+        if (spec.backend == BACKEND_RING) return ring.SendBatch(texts);
+        if (spec.backend == BACKEND_PRIORITY) return priority.SendBatch(texts, level);
+
+        size_t sent = 0;
+        for (const auto& text : texts) {
+            bool ok = spec.backend == BACKEND_VARLEN ? varlen.Send(text) : partitioned.Send(text);
+            if (!ok) break;
+            sent++;
+        }
+        return sent;
+    }
+
+    size_t ReadBatch(std::vector<ReceivedMessage>& out, int timeoutMs) {
+        switch (spec.backend) {
+        case BACKEND_SHM: return shm.ReadBatch(out, spec.batch, timeoutMs);
+        case BACKEND_RING: return ring.ReadBatch(out, spec.batch, timeoutMs);
+        case BACKEND_VARLEN: return varlen.ReadBatch(out, spec.batch, timeoutMs);
+        case BACKEND_PARTITIONED: return partitioned.ReadBatch(out, spec.batch, timeoutMs);
+        case BACKEND_PRIORITY: return priority.ReadBatch(out, spec.batch, timeoutMs);
+        default: return 0;
+        }
+    }
+
+private:
+    RunSpec spec;
+    ShmQueue shm;
+    MpscRing ring;
+    ByteRing varlen;
+    PartitionedQueue partitioned;
+    PriorityQueue priority;
+};
+
+// The Linux process backend: the worker runs in a forked child, which exits
+// with its return code. Everything it needs was set up before the fork.
+pid_t spawnWorker(const std::function<int()>& worker) {
+    std::cout.flush();  // or the child would print the parent's buffered output again
+    pid_t child = fork();
+    if (child == 0) _exit(worker());
+    return child;
+}
+
+void waitForGo(BenchShared* shared) {
+    while (!shared->go.load(std::memory_order_acquire)) QueueWait(&shared->go, 0, 100);
+}
+
+int runSender(const RunSpec& spec, BenchShared* shared, int index) {
+    BenchQueue queue(spec);
+    if (!queue.Open(false)) return 1;
+    shared->ready.fetch_add(1);
+    waitForGo(shared);
+
+    std::vector<std::string> texts;
+    for (int sent = 0; sent < spec.messages;) {
+        texts.clear();
+        int batch = std::min(spec.batch, spec.messages - sent);
+        for (int i = 0; i < batch; i++) texts.push_back(stampedMessage(spec.size));
+        if (queue.SendBatch(texts, index % kBenchPriorities) != texts.size()) return 2;
+        sent += batch;
+    }
+    return 0;
+}
+
+int runReceiver(const RunSpec& spec, BenchShared* shared) {
+    BenchQueue queue(spec);
+    if (!queue.Open(true)) return 1;
+    shared->ready.fetch_add(1);
+    waitForGo(shared);
+
+    const uint64_t total = (uint64_t)spec.senders * spec.messages;
+    std::vector<ReceivedMessage> out;
+    int idleMs = 0;
+    while (shared->received.load(std::memory_order_acquire) < total && idleMs < kIdleLimitMs) {
+        if (queue.ReadBatch(out, 50) == 0) {
+            idleMs += 50;
+            continue;
+        }
+        idleMs = 0;
+
+        int64_t now = QueueClockNs();
+        uint64_t first = shared->received.fetch_add(out.size());
+        for (size_t i = 0; i < out.size() && first + i < total; i++) {
+            shared->samples[first + i] = now - std::atoll(out[i].text.c_str());
+        }
+        if (first + out.size() >= total) shared->finishNs.store(now);
+    }
+    return shared->received.load() >= total ? 0 : 3;
+}
+
+bool runBench(const RunSpec& spec, bool json) {
+    const uint64_t total = (uint64_t)spec.senders * spec.messages;
+    std::string sharedName = spec.queueName + "_results";
+    SharedRegion region;
+    if (!region.Create(sharedName, sizeof(BenchShared) + total * sizeof(int64_t))) return false;
+    BenchShared* shared = static_cast<BenchShared*>(region.Data());
+
+    BenchQueue queue(spec);
+    if (!queue.Create()) {
+        SharedRegion::Remove(sharedName);
+        return false;
+    }
+
+    // Receivers first, so a partitioned queue has its members before data arrives.
+    std::vector<pid_t> workers;
+    for (int r = 0; r < spec.receivers; r++) {
+        workers.push_back(spawnWorker([&]() { return runReceiver(spec, shared); }));
+    }
+    for (int s = 0; s < spec.senders; s++) {
+        workers.push_back(spawnWorker([&]() { return runSender(spec, shared, s); }));
+    }
+
+    const uint32_t expected = (uint32_t)workers.size();
+    for (int waited = 0; shared->ready.load() < expected && waited < kIdleLimitMs; waited++) {
+        QueueWait(&shared->ready, shared->ready.load(), 1);
+    }
+    shared->startNs.store(QueueClockNs());
+    shared->go.store(1, std::memory_order_release);
+    QueueWakeAll(&shared->go);
+
+    bool ok = true;
+    for (pid_t worker : workers) {
+        int status = 0;
+        waitpid(worker, &status, 0);
+        ok = ok && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    }
+
+    uint64_t received = std::min<uint64_t>(shared->received.load(), total);
+    std::vector<int64_t> samples(shared->samples, shared->samples + received);
+    std::sort(samples.begin(), samples.end());
+    double seconds = (shared->finishNs.load() - shared->startNs.load()) / 1e9;
+    const char* backend = QueueBackendName(spec.backend);
+    if (!ok || received < total || seconds <= 0) {
+        std::cerr << "Run failed: " << backend << " received " << received << " of " << total << std::endl;
+        ok = false;
+    }
+
+    long long rate = ok ? (long long)(received / seconds) : 0;
+    double maxUs = samples.empty() ? 0 : samples.back() / 1000.0;
+    if (ok && json) {
+        std::cout << "{\"backend\":\"" << backend << "\",\"senders\":" << spec.senders
+            << ",\"receivers\":" << spec.receivers << ",\"size\":" << spec.size
+            << ",\"capacity\":" << spec.capacity << ",\"batch\":" << spec.batch
+            << ",\"messages\":" << received << ",\"seconds\":" << seconds
+            << ",\"msgs_per_sec\":" << rate << ",\"p50_us\":" << percentileUs(samples, 0.50)
+            << ",\"p99_us\":" << percentileUs(samples, 0.99) << ",\"p999_us\":" << percentileUs(samples, 0.999)
+            << ",\"max_us\":" << maxUs << "}" << std::endl;
+    }
+    else if (ok) {
+        std::cout << backend << "," << spec.senders << "," << spec.receivers << "," << spec.size << ","
+            << spec.capacity << "," << spec.batch << "," << received << "," << seconds << "," << rate << ","
+            << percentileUs(samples, 0.50) << "," << percentileUs(samples, 0.99) << ","
+            << percentileUs(samples, 0.999) << "," << maxUs << std::endl;
+    }
+
+    queue.Remove();
+    region.Close();
+    SharedRegion::Remove(sharedName);
+    return ok;
+}
+
+// Combinations a backend cannot run are skipped with a note on stderr.
+bool supported(QueueBackend backend, int receivers, int size) {
+    if (backend == BACKEND_FILE) return false;
+    if ((backend == BACKEND_RING || backend == BACKEND_VARLEN || backend == BACKEND_PRIORITY) && receivers != 1) {
+        return false;
+    }
+    if (backend == BACKEND_SHM && size > MAX_MESSAGE_LEN) return false;
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    BenchConfig config;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string option = argv[i];
+        std::string value = argv[i + 1];
+        if (option == "--backends") config.backends = splitList(value);
+        else if (option == "--senders") config.senderCounts = splitInts(value);
+        else if (option == "--receivers") config.receiverCounts = splitInts(value);
+        else if (option == "--sizes") config.sizes = splitInts(value);
+        else if (option == "--capacities") config.capacities = splitInts(value);
+        else if (option == "--batches") config.batches = splitInts(value);
+        else if (option == "--messages") config.messages = std::atoi(value.c_str());
+        else if (option == "--format") config.json = value == "json";
+        else {
+            std::cerr << "Unknown option: " << option << std::endl;
+            return 1;
+        }
+    }
+    if (config.messages <= 0) {
+        std::cerr << "--messages must be positive" << std::endl;
+        return 1;
+    }
+
+    if (!config.json) {
+        std::cout << "backend,senders,receivers,size,capacity,batch,messages,seconds,"
+            "msgs_per_sec,p50_us,p99_us,p999_us,max_us" << std::endl;
+    }
+
+    bool ok = true;
+    int run = 0;
+    for (const auto& name : config.backends) {
+        QueueBackend backend;
+        if (!ParseQueueBackend(name, backend) || backend == BACKEND_FILE) {
+            std::cerr << "Unknown backend: " << name << std::endl;
+            return 1;
+        }
+        for (int receivers : config.receiverCounts) {
+            for (int size : config.sizes) {
+                size = std::max(size, kStampBytes);
+                if (receivers <= 0 || !supported(backend, receivers, size)) {
+                    std::cerr << "Skipping " << name << " with " << receivers << " receivers, size " << size << std::endl;
+                    continue;
+                }
+
+                for (int capacity : config.capacities) {
+                    if (capacity <= 0) continue;
+                    if (backend == BACKEND_RING && capacity < kMinRingCapacity) {
+                        std::cerr << "Skipping " << name << " with capacity " << capacity << std::endl;
+                        continue;
+                    }
+
+                    for (int senders : config.senderCounts) {
+                        for (int batch : config.batches) {
+                            if (senders <= 0 || batch <= 0) continue;
+                            std::string queueName = SharedRegionName("queue_bench_" + std::to_string(getpid())
+                                + "_" + std::to_string(run++));
+                            RunSpec spec = { backend, senders, receivers, size, capacity, batch, config.messages, queueName };
+                            ok = runBench(spec, config.json) && ok;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "common.h"
+#include "mpsc_ring.h"
+#include "shared_region.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+const size_t kDefaultMaxMessage = 64 * 1024;
+
+struct ByteRingHeader {
+    uint32_t magic;          // set last by the creator
+    uint32_t maxMessage;     // longest payload accepted
+    uint64_t capacityBytes;  // ring bytes, a multiple of 8
+
+    alignas(kQueueCacheLine) std::atomic<uint32_t> reserveLock;  // QueueLock word of the senders
+    int32_t nextMsgId;                                          // guarded by reserveLock
+    std::atomic<uint64_t> tail;                                 // bytes reserved so far
+
+    alignas(kQueueCacheLine) std::atomic<uint64_t> head;  // bytes consumed so far
+
+    alignas(kQueueCacheLine) std::atomic<uint32_t> dataSignal;
+    std::atomic<uint32_t> dataWaiters;
+    alignas(kQueueCacheLine) std::atomic<uint32_t> spaceSignal;
+    std::atomic<uint32_t> spaceWaiters;
+
+    QueueStatsPage stats;  // depth and high water in messages, as for MpscRing
+};
+
+// Record header, 8-byte aligned. state is 0 while the record is reserved but
+// not yet written; then kRecordData | payload length, or kRecordPadding |
+// bytes up to the end of the ring for the filler a record leaves when it
+// does not fit before the wrap.
+struct ByteRecord {
+    std::atomic<uint32_t> state;
+    int32_t msgId;
+    char data[1];  // payload, padded to 8 bytes
+};
+
+const uint32_t kRecordData = 0x40000000;
+const uint32_t kRecordPadding = 0x80000000;
+const uint32_t kRecordLengthMask = 0x3FFFFFFF;
+
+// Variable-length messages in a byte ring: each message takes an 8-byte
+// header plus its payload rounded up to 8, so an 8-byte message costs 16
+// bytes and a 64 KB one no more than it needs. A record never wraps; when it
+// does not fit before the end, a padding record fills the gap and it starts
+// at offset 0.
+//
+// Senders hold a short lock only to reserve bytes: they take the next id,
+// write the padding record and zero the new record's header before publishing
+// tail, then copy the payload and commit the header without the lock. The
+// single receiver reads committed records in order lock-free and waits on a
+// record that is still being written.
+class ByteRing {
+public:
+    ByteRing();
+    ~ByteRing();
+
+    ByteRing(const ByteRing&) = delete;
+    ByteRing& operator=(const ByteRing&) = delete;
+
+    // capacityBytes is raised to fit two records of maxMessage, so any
+    // message up to the limit can always be placed after a wrap.
+    bool Create(const std::string& name, size_t capacityBytes, size_t maxMessage = kDefaultMaxMessage);
+    // A read-only ring is for watching: UsedBytes and Stats only.
+    bool Open(const std::string& name, bool readOnly = false);
+    void Close();  // frees this sender's stats slot
+    static void Remove(const std::string& name) { SharedRegion::Remove(name); }
+
+    size_t CapacityBytes() const { return header ? (size_t)header->capacityBytes : 0; }
+    size_t MaxMessage() const { return header ? header->maxMessage : 0; }
+    size_t UsedBytes() const;
+    const QueueStatsPage* Stats() const { return header ? &header->stats : nullptr; }
+    static size_t RecordBytes(size_t length) { return (8 + length + 7) / 8 * 8; }
+
+    // Messages longer than MaxMessage() are refused, never truncated.
+    bool Send(const std::string& text, int timeoutMs = -1, int* msgId = nullptr);
+    bool SendBytes(const void* data, size_t length, int timeoutMs = -1, int* msgId = nullptr);
+
+    // Single consumer, as for MpscRing.
+    bool Read(std::string& message, int& msgId, int timeoutMs = -1);
+    size_t ReadBatch(std::vector<ReceivedMessage>& out, size_t maxMessages, int timeoutMs = -1);
+
+private:
+    ByteRecord* RecordAt(uint64_t pos) const {
+        return reinterpret_cast<ByteRecord*>(ring + pos % header->capacityBytes);
+    }
+    bool TryReserve(size_t length, uint64_t& pos, int& msgId);
+    bool NextRecord(uint64_t& pos, ByteRecord*& record, int64_t deadline, bool counted);
+
+    SharedRegion region;
+    ByteRingHeader* header;
+    char* ring;
+    std::atomic<QueueSenderStats*> senderStats;  // claimed by the first send
+};
@@ -0,0 +1,133 @@
+#pragma once
+
+#include "common.h"
+#include "queue_stats.h"
+#include "shared_region.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Producer and consumer positions sit on their own cache lines, as do the two
+// wake counters, so senders reserving slots never bounce the line the
+// receiver is advancing and vice versa. The stats page follows, for
+// queue_stat and anyone else watching the ring.
+struct MpscRingHeader {
+    uint32_t magic;         // set last by the creator
+    uint32_t capacity;      // slots
+    uint32_t slotBytes;     // stride of one slot
+    uint32_t payloadBytes;  // longest message
+
+    alignas(kQueueCacheLine) std::atomic<uint64_t> tail;  // next position a sender reserves
+    alignas(kQueueCacheLine) std::atomic<uint64_t> head;  // next position the receiver reads
+
+    alignas(kQueueCacheLine) std::atomic<uint32_t> dataSignal;
+    std::atomic<uint32_t> dataWaiters;
+    alignas(kQueueCacheLine) std::atomic<uint32_t> spaceSignal;
+    std::atomic<uint32_t> spaceWaiters;
+
+    QueueStatsPage stats;
+};
+
+// Slot at ring position pos (index pos % capacity). sequence == pos: free for
+// the sender that reserves pos; pos + 1: holds that message; the receiver
+// hands it to the next lap by storing pos + capacity. So a ring needs two
+// slots at least: with one, a published message (pos + 1) would already
+// read as free for the sender of the next lap.
+const int kMinRingCapacity = 2;
+
+struct MpscSlot {
+    std::atomic<uint64_t> sequence;
+    uint32_t length;
+    uint32_t reserved;
+    char data[1];  // payloadBytes follow
+};
+
+// A received message left in its slot: data points into the shared ring and
+// stays valid, and the slot stays taken, until the view is released.
+struct MessageView {
+    const char* data;
+    size_t length;
+    int msgId;
+    uint64_t position;  // ring position, for Release
+};
+
+// Lock-free multi-producer single-consumer ring in shared memory. Senders
+// claim a position with one CAS on tail and publish it through the slot's
+// sequence; the single receiver needs no atomic read-modify-write at all.
+// Nobody sleeps while there is work: a full or empty side registers as a
+// waiter and sleeps on a wake counter, and the other side only bumps the
+// counter and makes the wake syscall when a waiter is registered.
+class MpscRing {
+public:
+    MpscRing();
+    ~MpscRing();
+
+    // capacity below kMinRingCapacity fails, as does Format.
+    bool Create(const std::string& name, int capacity, size_t payloadBytes = MAX_MESSAGE_LEN);
+    // A read-only ring is for watching: Count, Capacity and Stats only.
+    bool Open(const std::string& name, bool readOnly = false);
+    void Close();  // frees this sender's stats slot
+    static void Remove(const std::string& name) { SharedRegion::Remove(name); }
+
+    // A ring inside memory someone else mapped, e.g. one partition of a
+    // larger region: Format lays it out in RegionBytes() zeroed bytes at a
+    // cache-line aligned address, Attach uses one already laid out there.
+    static size_t RegionBytes(int capacity, size_t payloadBytes = MAX_MESSAGE_LEN);
+    bool Format(void* memory, int capacity, size_t payloadBytes = MAX_MESSAGE_LEN);
+    bool Attach(void* memory, size_t bytes);
+
+    int Capacity() const { return header ? (int)header->capacity : 0; }
+    size_t PayloadBytes() const { return header ? header->payloadBytes : 0; }
+    int Count() const;
+    const QueueStatsPage* Stats() const { return header ? &header->stats : nullptr; }
+
+    // Same contract as ShmQueue: timeoutMs < 0 waits, 0 only tries. msgId is
+    // the 1-based position in the ring's total order. Text is truncated to
+    // PayloadBytes().
+    bool Send(const std::string& text, int timeoutMs = -1, int* msgId = nullptr);
+    bool SendBytes(const void* data, size_t length, int timeoutMs = -1, int* msgId = nullptr);
+    // Single consumer: only one thread of one process may read at a time.
+    bool Read(std::string& message, int& msgId, int timeoutMs = -1);
+
+    // Batch forms with the ShmQueue contract. SendBatch reserves as many
+    // consecutive slots as are free with one CAS on tail and notifies once;
+    // ReadBatch frees every slot it took, then advances head and notifies
+    // once. A batch's messages are consecutive in the ring order.
+    size_t SendBatch(const std::vector<std::string>& texts, int timeoutMs = -1, int* firstMsgId = nullptr);
+    size_t ReadBatch(std::vector<ReceivedMessage>& out, size_t maxMessages, int timeoutMs = -1);
+
+    // Zero-copy receive. Acquire hands out the next message in place instead
+    // of copying it; Release gives its slot back. Views may be released in
+    // any order: head only advances over the released prefix, so a slot is
+    // never reused while a view of it is held, and an unreleased message
+    // holds back the space behind it. Read and ReadBatch fail while views are
+    // outstanding; the same single-consumer rule applies.
+    bool Acquire(MessageView& view, int timeoutMs = -1);
+    size_t AcquireBatch(std::vector<MessageView>& views, size_t maxMessages, int timeoutMs = -1);
+    void Release(const MessageView& view);
+    size_t Outstanding() const { return outstanding; }
+
+private:
+    MpscSlot* SlotAt(uint64_t pos) const {
+        return reinterpret_cast<MpscSlot*>(slots + (pos % header->capacity) * header->slotBytes);
+    }
+    bool WaitPublished(uint64_t pos, int64_t deadline, bool counted);
+    MessageView ViewAt(uint64_t pos);
+    bool TryReserve(uint64_t& pos);
+    size_t TryReserveRun(size_t wanted, uint64_t& first);
+    void NotifyData();
+    void NotifySpace();
+    QueueSenderStats& SenderStats();
+    void RecordSent(QueueSenderStats& stats, uint64_t last, size_t count);
+
+    SharedRegion region;
+    MpscRingHeader* header;
+    char* slots;
+    std::atomic<QueueSenderStats*> senderStats;  // claimed by the first send
+
+    // Consumer-side view bookkeeping, local to the receiving process.
+    std::vector<uint8_t> released;  // per slot index: released, head not yet past it
+    uint64_t acquireNext;           // next position Acquire hands out
+    size_t outstanding;             // views not yet released
+};
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "common.h"
+#include "mpsc_ring.h"
+#include "shared_region.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+const int kMaxPartitions = 64;
+const int kMaxPartitionReceivers = 32;
+const int kReapIntervalMs = 100;
+
+struct PartitionMember {
+    std::atomic<uint32_t> active;
+    int32_t pid;  // to reap receivers that died without leaving
+};
+
+// owner[p] and reader[p] hold a member index + 1, 0 for none. owner is the
+// assignment, rewritten on every join and leave; reader is taken around each
+// read, so a partition handed to a new owner is not read by both at once.
+struct PartitionedQueueHeader {
+    uint32_t magic;       // set last by the creator
+    uint32_t partitions;
+    uint64_t ringBytes;   // stride between the partitions' rings
+
+    alignas(kQueueCacheLine) std::atomic<uint64_t> nextPartition;  // round-robin cursor of the senders
+
+    alignas(kQueueCacheLine) std::atomic<uint32_t> dataSignal;  // any partition got a message, or owners changed
+    std::atomic<uint32_t> dataWaiters;
+
+    alignas(kQueueCacheLine) std::atomic<uint32_t> memberLock;  // QueueLock word over members and owner
+    std::atomic<uint32_t> generation;                           // bumped by every rebalance
+    PartitionMember members[kMaxPartitionReceivers];
+    std::atomic<uint32_t> owner[kMaxPartitions];
+    std::atomic<uint32_t> reader[kMaxPartitions];
+};
+
+// K MpscRings in one shared region. Senders route each message to one
+// partition, by a hash of its key (so one key's messages stay in order) or
+// round-robin; every receiver process joins as a member and reads only the
+// partitions it owns. Partitions are spread evenly over the members in
+// member order and are reassigned whenever one joins or leaves. Members
+// whose process has exited are reaped by Join, and by receivers that find
+// nothing of their own to read, so a dead member's partitions do not sit
+// unread until the next join.
+class PartitionedQueue {
+public:
+    PartitionedQueue();
+    ~PartitionedQueue();
+
+    PartitionedQueue(const PartitionedQueue&) = delete;
+    PartitionedQueue& operator=(const PartitionedQueue&) = delete;
+
+    // capacity is per partition, kMinRingCapacity at least.
+    bool Create(const std::string& name, int partitions, int capacity, size_t payloadBytes = MAX_MESSAGE_LEN);
+    // A read-only queue is for watching: Count and PartitionStats only.
+    bool Open(const std::string& name, bool readOnly = false);
+    void Close();  // leaves first if joined
+    static void Remove(const std::string& name) { SharedRegion::Remove(name); }
+
+    int Partitions() const { return header ? (int)header->partitions : 0; }
+    int PartitionFor(const std::string& key) const;
+    int Count() const;
+    int PartitionCount(int p) const { return rings[p]->Count(); }
+    const QueueStatsPage* PartitionStats(int p) const { return rings[p]->Stats(); }
+    uint32_t Generation() const { return header ? header->generation.load() : 0; }
+
+    // Sender side; msgId is the position within the partition. Send picks
+    // the next partition round-robin, skipping full ones when it can.
+    bool Send(const std::string& text, int timeoutMs = -1, int* msgId = nullptr, int* partition = nullptr);
+    bool SendKeyed(const std::string& key, const std::string& text, int timeoutMs = -1, int* msgId = nullptr);
+
+    // Receiver side. Join fails when all member slots are taken.
+    bool Join();
+    void Leave();
+    bool Joined() const { return member >= 0; }
+    std::vector<int> OwnedPartitions() const;
+
+    // Reads from any owned partition, taking them in turn; waits while all
+    // of them are empty, following ownership changes as they happen and
+    // reaping dead members every kReapIntervalMs while it waits.
+    bool Read(std::string& message, int& msgId, int* partition = nullptr, int timeoutMs = -1);
+    size_t ReadBatch(std::vector<ReceivedMessage>& out, size_t maxMessages, int timeoutMs = -1);
+
+private:
+    bool OwnsReadable(int p) const;
+    bool AnyOwnedReadable() const;
+    bool TryReadOwned(std::string& message, int& msgId, int& partition);
+    size_t TryReadBatchOwned(std::vector<ReceivedMessage>& out, size_t maxMessages);
+    bool ReapDeadMembers();
+    void ReapIfDue();
+    int64_t WaitSliceEnd(int64_t deadline) const;
+    void Rebalance();
+    void NotifyData();
+
+    SharedRegion region;
+    PartitionedQueueHeader* header;
+    std::vector<std::unique_ptr<MpscRing>> rings;
+    int member;      // slot in members while joined, else -1
+    int nextRead;    // partition a read starts from
+    int64_t nextReapNs;  // QueueClockNs time of this receiver's next reap
+};
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "common.h"
+#include "mpsc_ring.h"
+#include "shared_region.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+const int kMaxPriorities = 8;
+
+// used is the shared budget: messages queued at any level plus sends that
+// have taken a unit and are still writing. Senders wait on spaceSignal while
+// their level's share of it is used up, the receiver on dataSignal while
+// every level is empty.
+struct PriorityQueueHeader {
+    uint32_t magic;             // set last by the creator
+    uint32_t levels;
+    uint32_t capacity;          // the budget, in messages
+    uint32_t reserve;           // budget each level keeps from the levels below it
+    uint32_t starvationWeight;  // 0: strict priority
+    uint32_t reserved;
+    uint64_t ringBytes;         // stride between the levels' rings
+
+    alignas(kQueueCacheLine) std::atomic<uint32_t> used;
+
+    alignas(kQueueCacheLine) std::atomic<uint32_t> dataSignal;
+    std::atomic<uint32_t> dataWaiters;
+    alignas(kQueueCacheLine) std::atomic<uint32_t> spaceSignal;
+    std::atomic<uint32_t> spaceWaiters;
+};
+
+// P MpscRings in one shared region, one per priority level, 0 the lowest.
+// The levels share one budget of `capacity` messages, and each ring is big
+// enough to hold all of it, so a level can only run out through the budget:
+// level p may fill it up to capacity - reserve * (levels - 1 - p), which
+// leaves the top `reserve` messages of the budget to the levels above, so a
+// flood of bulk messages cannot make an urgent one wait for space.
+//
+// The receiver takes the highest non-empty level first. With a starvation
+// weight w, a waiting level that has been passed over w times in a row is
+// served next, so a lower level still gets one message in every w + 1 while
+// the ones above are busy. Messages of one level keep their order.
+class PriorityQueue {
+public:
+    PriorityQueue();
+    ~PriorityQueue();
+
+    PriorityQueue(const PriorityQueue&) = delete;
+    PriorityQueue& operator=(const PriorityQueue&) = delete;
+
+    // reserve * (levels - 1) must leave the lowest level some of the budget.
+    bool Create(const std::string& name, int levels, int capacity, int reserve = 0, int starvationWeight = 0,
+        size_t payloadBytes = MAX_MESSAGE_LEN);
+    // A read-only queue is for watching: Count, LevelCount and LevelStats only.
+    bool Open(const std::string& name, bool readOnly = false);
+    void Close();
+    static void Remove(const std::string& name) { SharedRegion::Remove(name); }
+
+    int Levels() const { return header ? (int)header->levels : 0; }
+    int Capacity() const { return header ? (int)header->capacity : 0; }
+    int Count() const;
+    int LevelCount(int priority) const { return rings[priority]->Count(); }
+    const QueueStatsPage* LevelStats(int priority) const { return rings[priority]->Stats(); }
+
+    // Sender side. msgId is the position within the level; a priority out of
+    // range fails. SendBatch queues all texts at one priority and returns how
+    // many were queued, as MpscRing::SendBatch does.
+    bool Send(const std::string& text, int priority = 0, int timeoutMs = -1, int* msgId = nullptr);
+    size_t SendBatch(const std::vector<std::string>& texts, int priority = 0, int timeoutMs = -1,
+        int* firstMsgId = nullptr);
+
+    // Receiver side, single consumer. The level a message came from goes
+    // into *priority, or ReceivedMessage::priority for the batch.
+    bool Read(std::string& message, int& msgId, int* priority = nullptr, int timeoutMs = -1);
+    size_t ReadBatch(std::vector<ReceivedMessage>& out, size_t maxMessages, int timeoutMs = -1);
+
+private:
+    uint32_t LevelLimit(int priority) const;
+    size_t TryTakeBudget(int priority, size_t wanted);
+    bool WaitBudget(int priority, int64_t deadline);
+    void ReturnBudget(size_t count);
+    bool AnyQueued() const;
+    bool TryReadNext(std::string& message, int& msgId, int& priority);
+
+    SharedRegion region;
+    PriorityQueueHeader* header;
+    std::vector<std::unique_ptr<MpscRing>> rings;
+    std::vector<uint32_t> passedOver;  // receiver side: reads since each level was last served
+};
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <string>
+
+// Where a queue named by its file lives and how it is synchronised.
+enum QueueBackend {
+    BACKEND_FILE,        // the original file + named mutex/events (Windows only)
+    BACKEND_SHM,         // ShmQueue: the same ring in shared memory under one lock word
+    BACKEND_RING,        // MpscRing: lock-free multi-producer ring in shared memory
+    BACKEND_VARLEN,      // ByteRing: variable-length records in a shared byte ring
+    BACKEND_PARTITIONED, // PartitionedQueue: K MpscRings read by several receivers
+    BACKEND_PRIORITY     // PriorityQueue: P MpscRings sharing one budget, highest level first
+};
+
+bool ParseQueueBackend(const std::string& name, QueueBackend& backend);
+const char* QueueBackendName(QueueBackend backend);
+
+// When an acknowledged message is on the disk.
+enum QueueDurability {
+    DURABILITY_MEMORY,  // never synced: lost with the machine (shared memory, or the page cache)
+    DURABILITY_ASYNC,   // the creator syncs the file every flush interval; Send does not wait
+    DURABILITY_GROUP    // Send returns once an fdatasync covering the message has finished
+};
+
+bool ParseQueueDurability(const std::string& name, QueueDurability& durability);
+const char* QueueDurabilityName(QueueDurability durability);
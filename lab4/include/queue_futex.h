@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Address waits on words that live in a shared mapping, so unlike a
+// process-private futex they work between the receiver and sender processes.
+// Linux uses shared futex(2) operations; elsewhere there is no cross-process
+// address wait, so the wait degrades to a short sleep and the wake is a no-op.
+
+// Sleeps while *word == expected, at most timeoutMs (< 0: no limit).
+// May return spuriously.
+void QueueWait(std::atomic<uint32_t>* word, uint32_t expected, int timeoutMs = -1);
+void QueueWake(std::atomic<uint32_t>* word, int count);
+void QueueWakeAll(std::atomic<uint32_t>* word);
+
+// Three-state lock word (0 free, 1 held, 2 held with sleepers) that sleeps
+// on the word itself; usable from any process that maps it.
+void QueueLock(std::atomic<uint32_t>* word);
+void QueueUnlock(std::atomic<uint32_t>* word);
+
+// Monotonic nanoseconds, comparable between processes on one machine.
+int64_t QueueClockNs();
+
+// Absolute deadline for a timeout in ms; -1 (timeoutMs < 0) = none.
+int64_t QueueDeadline(int timeoutMs);
+
+// Event-count wait between the two sides of a lock-free ring. The sleeper
+// registers in `waiters`, re-checks `ready` and sleeps on `signal` only if
+// it still fails; QueueNotify bumps the signal and makes the wake syscall
+// only when a waiter is registered. The fences pair up, so either the
+// notifier sees the waiter or the re-check sees the notifier's update.
+// Returns false once the deadline has passed.
+template<class Ready>
+bool QueueSleepUnless(std::atomic<uint32_t>& signal, std::atomic<uint32_t>& waiters, int64_t deadline,
+    Ready ready) {
+    int timeoutMs = -1;
+    if (deadline >= 0) {
+        int64_t left = deadline - QueueClockNs();
+        if (left <= 0) return false;
+        timeoutMs = (int)((left + 999999) / 1000000);
+    }
+
+    uint32_t seen = signal.load(std::memory_order_relaxed);
+    waiters.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!ready()) QueueWait(&signal, seen, timeoutMs);
+    waiters.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+void QueueNotify(std::atomic<uint32_t>& signal, std::atomic<uint32_t>& waiters);
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+const size_t kQueueCacheLine = 64;
+const int kMaxStatSenders = 32;
+
+// One sender's counters, on a line of its own so that senders counting their
+// messages never share a line. pid is the process holding the slot, 0 when
+// free. A sender writes only its own slot, so relaxed adds are enough; a
+// reader sees each counter move forward, not a consistent set.
+struct alignas(kQueueCacheLine) QueueSenderStats {
+    std::atomic<int32_t> pid;
+    std::atomic<uint64_t> enqueued;
+    std::atomic<uint64_t> fullWaits;  // sends that slept because the queue was full
+    std::atomic<uint64_t> waitNs;     // time those sends slept
+    std::atomic<uint64_t> highWater;  // deepest queue one of its messages went into
+};
+
+// Counters kept in the queue's shared layout. The global totals are the
+// senders' slots summed, plus `retired`, which collects the counts of
+// released slots and of senders that found every slot taken; highWater is
+// raised only when a sender raises its own, so it stays cold too. The
+// receiver has its own line.
+struct QueueStatsPage {
+    alignas(kQueueCacheLine) std::atomic<uint64_t> highWater;
+
+    alignas(kQueueCacheLine) std::atomic<uint64_t> dequeued;
+    std::atomic<uint64_t> emptyWaits;   // reads that slept because the queue was empty
+    std::atomic<uint64_t> emptyWaitNs;
+
+    QueueSenderStats retired;
+    QueueSenderStats senders[kMaxStatSenders];
+};
+
+// A point-in-time sum over the page, for reports.
+struct QueueStatsTotals {
+    uint64_t enqueued = 0;
+    uint64_t dequeued = 0;
+    uint64_t fullWaits = 0;
+    uint64_t waitNs = 0;
+    uint64_t highWater = 0;
+    uint64_t emptyWaits = 0;
+    uint64_t emptyWaitNs = 0;
+    int senders = 0;  // slots held
+};
+
+QueueStatsTotals SumQueueStats(const QueueStatsPage& page);
+
+// Sender side. Claim takes a free slot, or one whose process has died, and
+// falls back to `retired` when there is none; Release folds the slot's
+// counts into `retired` and frees it.
+QueueSenderStats* ClaimSenderStats(QueueStatsPage& page);
+void ReleaseSenderStats(QueueStatsPage& page, QueueSenderStats* stats);
+// The slot of a queue handle that several threads may send through: the
+// first send claims it into `held`; a thread that loses that race gives its
+// own claim back and uses the winner's.
+QueueSenderStats& HeldSenderStats(QueueStatsPage& page, std::atomic<QueueSenderStats*>& held);
+
+// count messages queued, the last of them with depth messages in the queue.
+void QueueStatsSent(QueueStatsPage& page, QueueSenderStats& stats, uint64_t count, uint64_t depth);
+// A wait on a full (sender) or empty (receiver) queue that began at startNs.
+void QueueStatsFullWait(QueueSenderStats& stats, int64_t startNs);
+void QueueStatsEmptyWait(QueueStatsPage& page, int64_t startNs);
+void QueueStatsReceived(QueueStatsPage& page, uint64_t count);
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// A named block of memory mapped into every process that opens it:
+// shm_open + mmap on Linux, a pagefile-backed file mapping on Windows.
+// The creator sizes it and zero-fills it; openers map whatever size it has.
+// MapFile maps an ordinary file instead, so the contents survive the
+// processes and reach the disk when Sync is called.
+class SharedRegion {
+public:
+    SharedRegion();
+    ~SharedRegion();
+
+    SharedRegion(const SharedRegion&) = delete;
+    SharedRegion& operator=(const SharedRegion&) = delete;
+
+    // Replaces any region left over under the same name.
+    bool Create(const std::string& name, size_t bytes);
+    bool Open(const std::string& name, bool readOnly = false);
+    void Close();
+    static void Remove(const std::string& name);
+
+    // Maps the file at path, creating it or resizing it to `bytes` as needed;
+    // existing contents are kept, new bytes read as zero. bytes == 0 maps an
+    // existing, non-empty file at its current size.
+    bool MapFile(const std::string& path, size_t bytes);
+    // Writes the mapped file's dirty pages to the disk and waits for them
+    // (fdatasync / FlushViewOfFile + FlushFileBuffers). False for shared
+    // memory, which has nowhere to go, and on an I/O error.
+    bool Sync();
+
+    void* Data() const { return data; }
+    size_t Size() const { return size; }
+    bool IsOpen() const { return data != nullptr; }
+
+private:
+    void* data;
+    size_t size;
+#if defined(_WIN32)
+    void* mapping;
+    void* file;  // INVALID_HANDLE_VALUE unless MapFile
+#else
+    int fd;      // -1 unless MapFile
+#endif
+};
+
+// Region name for a queue known to its users by file name, e.g. "queue.bin".
+std::string SharedRegionName(const std::string& filename);
+
+// The processes sharing a region, for slots that record who holds them:
+// ProcessAlive tells whether the holder of a slot is still running.
+int32_t CurrentProcessId();
+bool ProcessAlive(int32_t pid);
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "common.h"
+#include "queue_backend.h"
+#include "queue_stats.h"
+#include "shared_region.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+const int kDefaultFlushIntervalMs = 10;
+
+// Wait/lock words in front of the queue. The signals and waiter counts are
+// QueueSleepUnless/QueueNotify event counts: a waiter registers, re-checks
+// the queue and sleeps on the signal, and an enqueue/dequeue bumps it and
+// makes the wake syscall only when someone is registered.
+//
+// written counts enqueued messages (under the lock) and durable how many of
+// them the last finished sync covered; flushLeader holds the pid of the one
+// process running that sync (0: none), the others sleep on durableSignal
+// and take over if that process dies before it finishes.
+struct ShmQueueControl {
+    uint32_t magic;                    // set last by the creator
+    uint32_t durability;               // QueueDurability, fixed by the creator
+    std::atomic<uint32_t> lock;        // QueueLock word guarding header and ring
+    std::atomic<uint32_t> dataSignal;
+    std::atomic<uint32_t> spaceSignal;
+    std::atomic<uint32_t> dataWaiters;
+    std::atomic<uint32_t> spaceWaiters;
+    std::atomic<uint32_t> flushLeader; // pid of the syncing process, 0: none
+    std::atomic<uint32_t> durableSignal;
+    std::atomic<uint32_t> durableWaiters;
+    std::atomic<uint64_t> written;
+    std::atomic<uint64_t> durable;
+    std::atomic<uint64_t> flushes;     // syncs done, for reports
+};
+
+// The file queue's QueueHeader + Message ring, mapped once into shared memory:
+// [ShmQueueControl][QueueStatsPage][QueueHeader][Message x capacity]. Send
+// and Read are a lock, a struct copy and an unlock, with no file I/O; the
+// FIFO and message id rules are the same as for the file. The stats page is
+// kept as for MpscRing, for queue_stat.
+class ShmQueue {
+public:
+    ShmQueue();
+
+    ~ShmQueue();
+
+    bool Create(const std::string& name, int capacity);
+    // A read-only queue is for watching: Capacity and Stats only.
+    bool Open(const std::string& name, bool readOnly = false);
+    void Close();  // frees this sender's stats slot
+    static void Remove(const std::string& name) { SharedRegion::Remove(name); }
+
+    // The queue kept in the file at path, mapped the same way, with the given
+    // durability. A file left by an earlier run with the same capacity is
+    // recovered, queued messages included; anything else starts empty. With
+    // DURABILITY_ASYNC this object runs the flusher thread until Close.
+    bool CreateDurable(const std::string& path, int capacity, QueueDurability durability,
+        int flushIntervalMs = kDefaultFlushIntervalMs);
+    bool OpenDurable(const std::string& path);
+
+    int Capacity() const;
+    int Count() const;
+    QueueDurability Durability() const;
+    uint64_t Flushes() const { return control ? control->flushes.load() : 0; }
+    const QueueStatsPage* Stats() const { return stats; }
+
+    // timeoutMs < 0 waits for space/data as long as it takes, 0 only tries.
+    // Text longer than MAX_MESSAGE_LEN is truncated. In group-commit mode
+    // Send and SendBatch return after the sync that covers their messages
+    // (the timeout only bounds the wait for space); every sender that queued
+    // while one sync was running is covered by the next one, so concurrent
+    // senders share a single fdatasync. They return false if that sync
+    // fails, though the messages stay queued.
+    bool Send(const std::string& text, int timeoutMs = -1, int* msgId = nullptr);
+    bool Read(std::string& message, int& msgId, int timeoutMs = -1);
+
+    // Batch forms: every lock hold moves as many messages as fit and updates
+    // the header and signals the other side once. SendBatch waits for space
+    // until all texts are queued or the timeout passes and returns how many
+    // were queued; firstMsgId gets the id of texts[0]. ReadBatch waits for at
+    // least one message, then takes up to maxMessages of what is there;
+    // ReadBatch(out, SIZE_MAX, 0) drains everything available.
+    size_t SendBatch(const std::vector<std::string>& texts, int timeoutMs = -1, int* firstMsgId = nullptr);
+    size_t ReadBatch(std::vector<ReceivedMessage>& out, size_t maxMessages, int timeoutMs = -1);
+
+    // Returns once everything queued so far is on the disk, joining a sync
+    // another process has already started; false on an I/O error or for a
+    // queue in shared memory with anything queued.
+    bool Flush();
+
+private:
+    void Attach();
+    bool WaitDurable(uint64_t written);
+    bool TakeFlushLeader();
+    bool SyncAsLeader();
+    void RunFlusher(int intervalMs);
+
+    SharedRegion region;
+    ShmQueueControl* control;
+    QueueStatsPage* stats;
+    QueueHeader* header;
+    Message* messages;
+    std::atomic<QueueSenderStats*> senderStats;  // claimed by the first send
+
+    std::thread flusher;
+    std::mutex flusherMutex;
+    std::condition_variable flusherWake;
+    bool stopFlusher;
+};
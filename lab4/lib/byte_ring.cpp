@@ -0,0 +1,220 @@
+#include "byte_ring.h"
+#include "queue_futex.h"
+#include <algorithm>
+
+namespace {
+
+const uint32_t kByteRingMagic = 0x42595445;  // "BYTE"
+
+size_t HeaderBytes() {
+    return (sizeof(ByteRingHeader) + kQueueCacheLine - 1) / kQueueCacheLine * kQueueCacheLine;
+}
+
+} // namespace
+
+ByteRing::ByteRing() : header(nullptr), ring(nullptr), senderStats(nullptr) {}
+
+ByteRing::~ByteRing() {
+    Close();
+}
+
+bool ByteRing::Create(const std::string& name, size_t capacityBytes, size_t maxMessage) {
+    if (maxMessage == 0 || maxMessage > kRecordLengthMask) return false;
+    capacityBytes = std::max((capacityBytes + 7) / 8 * 8, 2 * RecordBytes(maxMessage));
+    if (!region.Create(name, HeaderBytes() + capacityBytes)) return false;
+
+    header = static_cast<ByteRingHeader*>(region.Data());
+    ring = static_cast<char*>(region.Data()) + HeaderBytes();
+    header->maxMessage = (uint32_t)maxMessage;
+    header->capacityBytes = capacityBytes;
+
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = kByteRingMagic;
+    return true;
+}
+
+bool ByteRing::Open(const std::string& name, bool readOnly) {
+    if (!region.Open(name, readOnly) || region.Size() < HeaderBytes()) {
+        Close();
+        return false;
+    }
+
+    header = static_cast<ByteRingHeader*>(region.Data());
+    ring = static_cast<char*>(region.Data()) + HeaderBytes();
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (header->magic != kByteRingMagic || header->capacityBytes == 0
+        || region.Size() < HeaderBytes() + header->capacityBytes) {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void ByteRing::Close() {
+    if (header) ReleaseSenderStats(header->stats, senderStats.exchange(nullptr));
+    region.Close();
+    header = nullptr;
+    ring = nullptr;
+}
+
+size_t ByteRing::UsedBytes() const {
+    if (!header) return 0;
+    uint64_t head = header->head.load(std::memory_order_acquire);
+    uint64_t tail = header->tail.load(std::memory_order_acquire);
+    return tail > head ? (size_t)(tail - head) : 0;
+}
+
+// Under the senders' lock: room check, padding record, id, and a zeroed
+// header for the new record, all before tail is published, so the receiver
+// never looks at bytes past tail and never sees a stale header before it.
+bool ByteRing::TryReserve(size_t length, uint64_t& pos, int& msgId) {
+    QueueLock(&header->reserveLock);
+
+    uint64_t capacity = header->capacityBytes;
+    uint64_t tail = header->tail.load(std::memory_order_relaxed);
+    uint64_t head = header->head.load(std::memory_order_acquire);
+    uint64_t offset = tail % capacity;
+    uint64_t bytes = RecordBytes(length);
+    uint64_t padding = offset + bytes > capacity ? capacity - offset : 0;
+
+    if (tail + padding + bytes - head > capacity) {
+        QueueUnlock(&header->reserveLock);
+        return false;
+    }
+
+    if (padding) {
+        ByteRecord* filler = RecordAt(tail);
+        filler->msgId = 0;
+        filler->state.store(kRecordPadding | (uint32_t)padding, std::memory_order_relaxed);
+    }
+
+    pos = tail + padding;
+    ByteRecord* record = RecordAt(pos);
+    record->state.store(0, std::memory_order_relaxed);
+    record->msgId = msgId = ++header->nextMsgId;
+
+    header->tail.store(pos + bytes, std::memory_order_release);
+    QueueUnlock(&header->reserveLock);
+    return true;
+}
+
+bool ByteRing::Send(const std::string& text, int timeoutMs, int* msgId) {
+    return SendBytes(text.data(), text.size(), timeoutMs, msgId);
+}
+
+bool ByteRing::SendBytes(const void* data, size_t length, int timeoutMs, int* msgId) {
+    if (!header || length > header->maxMessage) return false;
+    int64_t deadline = QueueDeadline(timeoutMs);
+    QueueSenderStats& stats = HeldSenderStats(header->stats, senderStats);
+
+    uint64_t pos;
+    int id;
+    int64_t waitStart = 0;
+    while (!TryReserve(length, pos, id)) {
+        if (timeoutMs == 0) return false;
+        if (!waitStart) waitStart = QueueClockNs();
+        bool waited = QueueSleepUnless(header->spaceSignal, header->spaceWaiters, deadline, [this, length]() {
+            uint64_t capacity = header->capacityBytes;
+            uint64_t tail = header->tail.load(std::memory_order_relaxed);
+            uint64_t head = header->head.load(std::memory_order_acquire);
+            uint64_t offset = tail % capacity;
+            uint64_t bytes = RecordBytes(length);
+            uint64_t padding = offset + bytes > capacity ? capacity - offset : 0;
+            return tail + padding + bytes - head <= capacity;
+        });
+        if (!waited) {
+            QueueStatsFullWait(stats, waitStart);
+            return false;
+        }
+    }
+    if (waitStart) QueueStatsFullWait(stats, waitStart);
+
+    ByteRecord* record = RecordAt(pos);
+    memcpy(record->data, data, length);
+    record->state.store(kRecordData | (uint32_t)length, std::memory_order_release);
+
+    // Ids count the messages sent, so the depth is this id less those read.
+    if (msgId) *msgId = id;
+    uint64_t read = header->stats.dequeued.load(std::memory_order_relaxed);
+    QueueStatsSent(header->stats, stats, 1, (uint64_t)id > read ? (uint64_t)id - read : 1);
+    QueueNotify(header->dataSignal, header->dataWaiters);
+    return true;
+}
+
+// Finds the committed record at or after pos, skipping padding. Before
+// sleeping it hands skipped padding back to the senders, who may be waiting
+// for exactly those bytes. A sleep counts toward the empty-wait stats when
+// `counted`.
+bool ByteRing::NextRecord(uint64_t& pos, ByteRecord*& record, int64_t deadline, bool counted) {
+    int64_t waitStart = 0;
+    for (;;) {
+        if (pos < header->tail.load(std::memory_order_acquire)) {
+            record = RecordAt(pos);
+            uint32_t state = record->state.load(std::memory_order_acquire);
+            if (state & kRecordPadding) {
+                pos += state & kRecordLengthMask;
+                continue;
+            }
+            if (state & kRecordData) {
+                if (waitStart) QueueStatsEmptyWait(header->stats, waitStart);
+                return true;
+            }
+        }
+
+        if (pos != header->head.load(std::memory_order_relaxed)) {
+            header->head.store(pos, std::memory_order_release);
+            QueueNotify(header->spaceSignal, header->spaceWaiters);
+        }
+
+        if (counted && !waitStart) waitStart = QueueClockNs();
+        uint64_t at = pos;
+        bool waited = QueueSleepUnless(header->dataSignal, header->dataWaiters, deadline, [this, at]() {
+            return at < header->tail.load(std::memory_order_acquire)
+                && RecordAt(at)->state.load(std::memory_order_acquire) != 0;
+        });
+        if (!waited) {
+            if (waitStart) QueueStatsEmptyWait(header->stats, waitStart);
+            return false;
+        }
+    }
+}
+
+bool ByteRing::Read(std::string& message, int& msgId, int timeoutMs) {
+    if (!header) return false;
+
+    uint64_t pos = header->head.load(std::memory_order_relaxed);
+    ByteRecord* record;
+    if (!NextRecord(pos, record, QueueDeadline(timeoutMs), timeoutMs != 0)) return false;
+
+    uint32_t length = record->state.load(std::memory_order_relaxed) & kRecordLengthMask;
+    message.assign(record->data, length);
+    msgId = record->msgId;
+
+    header->head.store(pos + RecordBytes(length), std::memory_order_release);
+    QueueStatsReceived(header->stats, 1);
+    QueueNotify(header->spaceSignal, header->spaceWaiters);
+    return true;
+}
+
+size_t ByteRing::ReadBatch(std::vector<ReceivedMessage>& out, size_t maxMessages, int timeoutMs) {
+    out.clear();
+    if (!header || maxMessages == 0) return 0;
+
+    uint64_t pos = header->head.load(std::memory_order_relaxed);
+    int64_t deadline = QueueDeadline(timeoutMs);
+    ByteRecord* record;
+
+    while (out.size() < maxMessages && NextRecord(pos, record, out.empty() ? deadline : 0, out.empty() && timeoutMs != 0)) {
+        uint32_t length = record->state.load(std::memory_order_relaxed) & kRecordLengthMask;
+        out.push_back({ record->msgId, std::string(record->data, length) });
+        pos += RecordBytes(length);
+    }
+
+    if (!out.empty()) {
+        header->head.store(pos, std::memory_order_release);
+        QueueStatsReceived(header->stats, out.size());
+        QueueNotify(header->spaceSignal, header->spaceWaiters);
+    }
+    return out.size();
+}
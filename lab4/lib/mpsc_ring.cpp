@@ -0,0 +1,344 @@
+#include "mpsc_ring.h"
+#include "queue_futex.h"
+#include <algorithm>
+#include <cstddef>
+
+namespace {
+
+const uint32_t kMpscRingMagic = 0x4D505343;  // "MPSC"
+
+size_t HeaderBytes() {
+    return (sizeof(MpscRingHeader) + kQueueCacheLine - 1) / kQueueCacheLine * kQueueCacheLine;
+}
+
+size_t SlotBytesFor(size_t payloadBytes) {
+    size_t bytes = offsetof(MpscSlot, data) + payloadBytes;
+    return (bytes + 7) / 8 * 8;
+}
+
+} // namespace
+
+MpscRing::MpscRing() : header(nullptr), slots(nullptr), senderStats(nullptr), acquireNext(0), outstanding(0) {}
+
+MpscRing::~MpscRing() {
+    Close();
+}
+
+size_t MpscRing::RegionBytes(int capacity, size_t payloadBytes) {
+    return HeaderBytes() + (size_t)capacity * SlotBytesFor(payloadBytes);
+}
+
+bool MpscRing::Create(const std::string& name, int capacity, size_t payloadBytes) {
+    if (capacity < kMinRingCapacity || payloadBytes == 0) return false;
+    if (!region.Create(name, RegionBytes(capacity, payloadBytes))) return false;
+    return Format(region.Data(), capacity, payloadBytes);
+}
+
+bool MpscRing::Format(void* memory, int capacity, size_t payloadBytes) {
+    if (capacity < kMinRingCapacity || payloadBytes == 0) return false;
+    header = static_cast<MpscRingHeader*>(memory);
+    slots = static_cast<char*>(memory) + HeaderBytes();
+    header->capacity = (uint32_t)capacity;
+    header->slotBytes = (uint32_t)SlotBytesFor(payloadBytes);
+    header->payloadBytes = (uint32_t)payloadBytes;
+    for (uint64_t pos = 0; pos < (uint64_t)capacity; pos++) {
+        SlotAt(pos)->sequence.store(pos, std::memory_order_relaxed);
+    }
+
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = kMpscRingMagic;
+    return true;
+}
+
+bool MpscRing::Open(const std::string& name, bool readOnly) {
+    if (!region.Open(name, readOnly) || !Attach(region.Data(), region.Size())) {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+bool MpscRing::Attach(void* memory, size_t bytes) {
+    header = nullptr;
+    slots = nullptr;
+    if (bytes < HeaderBytes()) return false;
+
+    MpscRingHeader* candidate = static_cast<MpscRingHeader*>(memory);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (candidate->magic != kMpscRingMagic || candidate->capacity < (uint32_t)kMinRingCapacity
+        || bytes < HeaderBytes() + (size_t)candidate->capacity * candidate->slotBytes) {
+        return false;
+    }
+
+    header = candidate;
+    slots = static_cast<char*>(memory) + HeaderBytes();
+    return true;
+}
+
+void MpscRing::Close() {
+    if (header) ReleaseSenderStats(header->stats, senderStats.exchange(nullptr));
+    region.Close();
+    header = nullptr;
+    slots = nullptr;
+    released.clear();
+    outstanding = 0;
+}
+
+int MpscRing::Count() const {
+    if (!header) return 0;
+    uint64_t head = header->head.load(std::memory_order_acquire);
+    uint64_t tail = header->tail.load(std::memory_order_acquire);
+    return tail > head ? (int)(tail - head) : 0;
+}
+
+bool MpscRing::TryReserve(uint64_t& pos) {
+    pos = header->tail.load(std::memory_order_relaxed);
+    for (;;) {
+        uint64_t sequence = SlotAt(pos)->sequence.load(std::memory_order_acquire);
+        int64_t diff = (int64_t)(sequence - pos);
+
+        if (diff == 0) {
+            if (header->tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) return true;
+        }
+        else if (diff < 0) {
+            return false;  // the receiver has not freed this slot from the previous lap
+        }
+        else {
+            pos = header->tail.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+// Up to `wanted` consecutive positions with one CAS. Slots are freed in ring
+// order, so if the last slot of the run is free for this lap, all are.
+size_t MpscRing::TryReserveRun(size_t wanted, uint64_t& first) {
+    for (;;) {
+        uint64_t tail = header->tail.load(std::memory_order_relaxed);
+        uint64_t head = header->head.load(std::memory_order_acquire);
+        uint64_t used = tail - head;
+        if (used >= header->capacity) {
+            // head lags while the receiver is inside a batch; fall back to the slot itself.
+            uint64_t pos;
+            if (!TryReserve(pos)) return 0;
+            first = pos;
+            return 1;
+        }
+
+        size_t run = (size_t)std::min<uint64_t>(wanted, header->capacity - used);
+        uint64_t last = tail + run - 1;
+        if (SlotAt(last)->sequence.load(std::memory_order_acquire) != last) continue;
+
+        if (header->tail.compare_exchange_weak(tail, tail + run, std::memory_order_relaxed)) {
+            first = tail;
+            return run;
+        }
+    }
+}
+
+void MpscRing::NotifyData() {
+    QueueNotify(header->dataSignal, header->dataWaiters);
+}
+
+void MpscRing::NotifySpace() {
+    QueueNotify(header->spaceSignal, header->spaceWaiters);
+}
+
+// Threads sending through one MpscRing share its slot.
+QueueSenderStats& MpscRing::SenderStats() {
+    return HeldSenderStats(header->stats, senderStats);
+}
+
+// The depth is measured against a head that may be stale, so it is capped.
+void MpscRing::RecordSent(QueueSenderStats& stats, uint64_t last, size_t count) {
+    uint64_t head = header->head.load(std::memory_order_relaxed);
+    uint64_t depth = std::min<uint64_t>(last + 1 - std::min(head, last + 1), header->capacity);
+    QueueStatsSent(header->stats, stats, count, depth);
+}
+
+bool MpscRing::Send(const std::string& text, int timeoutMs, int* msgId) {
+    return SendBytes(text.data(), text.size(), timeoutMs, msgId);
+}
+
+bool MpscRing::SendBytes(const void* data, size_t length, int timeoutMs, int* msgId) {
+    if (!header) return false;
+    int64_t deadline = QueueDeadline(timeoutMs);
+    QueueSenderStats& stats = SenderStats();
+
+    uint64_t pos;
+    int64_t waitStart = 0;
+    while (!TryReserve(pos)) {
+        if (timeoutMs == 0) return false;
+        if (!waitStart) waitStart = QueueClockNs();
+        bool waited = QueueSleepUnless(header->spaceSignal, header->spaceWaiters, deadline, [this]() {
+            uint64_t tail = header->tail.load(std::memory_order_relaxed);
+            return (int64_t)(SlotAt(tail)->sequence.load(std::memory_order_acquire) - tail) >= 0;
+        });
+        if (!waited) {
+            QueueStatsFullWait(stats, waitStart);
+            return false;
+        }
+    }
+    if (waitStart) QueueStatsFullWait(stats, waitStart);
+
+    MpscSlot* slot = SlotAt(pos);
+    slot->length = (uint32_t)std::min(length, (size_t)header->payloadBytes);
+    memcpy(slot->data, data, slot->length);
+    slot->sequence.store(pos + 1, std::memory_order_release);
+
+    if (msgId) *msgId = (int)(pos + 1);
+    RecordSent(stats, pos, 1);
+    NotifyData();
+    return true;
+}
+
+size_t MpscRing::SendBatch(const std::vector<std::string>& texts, int timeoutMs, int* firstMsgId) {
+    if (!header) return 0;
+    int64_t deadline = QueueDeadline(timeoutMs);
+    QueueSenderStats& stats = SenderStats();
+    size_t sent = 0;
+    int64_t waitStart = 0;
+
+    while (sent < texts.size()) {
+        uint64_t first;
+        size_t run = TryReserveRun(texts.size() - sent, first);
+        if (run == 0) {
+            if (timeoutMs == 0) break;
+            if (!waitStart) waitStart = QueueClockNs();
+            bool waited = QueueSleepUnless(header->spaceSignal, header->spaceWaiters, deadline, [this]() {
+                uint64_t tail = header->tail.load(std::memory_order_relaxed);
+                return (int64_t)(SlotAt(tail)->sequence.load(std::memory_order_acquire) - tail) >= 0;
+            });
+            if (!waited) {
+                QueueStatsFullWait(stats, waitStart);
+                break;
+            }
+            continue;
+        }
+        if (waitStart) {
+            QueueStatsFullWait(stats, waitStart);
+            waitStart = 0;
+        }
+
+        if (sent == 0 && firstMsgId) *firstMsgId = (int)(first + 1);
+        for (size_t i = 0; i < run; i++) {
+            const std::string& text = texts[sent + i];
+            MpscSlot* slot = SlotAt(first + i);
+            slot->length = (uint32_t)std::min(text.size(), (size_t)header->payloadBytes);
+            memcpy(slot->data, text.data(), slot->length);
+            slot->sequence.store(first + i + 1, std::memory_order_release);
+        }
+        sent += run;
+        RecordSent(stats, first + run - 1, run);
+        NotifyData();
+    }
+    return sent;
+}
+
+size_t MpscRing::ReadBatch(std::vector<ReceivedMessage>& out, size_t maxMessages, int timeoutMs) {
+    out.clear();
+    if (!header || maxMessages == 0 || outstanding) return 0;
+    int64_t deadline = QueueDeadline(timeoutMs);
+
+    uint64_t head = header->head.load(std::memory_order_relaxed);
+    if (!WaitPublished(head, deadline, timeoutMs != 0)) return 0;
+
+    uint64_t pos = head;
+    while (out.size() < maxMessages) {
+        MpscSlot* slot = SlotAt(pos);
+        if (slot->sequence.load(std::memory_order_acquire) != pos + 1) break;
+
+        out.push_back({ (int)(pos + 1), std::string(slot->data, slot->length) });
+        slot->sequence.store(pos + header->capacity, std::memory_order_release);
+        pos++;
+    }
+
+    header->head.store(pos, std::memory_order_release);
+    QueueStatsReceived(header->stats, out.size());
+    NotifySpace();
+    return out.size();
+}
+
+bool MpscRing::Read(std::string& message, int& msgId, int timeoutMs) {
+    if (!header || outstanding) return false;
+
+    uint64_t pos = header->head.load(std::memory_order_relaxed);
+    if (!WaitPublished(pos, QueueDeadline(timeoutMs), timeoutMs != 0)) return false;
+
+    MpscSlot* slot = SlotAt(pos);
+    message.assign(slot->data, slot->length);
+    msgId = (int)(pos + 1);
+
+    slot->sequence.store(pos + header->capacity, std::memory_order_release);
+    header->head.store(pos + 1, std::memory_order_release);
+    QueueStatsReceived(header->stats, 1);
+    NotifySpace();
+    return true;
+}
+
+// A wait counts toward the empty-wait stats unless the caller only tried.
+bool MpscRing::WaitPublished(uint64_t pos, int64_t deadline, bool counted) {
+    MpscSlot* slot = SlotAt(pos);
+    auto published = [slot, pos]() { return slot->sequence.load(std::memory_order_acquire) == pos + 1; };
+    if (published()) return true;
+
+    int64_t waitStart = counted ? QueueClockNs() : 0;
+    bool ready = true;
+    while (ready && !published()) {
+        ready = QueueSleepUnless(header->dataSignal, header->dataWaiters, deadline, published);
+    }
+    if (counted) QueueStatsEmptyWait(header->stats, waitStart);
+    return ready;
+}
+
+MessageView MpscRing::ViewAt(uint64_t pos) {
+    MpscSlot* slot = SlotAt(pos);
+    acquireNext = pos + 1;
+    outstanding++;
+    QueueStatsReceived(header->stats, 1);
+    return { slot->data, slot->length, (int)(pos + 1), pos };
+}
+
+bool MpscRing::Acquire(MessageView& view, int timeoutMs) {
+    if (!header) return false;
+    if (released.size() != header->capacity) released.assign(header->capacity, 0);
+
+    uint64_t pos = outstanding ? acquireNext : header->head.load(std::memory_order_relaxed);
+    if (pos - header->head.load(std::memory_order_relaxed) >= header->capacity) return false;
+    if (!WaitPublished(pos, QueueDeadline(timeoutMs), timeoutMs != 0)) return false;
+
+    view = ViewAt(pos);
+    return true;
+}
+
+size_t MpscRing::AcquireBatch(std::vector<MessageView>& views, size_t maxMessages, int timeoutMs) {
+    views.clear();
+    MessageView view;
+    if (maxMessages == 0 || !Acquire(view, timeoutMs)) return 0;
+    views.push_back(view);
+
+    uint64_t head = header->head.load(std::memory_order_relaxed);
+    while (views.size() < maxMessages && acquireNext - head < header->capacity
+        && SlotAt(acquireNext)->sequence.load(std::memory_order_acquire) == acquireNext + 1) {
+        views.push_back(ViewAt(acquireNext));
+    }
+    return views.size();
+}
+
+void MpscRing::Release(const MessageView& view) {
+    if (!header || outstanding == 0) return;
+    released[view.position % header->capacity] = 1;
+    outstanding--;
+
+    uint64_t head = header->head.load(std::memory_order_relaxed);
+    uint64_t start = head;
+    while (head < acquireNext && released[head % header->capacity]) {
+        released[head % header->capacity] = 0;
+        SlotAt(head)->sequence.store(head + header->capacity, std::memory_order_release);
+        head++;
+    }
+
+    if (head != start) {
+        header->head.store(head, std::memory_order_release);
+        NotifySpace();
+    }
+}
@@ -0,0 +1,311 @@
+#include "partitioned_queue.h"
+#include "queue_futex.h"
+#include <algorithm>
+
+namespace {
+
+const uint32_t kPartitionedMagic = 0x50415254;  // "PART"
+
+size_t HeaderBytes() {
+    return (sizeof(PartitionedQueueHeader) + kQueueCacheLine - 1) / kQueueCacheLine * kQueueCacheLine;
+}
+
+} // namespace
+
+PartitionedQueue::PartitionedQueue() : header(nullptr), member(-1), nextRead(0), nextReapNs(0) {}
+
+PartitionedQueue::~PartitionedQueue() {
+    Close();
+}
+
+bool PartitionedQueue::Create(const std::string& name, int partitions, int capacity, size_t payloadBytes) {
+    Close();
+    if (partitions <= 0 || partitions > kMaxPartitions || capacity < kMinRingCapacity || payloadBytes == 0) return false;
+
+    size_t ringBytes = MpscRing::RegionBytes(capacity, payloadBytes);
+    ringBytes = (ringBytes + kQueueCacheLine - 1) / kQueueCacheLine * kQueueCacheLine;
+    if (!region.Create(name, HeaderBytes() + (size_t)partitions * ringBytes)) return false;
+
+    char* base = static_cast<char*>(region.Data());
+    header = reinterpret_cast<PartitionedQueueHeader*>(base);
+    header->partitions = (uint32_t)partitions;
+    header->ringBytes = ringBytes;
+    for (int p = 0; p < partitions; p++) {
+        rings.emplace_back(new MpscRing());
+        rings[p]->Format(base + HeaderBytes() + (size_t)p * ringBytes, capacity, payloadBytes);
+    }
+
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = kPartitionedMagic;
+    return true;
+}
+
+bool PartitionedQueue::Open(const std::string& name, bool readOnly) {
+    Close();
+    if (!region.Open(name, readOnly) || region.Size() < HeaderBytes()) {
+        Close();
+        return false;
+    }
+
+    char* base = static_cast<char*>(region.Data());
+    header = reinterpret_cast<PartitionedQueueHeader*>(base);
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (header->magic != kPartitionedMagic || header->partitions == 0 || header->partitions > kMaxPartitions
+        || region.Size() < HeaderBytes() + header->partitions * header->ringBytes) {
+        Close();
+        return false;
+    }
+
+    for (uint32_t p = 0; p < header->partitions; p++) {
+        rings.emplace_back(new MpscRing());
+        if (!rings[p]->Attach(base + HeaderBytes() + p * header->ringBytes, (size_t)header->ringBytes)) {
+            Close();
+            return false;
+        }
+    }
+    return true;
+}
+
+void PartitionedQueue::Close() {
+    if (member >= 0) Leave();
+    rings.clear();
+    region.Close();
+    header = nullptr;
+}
+
+int PartitionedQueue::PartitionFor(const std::string& key) const {
+    if (!header) return 0;
+    // FNV-1a: the same in every process, unlike std::hash.
+    uint32_t hash = 2166136261u;
+    for (unsigned char c : key) {
+        hash ^= c;
+        hash *= 16777619u;
+    }
+    return (int)(hash % header->partitions);
+}
+
+int PartitionedQueue::Count() const {
+    int count = 0;
+    for (const auto& ring : rings) count += ring->Count();
+    return count;
+}
+
+void PartitionedQueue::NotifyData() {
+    QueueNotify(header->dataSignal, header->dataWaiters);
+}
+
+bool PartitionedQueue::Send(const std::string& text, int timeoutMs, int* msgId, int* partition) {
+    if (!header) return false;
+    int partitions = (int)header->partitions;
+    int first = (int)(header->nextPartition.fetch_add(1, std::memory_order_relaxed) % partitions);
+
+    int chosen = -1;
+    for (int i = 0; i < partitions && chosen < 0; i++) {
+        int p = (first + i) % partitions;
+        if (rings[p]->Send(text, 0, msgId)) chosen = p;
+    }
+    // All full: wait for room in the partition whose turn it was.
+    if (chosen < 0) {
+        if (!rings[first]->Send(text, timeoutMs, msgId)) return false;
+        chosen = first;
+    }
+
+    if (partition) *partition = chosen;
+    NotifyData();
+    return true;
+}
+
+bool PartitionedQueue::SendKeyed(const std::string& key, const std::string& text, int timeoutMs, int* msgId) {
+    if (!header || !rings[PartitionFor(key)]->Send(text, timeoutMs, msgId)) return false;
+    NotifyData();
+    return true;
+}
+
+// Called under memberLock. Returns whether any member was reaped.
+bool PartitionedQueue::ReapDeadMembers() {
+    bool reaped = false;
+    for (int m = 0; m < kMaxPartitionReceivers; m++) {
+        PartitionMember& slot = header->members[m];
+        if (!slot.active.load(std::memory_order_relaxed) || ProcessAlive(slot.pid)) continue;
+
+        slot.active.store(0, std::memory_order_relaxed);
+        for (uint32_t p = 0; p < header->partitions; p++) {
+            uint32_t held = (uint32_t)m + 1;
+            header->reader[p].compare_exchange_strong(held, 0, std::memory_order_release);
+        }
+        reaped = true;
+    }
+    return reaped;
+}
+
+// Receiver side, when a read finds nothing: at most once per
+// kReapIntervalMs, so wakes meant for other members stay cheap.
+void PartitionedQueue::ReapIfDue() {
+    int64_t now = QueueClockNs();
+    if (now < nextReapNs) return;
+    nextReapNs = now + (int64_t)kReapIntervalMs * 1000000;
+
+    QueueLock(&header->memberLock);
+    if (ReapDeadMembers()) Rebalance();
+    QueueUnlock(&header->memberLock);
+}
+
+// A waiting receiver sleeps no longer than until its next reap, so a member
+// that died holding partitions with messages queued is noticed even when no
+// new message arrives. Only a slice ending at the caller's deadline is a
+// timeout.
+int64_t PartitionedQueue::WaitSliceEnd(int64_t deadline) const {
+    return deadline < 0 ? nextReapNs : std::min(deadline, nextReapNs);
+}
+
+// Called under memberLock: partition p goes to the (p mod n)-th of the n
+// active members, so every member gets partitions/n of them, give or take one.
+void PartitionedQueue::Rebalance() {
+    int active[kMaxPartitionReceivers];
+    int count = 0;
+    for (int m = 0; m < kMaxPartitionReceivers; m++) {
+        if (header->members[m].active.load(std::memory_order_relaxed)) active[count++] = m;
+    }
+
+    for (uint32_t p = 0; p < header->partitions; p++) {
+        uint32_t owner = count ? (uint32_t)active[p % count] + 1 : 0;
+        header->owner[p].store(owner, std::memory_order_release);
+    }
+    header->generation.fetch_add(1, std::memory_order_release);
+    NotifyData();
+}
+
+bool PartitionedQueue::Join() {
+    if (!header) return false;
+    if (member >= 0) return true;
+
+    QueueLock(&header->memberLock);
+    ReapDeadMembers();
+    for (int m = 0; m < kMaxPartitionReceivers && member < 0; m++) {
+        PartitionMember& slot = header->members[m];
+        if (slot.active.load(std::memory_order_relaxed)) continue;
+        slot.pid = CurrentProcessId();
+        slot.active.store(1, std::memory_order_relaxed);
+        member = m;
+    }
+    if (member >= 0) Rebalance();
+    QueueUnlock(&header->memberLock);
+    return member >= 0;
+}
+
+void PartitionedQueue::Leave() {
+    if (!header || member < 0) return;
+
+    QueueLock(&header->memberLock);
+    header->members[member].active.store(0, std::memory_order_relaxed);
+    member = -1;
+    Rebalance();
+    QueueUnlock(&header->memberLock);
+}
+
+std::vector<int> PartitionedQueue::OwnedPartitions() const {
+    std::vector<int> owned;
+    if (!header || member < 0) return owned;
+    for (uint32_t p = 0; p < header->partitions; p++) {
+        if (header->owner[p].load(std::memory_order_acquire) == (uint32_t)member + 1) owned.push_back((int)p);
+    }
+    return owned;
+}
+
+bool PartitionedQueue::OwnsReadable(int p) const {
+    return header->owner[p].load(std::memory_order_acquire) == (uint32_t)member + 1
+        && header->reader[p].load(std::memory_order_acquire) == 0
+        && rings[p]->Count() > 0;
+}
+
+bool PartitionedQueue::AnyOwnedReadable() const {
+    for (uint32_t p = 0; p < header->partitions; p++) {
+        if (OwnsReadable((int)p)) return true;
+    }
+    return false;
+}
+
+// The reader word keeps a partition single-consumer across a handover: the
+// new owner skips it until the old one is out, and the old one wakes the
+// new one when it gets out and finds the partition no longer its own.
+bool PartitionedQueue::TryReadOwned(std::string& message, int& msgId, int& partition) {
+    int partitions = (int)header->partitions;
+    uint32_t self = (uint32_t)member + 1;
+
+    for (int i = 0; i < partitions; i++) {
+        int p = (nextRead + i) % partitions;
+        if (!OwnsReadable(p)) continue;
+
+        uint32_t idle = 0;
+        if (!header->reader[p].compare_exchange_strong(idle, self, std::memory_order_acquire)) continue;
+        bool read = header->owner[p].load(std::memory_order_acquire) == self && rings[p]->Read(message, msgId, 0);
+        header->reader[p].store(0, std::memory_order_release);
+        if (header->owner[p].load(std::memory_order_acquire) != self) NotifyData();
+
+        if (read) {
+            partition = p;
+            nextRead = (p + 1) % partitions;
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t PartitionedQueue::TryReadBatchOwned(std::vector<ReceivedMessage>& out, size_t maxMessages) {
+    int partitions = (int)header->partitions;
+    uint32_t self = (uint32_t)member + 1;
+    std::vector<ReceivedMessage> taken;
+
+    for (int i = 0; i < partitions && out.size() < maxMessages; i++) {
+        int p = (nextRead + i) % partitions;
+        if (!OwnsReadable(p)) continue;
+
+        uint32_t idle = 0;
+        if (!header->reader[p].compare_exchange_strong(idle, self, std::memory_order_acquire)) continue;
+        if (header->owner[p].load(std::memory_order_acquire) == self) {
+            rings[p]->ReadBatch(taken, maxMessages - out.size(), 0);
+        }
+        header->reader[p].store(0, std::memory_order_release);
+        if (header->owner[p].load(std::memory_order_acquire) != self) NotifyData();
+
+        for (auto& m : taken) {
+            m.partition = p;
+            out.push_back(std::move(m));
+        }
+        taken.clear();
+    }
+    nextRead = (nextRead + 1) % partitions;
+    return out.size();
+}
+
+bool PartitionedQueue::Read(std::string& message, int& msgId, int* partition, int timeoutMs) {
+    if (!header || member < 0) return false;
+    int64_t deadline = QueueDeadline(timeoutMs);
+
+    int p;
+    while (!TryReadOwned(message, msgId, p)) {
+        ReapIfDue();
+        int64_t sliceEnd = WaitSliceEnd(deadline);
+        bool waited = QueueSleepUnless(header->dataSignal, header->dataWaiters, sliceEnd,
+            [this]() { return AnyOwnedReadable(); });
+        if (!waited && sliceEnd == deadline) return false;
+    }
+    if (partition) *partition = p;
+    return true;
+}
+
+size_t PartitionedQueue::ReadBatch(std::vector<ReceivedMessage>& out, size_t maxMessages, int timeoutMs) {
+    out.clear();
+    if (!header || member < 0 || maxMessages == 0) return 0;
+    int64_t deadline = QueueDeadline(timeoutMs);
+
+    while (TryReadBatchOwned(out, maxMessages) == 0) {
+        ReapIfDue();
+        int64_t sliceEnd = WaitSliceEnd(deadline);
+        bool waited = QueueSleepUnless(header->dataSignal, header->dataWaiters, sliceEnd,
+            [this]() { return AnyOwnedReadable(); });
+        if (!waited && sliceEnd == deadline) return 0;
+    }
+    return out.size();
+}
@@ -0,0 +1,236 @@
+#include "priority_queue.h"
+#include "queue_futex.h"
+#include <algorithm>
+
+namespace {
+
+const uint32_t kPriorityMagic = 0x5052494F;  // "PRIO"
+
+size_t HeaderBytes() {
+    return (sizeof(PriorityQueueHeader) + kQueueCacheLine - 1) / kQueueCacheLine * kQueueCacheLine;
+}
+
+} // namespace
+
+PriorityQueue::PriorityQueue() : header(nullptr) {}
+
+PriorityQueue::~PriorityQueue() {
+    Close();
+}
+
+bool PriorityQueue::Create(const std::string& name, int levels, int capacity, int reserve, int starvationWeight,
+    size_t payloadBytes) {
+    Close();
+    if (levels <= 0 || levels > kMaxPriorities || capacity <= 0 || reserve < 0 || starvationWeight < 0
+        || (int64_t)reserve * (levels - 1) >= capacity || payloadBytes == 0) {
+        return false;
+    }
+
+    // The budget keeps each ring's count within capacity; a one-message
+    // budget still needs a ring of the minimum size.
+    int slots = std::max(capacity, kMinRingCapacity);
+    size_t ringBytes = MpscRing::RegionBytes(slots, payloadBytes);
+    ringBytes = (ringBytes + kQueueCacheLine - 1) / kQueueCacheLine * kQueueCacheLine;
+    if (!region.Create(name, HeaderBytes() + (size_t)levels * ringBytes)) return false;
+
+    char* base = static_cast<char*>(region.Data());
+    header = reinterpret_cast<PriorityQueueHeader*>(base);
+    header->levels = (uint32_t)levels;
+    header->capacity = (uint32_t)capacity;
+    header->reserve = (uint32_t)reserve;
+    header->starvationWeight = (uint32_t)starvationWeight;
+    header->ringBytes = ringBytes;
+    for (int p = 0; p < levels; p++) {
+        rings.emplace_back(new MpscRing());
+        rings[p]->Format(base + HeaderBytes() + (size_t)p * ringBytes, slots, payloadBytes);
+    }
+    passedOver.assign(levels, 0);
+
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = kPriorityMagic;
+    return true;
+}
+
+bool PriorityQueue::Open(const std::string& name, bool readOnly) {
+    Close();
+    if (!region.Open(name, readOnly) || region.Size() < HeaderBytes()) {
+        Close();
+        return false;
+    }
+
+    char* base = static_cast<char*>(region.Data());
+    header = reinterpret_cast<PriorityQueueHeader*>(base);
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (header->magic != kPriorityMagic || header->levels == 0 || header->levels > kMaxPriorities
+        || region.Size() < HeaderBytes() + header->levels * header->ringBytes) {
+        Close();
+        return false;
+    }
+
+    for (uint32_t p = 0; p < header->levels; p++) {
+        rings.emplace_back(new MpscRing());
+        if (!rings[p]->Attach(base + HeaderBytes() + p * header->ringBytes, (size_t)header->ringBytes)) {
+            Close();
+            return false;
+        }
+    }
+    passedOver.assign(header->levels, 0);
+    return true;
+}
+
+void PriorityQueue::Close() {
+    rings.clear();
+    passedOver.clear();
+    region.Close();
+    header = nullptr;
+}
+
+int PriorityQueue::Count() const {
+    int count = 0;
+    for (const auto& ring : rings) count += ring->Count();
+    return count;
+}
+
+uint32_t PriorityQueue::LevelLimit(int priority) const {
+    return header->capacity - header->reserve * (header->levels - 1 - (uint32_t)priority);
+}
+
+// Takes up to `wanted` units of the budget with one CAS.
+size_t PriorityQueue::TryTakeBudget(int priority, size_t wanted) {
+    uint32_t limit = LevelLimit(priority);
+    uint32_t used = header->used.load(std::memory_order_relaxed);
+    for (;;) {
+        if (used >= limit) return 0;
+        uint32_t take = (uint32_t)std::min<size_t>(wanted, limit - used);
+        if (header->used.compare_exchange_weak(used, used + take, std::memory_order_acquire)) return take;
+    }
+}
+
+bool PriorityQueue::WaitBudget(int priority, int64_t deadline) {
+    uint32_t limit = LevelLimit(priority);
+    return QueueSleepUnless(header->spaceSignal, header->spaceWaiters, deadline,
+        [this, limit]() { return header->used.load(std::memory_order_relaxed) < limit; });
+}
+
+// Called once the messages are out of their rings, so a sender holding a
+// unit of the budget always finds its ring slot free.
+void PriorityQueue::ReturnBudget(size_t count) {
+    header->used.fetch_sub((uint32_t)count, std::memory_order_release);
+    QueueNotify(header->spaceSignal, header->spaceWaiters);
+}
+
+bool PriorityQueue::Send(const std::string& text, int priority, int timeoutMs, int* msgId) {
+    if (!header || priority < 0 || priority >= (int)header->levels) return false;
+    int64_t deadline = QueueDeadline(timeoutMs);
+
+    while (TryTakeBudget(priority, 1) == 0) {
+        if (!WaitBudget(priority, deadline)) return false;
+    }
+    if (!rings[priority]->Send(text, 0, msgId)) {
+        ReturnBudget(1);
+        return false;
+    }
+    QueueNotify(header->dataSignal, header->dataWaiters);
+    return true;
+}
+
+size_t PriorityQueue::SendBatch(const std::vector<std::string>& texts, int priority, int timeoutMs,
+    int* firstMsgId) {
+    if (!header || priority < 0 || priority >= (int)header->levels) return 0;
+    int64_t deadline = QueueDeadline(timeoutMs);
+    size_t sent = 0;
+
+    while (sent < texts.size()) {
+        size_t taken = TryTakeBudget(priority, texts.size() - sent);
+        if (taken == 0) {
+            if (!WaitBudget(priority, deadline)) break;
+            continue;
+        }
+
+        std::vector<std::string> run(texts.begin() + sent, texts.begin() + sent + taken);
+        size_t queued = rings[priority]->SendBatch(run, 0, sent == 0 ? firstMsgId : nullptr);
+        if (queued < taken) ReturnBudget(taken - queued);
+        sent += queued;
+        QueueNotify(header->dataSignal, header->dataWaiters);
+        if (queued < taken) break;
+    }
+    return sent;
+}
+
+bool PriorityQueue::AnyQueued() const {
+    for (const auto& ring : rings) {
+        if (ring->Count() > 0) return true;
+    }
+    return false;
+}
+
+// The most passed-over waiting level whose turn has come goes first, then
+// the levels from the top down; a level counted but not yet published by
+// its sender is skipped this time. Every waiting level below the one served
+// has been passed over once more.
+bool PriorityQueue::TryReadNext(std::string& message, int& msgId, int& priority) {
+    int levels = (int)header->levels;
+    int order[kMaxPriorities + 1];
+    int count = 0;
+
+    uint32_t weight = header->starvationWeight;
+    if (weight) {
+        int starved = -1;
+        for (int p = levels - 2; p >= 0; p--) {
+            if (passedOver[p] >= weight && rings[p]->Count() > 0
+                && (starved < 0 || passedOver[p] > passedOver[starved])) {
+                starved = p;
+            }
+        }
+        if (starved >= 0) order[count++] = starved;
+    }
+    for (int p = levels - 1; p >= 0; p--) order[count++] = p;
+
+    for (int i = 0; i < count; i++) {
+        int p = order[i];
+        if (rings[p]->Count() == 0 || !rings[p]->Read(message, msgId, 0)) continue;
+
+        passedOver[p] = 0;
+        for (int below = 0; below < p; below++) {
+            if (rings[below]->Count() > 0) passedOver[below]++;
+        }
+        priority = p;
+        return true;
+    }
+    return false;
+}
+
+bool PriorityQueue::Read(std::string& message, int& msgId, int* priority, int timeoutMs) {
+    if (!header) return false;
+    int64_t deadline = QueueDeadline(timeoutMs);
+
+    int p;
+    while (!TryReadNext(message, msgId, p)) {
+        bool waited = QueueSleepUnless(header->dataSignal, header->dataWaiters, deadline,
+            [this]() { return AnyQueued(); });
+        if (!waited) return false;
+    }
+    ReturnBudget(1);
+    if (priority) *priority = p;
+    return true;
+}
+
+// Message by message in the order Read would take them, so a batch follows
+// the same priority and anti-starvation rules.
+size_t PriorityQueue::ReadBatch(std::vector<ReceivedMessage>& out, size_t maxMessages, int timeoutMs) {
+    out.clear();
+    if (!header || maxMessages == 0) return 0;
+
+    ReceivedMessage m;
+    if (!Read(m.text, m.msgId, &m.priority, timeoutMs)) return 0;
+    out.push_back(m);
+
+    size_t taken = 0;
+    while (out.size() < maxMessages && TryReadNext(m.text, m.msgId, m.priority)) {
+        out.push_back(m);
+        taken++;
+    }
+    if (taken) ReturnBudget(taken);
+    return out.size();
+}
@@ -0,0 +1,39 @@
+#include "queue_backend.h"
+
+bool ParseQueueBackend(const std::string& name, QueueBackend& backend) {
+    if (name == "file") backend = BACKEND_FILE;
+    else if (name == "shm") backend = BACKEND_SHM;
+    else if (name == "ring") backend = BACKEND_RING;
+    else if (name == "varlen") backend = BACKEND_VARLEN;
+    else if (name == "partitioned") backend = BACKEND_PARTITIONED;
+    else if (name == "priority") backend = BACKEND_PRIORITY;
+    else return false;
+    return true;
+}
+
+const char* QueueBackendName(QueueBackend backend) {
+    switch (backend) {
+    case BACKEND_SHM: return "shm";
+    case BACKEND_RING: return "ring";
+    case BACKEND_VARLEN: return "varlen";
+    case BACKEND_PARTITIONED: return "partitioned";
+    case BACKEND_PRIORITY: return "priority";
+    default: return "file";
+    }
+}
+
+bool ParseQueueDurability(const std::string& name, QueueDurability& durability) {
+    if (name == "memory") durability = DURABILITY_MEMORY;
+    else if (name == "async") durability = DURABILITY_ASYNC;
+    else if (name == "group") durability = DURABILITY_GROUP;
+    else return false;
+    return true;
+}
+
+const char* QueueDurabilityName(QueueDurability durability) {
+    switch (durability) {
+    case DURABILITY_ASYNC: return "async";
+    case DURABILITY_GROUP: return "group";
+    default: return "memory";
+    }
+}
@@ -0,0 +1,83 @@
+#include "queue_futex.h"
+#include <chrono>
+#include <climits>
+#include <thread>
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex word must be a plain 32-bit integer");
+
+#if defined(__linux__)
+
+void QueueWait(std::atomic<uint32_t>* word, uint32_t expected, int timeoutMs) {
+    timespec timeout;
+    timespec* limit = nullptr;
+    if (timeoutMs >= 0) {
+        timeout.tv_sec = timeoutMs / 1000;
+        timeout.tv_nsec = (long)(timeoutMs % 1000) * 1000000;
+        limit = &timeout;
+    }
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAIT, expected, limit, nullptr, 0);
+}
+
+void QueueWake(std::atomic<uint32_t>* word, int count) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE, count, nullptr, nullptr, 0);
+}
+
+#else
+
+void QueueWait(std::atomic<uint32_t>* word, uint32_t expected, int timeoutMs) {
+    if (word->load() != expected) return;
+    int ms = timeoutMs < 0 ? 1 : (timeoutMs < 1 ? timeoutMs : 1);
+    if (ms > 0) std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+    else std::this_thread::yield();
+}
+
+void QueueWake(std::atomic<uint32_t>*, int) {
+}
+
+#endif
+
+void QueueWakeAll(std::atomic<uint32_t>* word) {
+    QueueWake(word, INT_MAX);
+}
+
+void QueueLock(std::atomic<uint32_t>* word) {
+    uint32_t state = 0;
+    if (word->compare_exchange_strong(state, 1, std::memory_order_acquire)) return;
+
+    for (int spin = 0; spin < 100; spin++) {
+        state = 0;
+        if (word->compare_exchange_weak(state, 1, std::memory_order_acquire)) return;
+    }
+
+    // From here on the word says "held with sleepers", so the unlock wakes us.
+    while (word->exchange(2, std::memory_order_acquire) != 0) {
+        QueueWait(word, 2);
+    }
+}
+
+void QueueUnlock(std::atomic<uint32_t>* word) {
+    if (word->exchange(0, std::memory_order_release) == 2) QueueWake(word, 1);
+}
+
+int64_t QueueClockNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int64_t QueueDeadline(int timeoutMs) {
+    return timeoutMs < 0 ? -1 : QueueClockNs() + (int64_t)timeoutMs * 1000000;
+}
+
+void QueueNotify(std::atomic<uint32_t>& signal, std::atomic<uint32_t>& waiters) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiters.load(std::memory_order_relaxed) == 0) return;
+    signal.fetch_add(1, std::memory_order_relaxed);
+    QueueWakeAll(&signal);
+}
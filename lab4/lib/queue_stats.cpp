@@ -0,0 +1,102 @@
+#include "queue_stats.h"
+#include "queue_futex.h"
+#include "shared_region.h"
+
+namespace {
+
+void Raise(std::atomic<uint64_t>& counter, uint64_t value) {
+    uint64_t seen = counter.load(std::memory_order_relaxed);
+    while (seen < value && !counter.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {}
+}
+
+void Add(std::atomic<uint64_t>& counter, uint64_t value) {
+    counter.fetch_add(value, std::memory_order_relaxed);
+}
+
+// Moves a slot's counts into `retired` and zeroes it for its next holder.
+void Retire(QueueStatsPage& page, QueueSenderStats& stats) {
+    Add(page.retired.enqueued, stats.enqueued.exchange(0, std::memory_order_relaxed));
+    Add(page.retired.fullWaits, stats.fullWaits.exchange(0, std::memory_order_relaxed));
+    Add(page.retired.waitNs, stats.waitNs.exchange(0, std::memory_order_relaxed));
+    Raise(page.retired.highWater, stats.highWater.exchange(0, std::memory_order_relaxed));
+}
+
+} // namespace
+
+QueueStatsTotals SumQueueStats(const QueueStatsPage& page) {
+    QueueStatsTotals totals;
+    auto add = [&totals](const QueueSenderStats& stats) {
+        totals.enqueued += stats.enqueued.load(std::memory_order_relaxed);
+        totals.fullWaits += stats.fullWaits.load(std::memory_order_relaxed);
+        totals.waitNs += stats.waitNs.load(std::memory_order_relaxed);
+    };
+    add(page.retired);
+    for (const auto& stats : page.senders) {
+        add(stats);
+        if (stats.pid.load(std::memory_order_relaxed) != 0) totals.senders++;
+    }
+
+    totals.highWater = page.highWater.load(std::memory_order_relaxed);
+    totals.dequeued = page.dequeued.load(std::memory_order_relaxed);
+    totals.emptyWaits = page.emptyWaits.load(std::memory_order_relaxed);
+    totals.emptyWaitNs = page.emptyWaitNs.load(std::memory_order_relaxed);
+    return totals;
+}
+
+QueueSenderStats* ClaimSenderStats(QueueStatsPage& page) {
+    int32_t self = CurrentProcessId();
+    for (auto& stats : page.senders) {
+        int32_t free = 0;
+        if (stats.pid.compare_exchange_strong(free, self, std::memory_order_relaxed)) return &stats;
+    }
+
+    for (auto& stats : page.senders) {
+        int32_t holder = stats.pid.load(std::memory_order_relaxed);
+        if (holder == 0 || holder == self || ProcessAlive(holder)) continue;
+        if (stats.pid.compare_exchange_strong(holder, self, std::memory_order_relaxed)) {
+            Retire(page, stats);
+            return &stats;
+        }
+    }
+    return &page.retired;
+}
+
+void ReleaseSenderStats(QueueStatsPage& page, QueueSenderStats* stats) {
+    if (!stats || stats == &page.retired) return;
+    Retire(page, *stats);
+    stats->pid.store(0, std::memory_order_relaxed);
+}
+
+QueueSenderStats& HeldSenderStats(QueueStatsPage& page, std::atomic<QueueSenderStats*>& held) {
+    QueueSenderStats* stats = held.load(std::memory_order_acquire);
+    if (stats) return *stats;
+
+    QueueSenderStats* claimed = ClaimSenderStats(page);
+    if (!held.compare_exchange_strong(stats, claimed, std::memory_order_acq_rel)) {
+        ReleaseSenderStats(page, claimed);
+        return *stats;
+    }
+    return *claimed;
+}
+
+void QueueStatsSent(QueueStatsPage& page, QueueSenderStats& stats, uint64_t count, uint64_t depth) {
+    Add(stats.enqueued, count);
+    if (depth > stats.highWater.load(std::memory_order_relaxed)) {
+        Raise(stats.highWater, depth);
+        Raise(page.highWater, depth);
+    }
+}
+
+void QueueStatsFullWait(QueueSenderStats& stats, int64_t startNs) {
+    Add(stats.fullWaits, 1);
+    Add(stats.waitNs, (uint64_t)(QueueClockNs() - startNs));
+}
+
+void QueueStatsEmptyWait(QueueStatsPage& page, int64_t startNs) {
+    Add(page.emptyWaits, 1);
+    Add(page.emptyWaitNs, (uint64_t)(QueueClockNs() - startNs));
+}
+
+void QueueStatsReceived(QueueStatsPage& page, uint64_t count) {
+    Add(page.dequeued, count);
+}
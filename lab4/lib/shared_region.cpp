@@ -0,0 +1,245 @@
+#include "shared_region.h"
+#include <cctype>
+#include <cstring>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+SharedRegion::SharedRegion() : data(nullptr), size(0) {
+#if defined(_WIN32)
+    mapping = nullptr;
+    file = INVALID_HANDLE_VALUE;
+#else
+    fd = -1;
+#endif
+}
+
+SharedRegion::~SharedRegion() {
+    Close();
+}
+
+std::string SharedRegionName(const std::string& filename) {
+    size_t slash = filename.find_last_of("\\/");
+    std::string base = slash == std::string::npos ? filename : filename.substr(slash + 1);
+
+    std::string name = "lab4_";
+    for (char c : base) name += std::isalnum((unsigned char)c) ? c : '_';
+    return name;
+}
+
+int32_t CurrentProcessId() {
+#if defined(_WIN32)
+    return (int32_t)GetCurrentProcessId();
+#else
+    return (int32_t)getpid();
+#endif
+}
+
+bool ProcessAlive(int32_t pid) {
+#if defined(_WIN32)
+    HANDLE process = OpenProcess(SYNCHRONIZE, FALSE, (DWORD)pid);
+    if (!process) return false;
+    bool alive = WaitForSingleObject(process, 0) == WAIT_TIMEOUT;
+    CloseHandle(process);
+    return alive;
+#else
+    return kill(pid, 0) == 0 || errno == EPERM;
+#endif
+}
+
+#if defined(_WIN32)
+
+bool SharedRegion::Create(const std::string& name, size_t bytes) {
+    Close();
+    std::string object = "Local\\" + name;
+    unsigned long long total = bytes;
+    mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+        (DWORD)(total >> 32), (DWORD)total, object.c_str());
+    if (!mapping) return false;
+
+    data = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, bytes);
+    if (!data) {
+        Close();
+        return false;
+    }
+    size = bytes;
+    memset(data, 0, bytes);
+    return true;
+}
+
+bool SharedRegion::Open(const std::string& name, bool readOnly) {
+    Close();
+    std::string object = "Local\\" + name;
+    DWORD access = readOnly ? FILE_MAP_READ : FILE_MAP_ALL_ACCESS;
+    mapping = OpenFileMappingA(access, FALSE, object.c_str());
+    if (!mapping) return false;
+
+    data = MapViewOfFile(mapping, access, 0, 0, 0);
+    if (!data) {
+        Close();
+        return false;
+    }
+    MEMORY_BASIC_INFORMATION info;
+    VirtualQuery(data, &info, sizeof(info));
+    size = info.RegionSize;
+    return true;
+}
+
+bool SharedRegion::MapFile(const std::string& path, size_t bytes) {
+    Close();
+    file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE,
+        NULL, bytes ? OPEN_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    if (bytes == 0) {
+        LARGE_INTEGER existing;
+        if (!GetFileSizeEx(file, &existing) || existing.QuadPart == 0) {
+            Close();
+            return false;
+        }
+        bytes = (size_t)existing.QuadPart;
+    }
+
+    // Mapping a larger size than the file extends it with zeros.
+    unsigned long long total = bytes;
+    mapping = CreateFileMappingA(file, NULL, PAGE_READWRITE, (DWORD)(total >> 32), (DWORD)total, NULL);
+    if (!mapping) {
+        Close();
+        return false;
+    }
+
+    data = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, bytes);
+    if (!data) {
+        Close();
+        return false;
+    }
+    size = bytes;
+    return true;
+}
+
+bool SharedRegion::Sync() {
+    if (!data || file == INVALID_HANDLE_VALUE) return false;
+    return FlushViewOfFile(data, size) && FlushFileBuffers(file);
+}
+
+void SharedRegion::Close() {
+    if (data) UnmapViewOfFile(data);
+    if (mapping) CloseHandle(mapping);
+    if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+    data = nullptr;
+    mapping = nullptr;
+    file = INVALID_HANDLE_VALUE;
+    size = 0;
+}
+
+void SharedRegion::Remove(const std::string&) {
+    // The mapping goes away with its last handle.
+}
+
+#else
+
+bool SharedRegion::Create(const std::string& name, size_t bytes) {
+    Close();
+    std::string object = "/" + name;
+    shm_unlink(object.c_str());
+
+    int fd = shm_open(object.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) return false;
+    if (ftruncate(fd, (off_t)bytes) != 0) {
+        close(fd);
+        shm_unlink(object.c_str());
+        return false;
+    }
+
+    // ftruncate already gives zero-filled pages.
+    void* mapped = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        shm_unlink(object.c_str());
+        return false;
+    }
+
+    data = mapped;
+    size = bytes;
+    return true;
+}
+
+bool SharedRegion::Open(const std::string& name, bool readOnly) {
+    Close();
+    std::string object = "/" + name;
+    int fd = shm_open(object.c_str(), readOnly ? O_RDONLY : O_RDWR, 0);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return false;
+    }
+
+    int protection = readOnly ? PROT_READ : PROT_READ | PROT_WRITE;
+    void* mapped = mmap(nullptr, (size_t)st.st_size, protection, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) return false;
+
+    data = mapped;
+    size = (size_t)st.st_size;
+    return true;
+}
+
+bool SharedRegion::MapFile(const std::string& path, size_t bytes) {
+    Close();
+    int file = open(path.c_str(), bytes ? O_CREAT | O_RDWR : O_RDWR, 0600);
+    if (file < 0) return false;
+
+    struct stat st;
+    if (fstat(file, &st) != 0 || (bytes == 0 && st.st_size == 0)) {
+        close(file);
+        return false;
+    }
+    if (bytes == 0) bytes = (size_t)st.st_size;
+    if ((size_t)st.st_size != bytes && ftruncate(file, (off_t)bytes) != 0) {
+        close(file);
+        return false;
+    }
+
+    void* mapped = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+    if (mapped == MAP_FAILED) {
+        close(file);
+        return false;
+    }
+
+    // Kept open for Sync; stores through the mapping dirty the file's own
+    // page cache pages, so fdatasync on any descriptor of it writes them.
+    fd = file;
+    data = mapped;
+    size = bytes;
+    return true;
+}
+
+bool SharedRegion::Sync() {
+    if (!data || fd < 0) return false;
+    return fdatasync(fd) == 0;
+}
+
+void SharedRegion::Close() {
+    if (data) munmap(data, size);
+    if (fd >= 0) close(fd);
+    data = nullptr;
+    fd = -1;
+    size = 0;
+}
+
+void SharedRegion::Remove(const std::string& name) {
+    shm_unlink(("/" + name).c_str());
+}
+
+#endif
@@ -0,0 +1,388 @@
+#include "shm_queue.h"
+#include "queue_futex.h"
+#include <algorithm>
+#include <chrono>
+
+namespace {
+
+const uint32_t kShmQueueMagic = 0x51554531;  // "QUE1"
+const size_t kControlBytes = 64;
+const int kLeaderCheckMs = 100;  // how often a sync waiter checks its leader is alive
+
+const size_t kHeaderOffset = kControlBytes + sizeof(QueueStatsPage);
+
+static_assert(sizeof(ShmQueueControl) <= kControlBytes, "control block must fit its cache line");
+
+size_t RegionBytes(int capacity) {
+    return kHeaderOffset + sizeof(QueueHeader) + (size_t)capacity * sizeof(Message);
+}
+
+} // namespace
+
+ShmQueue::ShmQueue()
+    : control(nullptr), stats(nullptr), header(nullptr), messages(nullptr), senderStats(nullptr), stopFlusher(false) {}
+
+ShmQueue::~ShmQueue() {
+    Close();
+}
+
+void ShmQueue::Attach() {
+    char* base = static_cast<char*>(region.Data());
+    control = reinterpret_cast<ShmQueueControl*>(base);
+    stats = reinterpret_cast<QueueStatsPage*>(base + kControlBytes);
+    header = reinterpret_cast<QueueHeader*>(base + kHeaderOffset);
+    messages = reinterpret_cast<Message*>(base + kHeaderOffset + sizeof(QueueHeader));
+}
+
+bool ShmQueue::Create(const std::string& name, int capacity) {
+    Close();
+    if (capacity <= 0 || !region.Create(name, RegionBytes(capacity))) return false;
+    Attach();
+
+    // The mapping arrives zero-filled, which is already an empty Message ring
+    // and a zero header; only the capacity has to be set before publishing.
+    header->capacity = capacity;
+    std::atomic_thread_fence(std::memory_order_release);
+    control->magic = kShmQueueMagic;
+    return true;
+}
+
+bool ShmQueue::Open(const std::string& name, bool readOnly) {
+    Close();
+    if (!region.Open(name, readOnly) || region.Size() < kHeaderOffset + sizeof(QueueHeader)) {
+        Close();
+        return false;
+    }
+    Attach();
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (control->magic != kShmQueueMagic || header->capacity <= 0
+        || region.Size() < RegionBytes(header->capacity)) {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+bool ShmQueue::CreateDurable(const std::string& path, int capacity, QueueDurability durability,
+    int flushIntervalMs) {
+    Close();
+    if (capacity <= 0 || !region.MapFile(path, RegionBytes(capacity))) return false;
+    Attach();
+
+    bool recovered = control->magic == kShmQueueMagic && header->capacity == capacity
+        && header->count >= 0 && header->count <= capacity;
+    if (recovered) {
+        // Whoever held the lock or slept here died with the last run, and
+        // what is in the file now is what the disk had.
+        control->lock = 0;
+        control->dataWaiters = 0;
+        control->spaceWaiters = 0;
+        control->flushLeader = 0;
+        control->durableWaiters = 0;
+        control->durable = control->written.load();
+    }
+    else {
+        control->magic = 0;
+        memset(region.Data(), 0, region.Size());
+        header->capacity = capacity;
+    }
+    control->durability = (uint32_t)durability;
+    std::atomic_thread_fence(std::memory_order_release);
+    control->magic = kShmQueueMagic;
+
+    if (durability != DURABILITY_MEMORY && !region.Sync()) {
+        Close();
+        return false;
+    }
+    if (durability == DURABILITY_ASYNC) {
+        stopFlusher = false;
+        flusher = std::thread(&ShmQueue::RunFlusher, this, std::max(flushIntervalMs, 1));
+    }
+    return true;
+}
+
+bool ShmQueue::OpenDurable(const std::string& path) {
+    Close();
+    if (!region.MapFile(path, 0) || region.Size() < kHeaderOffset + sizeof(QueueHeader)) {
+        Close();
+        return false;
+    }
+    Attach();
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (control->magic != kShmQueueMagic || header->capacity <= 0
+        || region.Size() < RegionBytes(header->capacity)) {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void ShmQueue::Close() {
+    if (flusher.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(flusherMutex);
+            stopFlusher = true;
+        }
+        flusherWake.notify_all();
+        flusher.join();
+    }
+    if (stats) ReleaseSenderStats(*stats, senderStats.exchange(nullptr));
+    region.Close();
+    control = nullptr;
+    stats = nullptr;
+    header = nullptr;
+    messages = nullptr;
+}
+
+int ShmQueue::Capacity() const {
+    return header ? header->capacity : 0;
+}
+
+QueueDurability ShmQueue::Durability() const {
+    return control ? (QueueDurability)control->durability : DURABILITY_MEMORY;
+}
+
+// Called holding flushLeader. The target is read before the sync, so every
+// message counted in it had been copied in and is covered.
+bool ShmQueue::SyncAsLeader() {
+    uint64_t target = control->written.load(std::memory_order_acquire);
+    bool synced = region.Sync();
+    if (synced) {
+        control->durable.store(target, std::memory_order_release);
+        control->flushes.fetch_add(1, std::memory_order_relaxed);
+    }
+    control->flushLeader.store(0, std::memory_order_release);
+    QueueNotify(control->durableSignal, control->durableWaiters);
+    return synced;
+}
+
+// Takes flushLeader when no sync is running, or from a leader that died
+// before it finished; a live leader's sync is left to complete.
+bool ShmQueue::TakeFlushLeader() {
+    uint32_t self = (uint32_t)CurrentProcessId();
+    uint32_t leader = 0;
+    if (control->flushLeader.compare_exchange_strong(leader, self, std::memory_order_acquire)) return true;
+    return !ProcessAlive((int32_t)leader)
+        && control->flushLeader.compare_exchange_strong(leader, self, std::memory_order_acquire);
+}
+
+// Group commit: the first waiter to find no sync running leads one; the rest
+// sleep until it finishes and either are covered or lead the next one. The
+// sleep is bounded so a leader that died mid-sync is noticed.
+bool ShmQueue::WaitDurable(uint64_t written) {
+    for (;;) {
+        if (control->durable.load(std::memory_order_acquire) >= written) return true;
+
+        if (TakeFlushLeader()) {
+            if (!SyncAsLeader()) return false;
+            continue;
+        }
+
+        int64_t recheck = QueueDeadline(kLeaderCheckMs);
+        QueueSleepUnless(control->durableSignal, control->durableWaiters, recheck, [this, written]() {
+            return control->durable.load(std::memory_order_acquire) >= written
+                || control->flushLeader.load(std::memory_order_acquire) == 0;
+        });
+    }
+}
+
+bool ShmQueue::Flush() {
+    if (!control) return false;
+    return WaitDurable(control->written.load(std::memory_order_acquire));
+}
+
+// Async mode: wakes every interval and syncs if anything is new, and once
+// more on Close so a clean shutdown leaves nothing behind.
+void ShmQueue::RunFlusher(int intervalMs) {
+    std::unique_lock<std::mutex> lock(flusherMutex);
+    bool stopping = false;
+    while (!stopping) {
+        stopping = flusherWake.wait_for(lock, std::chrono::milliseconds(intervalMs), [this]() { return stopFlusher; });
+        if (control->durable.load(std::memory_order_acquire) < control->written.load(std::memory_order_acquire)) {
+            Flush();
+        }
+    }
+}
+
+int ShmQueue::Count() const {
+    if (!header) return 0;
+    QueueLock(&control->lock);
+    int count = header->count;
+    QueueUnlock(&control->lock);
+    return count;
+}
+
+bool ShmQueue::Send(const std::string& text, int timeoutMs, int* msgId) {
+    if (!header) return false;
+    int64_t deadline = QueueDeadline(timeoutMs);
+    QueueSenderStats& sender = HeldSenderStats(*stats, senderStats);
+    int64_t waitStart = 0;
+
+    for (;;) {
+        QueueLock(&control->lock);
+
+        if (header->count < header->capacity) {
+            Message& msg = messages[header->writeIndex];
+            size_t length = std::min(text.size(), (size_t)MAX_MESSAGE_LEN);
+            memcpy(msg.data, text.data(), length);
+            msg.data[length] = '\0';
+            msg.isValid = TRUE;
+
+            header->writeIndex = (header->writeIndex + 1) % header->capacity;
+            header->count++;
+            header->nextMsgId++;
+            if (msgId) *msgId = header->nextMsgId;
+            uint64_t written = control->written.fetch_add(1, std::memory_order_release) + 1;
+            int depth = header->count;
+
+            QueueUnlock(&control->lock);
+            if (waitStart) QueueStatsFullWait(sender, waitStart);
+            QueueStatsSent(*stats, sender, 1, (uint64_t)depth);
+            QueueNotify(control->dataSignal, control->dataWaiters);
+            return Durability() != DURABILITY_GROUP || WaitDurable(written);
+        }
+
+        QueueUnlock(&control->lock);
+        if (timeoutMs != 0 && !waitStart) waitStart = QueueClockNs();
+        bool waited = QueueSleepUnless(control->spaceSignal, control->spaceWaiters, deadline,
+            [this]() { return Count() < header->capacity; });
+        if (!waited) {
+            if (waitStart) QueueStatsFullWait(sender, waitStart);
+            return false;
+        }
+    }
+}
+
+size_t ShmQueue::SendBatch(const std::vector<std::string>& texts, int timeoutMs, int* firstMsgId) {
+    if (!header) return 0;
+    int64_t deadline = QueueDeadline(timeoutMs);
+    QueueSenderStats& sender = HeldSenderStats(*stats, senderStats);
+    size_t sent = 0;
+    uint64_t written = 0;
+    int64_t waitStart = 0;
+
+    while (sent < texts.size()) {
+        QueueLock(&control->lock);
+
+        size_t room = (size_t)(header->capacity - header->count);
+        size_t batch = std::min(room, texts.size() - sent);
+        if (batch > 0) {
+            if (sent == 0 && firstMsgId) *firstMsgId = header->nextMsgId + 1;
+
+            for (size_t i = 0; i < batch; i++) {
+                const std::string& text = texts[sent + i];
+                Message& msg = messages[header->writeIndex];
+                size_t length = std::min(text.size(), (size_t)MAX_MESSAGE_LEN);
+                memcpy(msg.data, text.data(), length);
+                msg.data[length] = '\0';
+                msg.isValid = TRUE;
+                header->writeIndex = (header->writeIndex + 1) % header->capacity;
+            }
+            header->count += (int)batch;
+            header->nextMsgId += (int)batch;
+            written = control->written.fetch_add(batch, std::memory_order_release) + batch;
+            sent += batch;
+            int depth = header->count;
+
+            QueueUnlock(&control->lock);
+            if (waitStart) {
+                QueueStatsFullWait(sender, waitStart);
+                waitStart = 0;
+            }
+            QueueStatsSent(*stats, sender, batch, (uint64_t)depth);
+            QueueNotify(control->dataSignal, control->dataWaiters);
+            continue;
+        }
+
+        QueueUnlock(&control->lock);
+        if (timeoutMs != 0 && !waitStart) waitStart = QueueClockNs();
+        bool waited = QueueSleepUnless(control->spaceSignal, control->spaceWaiters, deadline,
+            [this]() { return Count() < header->capacity; });
+        if (!waited) {
+            if (waitStart) QueueStatsFullWait(sender, waitStart);
+            break;
+        }
+    }
+
+    // One wait for the whole batch; a failed sync leaves nothing acknowledged.
+    if (sent > 0 && Durability() == DURABILITY_GROUP && !WaitDurable(written)) return 0;
+    return sent;
+}
+
+size_t ShmQueue::ReadBatch(std::vector<ReceivedMessage>& out, size_t maxMessages, int timeoutMs) {
+    out.clear();
+    if (!header || maxMessages == 0) return 0;
+    int64_t deadline = QueueDeadline(timeoutMs);
+    int64_t waitStart = 0;
+
+    for (;;) {
+        QueueLock(&control->lock);
+
+        if (header->count > 0) {
+            size_t batch = std::min((size_t)header->count, maxMessages);
+            int firstId = header->nextMsgId - header->count + 1;
+            out.resize(batch);
+
+            for (size_t i = 0; i < batch; i++) {
+                Message& msg = messages[header->readIndex];
+                out[i].msgId = firstId + (int)i;
+                out[i].text = msg.data;
+                msg.isValid = FALSE;
+                header->readIndex = (header->readIndex + 1) % header->capacity;
+            }
+            header->count -= (int)batch;
+
+            QueueUnlock(&control->lock);
+            if (waitStart) QueueStatsEmptyWait(*stats, waitStart);
+            QueueStatsReceived(*stats, batch);
+            QueueNotify(control->spaceSignal, control->spaceWaiters);
+            return batch;
+        }
+
+        QueueUnlock(&control->lock);
+        if (timeoutMs != 0 && !waitStart) waitStart = QueueClockNs();
+        bool waited = QueueSleepUnless(control->dataSignal, control->dataWaiters, deadline,
+            [this]() { return Count() > 0; });
+        if (!waited) {
+            if (waitStart) QueueStatsEmptyWait(*stats, waitStart);
+            return 0;
+        }
+    }
+}
+
+bool ShmQueue::Read(std::string& message, int& msgId, int timeoutMs) {
+    if (!header) return false;
+    int64_t deadline = QueueDeadline(timeoutMs);
+    int64_t waitStart = 0;
+
+    for (;;) {
+        QueueLock(&control->lock);
+
+        if (header->count > 0) {
+            Message& msg = messages[header->readIndex];
+            message = msg.data;
+            msg.isValid = FALSE;
+
+            msgId = header->nextMsgId - header->count + 1;
+            header->readIndex = (header->readIndex + 1) % header->capacity;
+            header->count--;
+
+            QueueUnlock(&control->lock);
+            if (waitStart) QueueStatsEmptyWait(*stats, waitStart);
+            QueueStatsReceived(*stats, 1);
+            QueueNotify(control->spaceSignal, control->spaceWaiters);
+            return true;
+        }
+
+        QueueUnlock(&control->lock);
+        if (timeoutMs != 0 && !waitStart) waitStart = QueueClockNs();
+        bool waited = QueueSleepUnless(control->dataSignal, control->dataWaiters, deadline,
+            [this]() { return Count() > 0; });
+        if (!waited) {
+            if (waitStart) QueueStatsEmptyWait(*stats, waitStart);
+            return false;
+        }
+    }
+}
@@ -1,7 +1,13 @@
 #ifndef COMMON_H
 #define COMMON_H
 
+#ifdef _WIN32
 #include <windows.h>
+#else
+typedef int BOOL;
+#define TRUE 1
+#define FALSE 0
+#endif
 #include <string>
 #include <cstring>
 
@@ -17,6 +23,14 @@ struct Message {
     }
 };
 
+// One message as returned by the batch reads.
+struct ReceivedMessage {
+    int msgId;
+    std::string text;
+    int partition = 0;  // which sub-queue of a PartitionedQueue it came from
+    int priority = 0;   // which level of a PriorityQueue it came from
+};
+
 #pragma pack(push, 1)
 struct QueueHeader {
     int readIndex;
@@ -29,9 +43,9 @@ struct QueueHeader {
 };
 #pragma pack(pop)
 
-const char* READY_EVENT_PREFIX = "Global\\ReadyEvent_";
-const char* MUTEX_NAME = "Global\\QueueMutex";
-const char* DATA_AVAILABLE_EVENT = "Global\\DataAvailable";
-const char* SPACE_AVAILABLE_EVENT = "Global\\SpaceAvailable";
+const char* const READY_EVENT_PREFIX = "Global\\ReadyEvent_";
+const char* const MUTEX_NAME = "Global\\QueueMutex";
+const char* const DATA_AVAILABLE_EVENT = "Global\\DataAvailable";
+const char* const SPACE_AVAILABLE_EVENT = "Global\\SpaceAvailable";
 
 #endif
\ No newline at end of file
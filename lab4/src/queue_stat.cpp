@@ -0,0 +1,205 @@
+#include "byte_ring.h"
+#include "mpsc_ring.h"
+#include "partitioned_queue.h"
+#include "priority_queue.h"
+#include "queue_backend.h"
+#include "queue_futex.h"
+#include "queue_stats.h"
+#include "shm_queue.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+
+using namespace std;
+
+// vmstat for a queue: attaches read-only to a running shm, ring, varlen,
+// partitioned or priority queue and prints one line of rates per interval
+// from its stats pages. The queue is only read, so watching it costs the
+// senders and the receiver nothing beyond the counters they keep anyway. A
+// durable shm queue is watched through its file, mapped like its users map it.
+// Usage: queue_stat <queue file> [--backend shm|ring|varlen|partitioned|priority]
+//        [--interval MS] [--count N] [--senders]
+
+struct StatSample {
+    QueueStatsTotals totals;
+    int depth = 0;
+    map<int32_t, QueueStatsTotals> senders;  // by pid, summed over partitions or levels
+    int64_t takenNs = 0;
+};
+
+class QueueStat {
+private:
+    QueueBackend backend;
+    ShmQueue shm;
+    MpscRing ring;
+    ByteRing varlen;
+    PartitionedQueue partitioned;
+    PriorityQueue priority;
+
+    static void AddPage(StatSample& sample, const QueueStatsPage& page) {
+        QueueStatsTotals totals = SumQueueStats(page);
+        sample.totals.enqueued += totals.enqueued;
+        sample.totals.dequeued += totals.dequeued;
+        sample.totals.fullWaits += totals.fullWaits;
+        sample.totals.waitNs += totals.waitNs;
+        sample.totals.highWater = max(sample.totals.highWater, totals.highWater);
+        sample.totals.emptyWaits += totals.emptyWaits;
+        sample.totals.emptyWaitNs += totals.emptyWaitNs;
+
+        for (const auto& slot : page.senders) {
+            int32_t pid = slot.pid.load(memory_order_relaxed);
+            if (pid == 0) continue;
+            QueueStatsTotals& sender = sample.senders[pid];
+            sender.enqueued += slot.enqueued.load(memory_order_relaxed);
+            sender.fullWaits += slot.fullWaits.load(memory_order_relaxed);
+            sender.waitNs += slot.waitNs.load(memory_order_relaxed);
+            sender.highWater = max(sender.highWater, (uint64_t)slot.highWater.load(memory_order_relaxed));
+        }
+    }
+
+    static double PerSecond(uint64_t now, uint64_t before, double seconds) {
+        return now >= before ? (now - before) / seconds : 0;
+    }
+
+public:
+    QueueStat() : backend(BACKEND_RING) {}
+
+    bool Attach(const string& filename, QueueBackend queueBackend) {
+        backend = queueBackend;
+        string region = SharedRegionName(filename);
+        if (backend == BACKEND_PARTITIONED) return partitioned.Open(region, true);
+        if (backend == BACKEND_PRIORITY) return priority.Open(region, true);
+        if (backend == BACKEND_RING) return ring.Open(region, true);
+        if (backend == BACKEND_VARLEN) return varlen.Open(region, true);
+        if (backend == BACKEND_SHM) return shm.Open(region, true) || shm.OpenDurable(filename);
+        return false;
+    }
+
+    StatSample Sample() {
+        StatSample sample;
+        if (backend == BACKEND_PARTITIONED) {
+            for (int p = 0; p < partitioned.Partitions(); p++) {
+                AddPage(sample, *partitioned.PartitionStats(p));
+                sample.depth += partitioned.PartitionCount(p);
+            }
+        }
+        else if (backend == BACKEND_PRIORITY) {
+            for (int p = 0; p < priority.Levels(); p++) {
+                AddPage(sample, *priority.LevelStats(p));
+                sample.depth += priority.LevelCount(p);
+            }
+        }
+        else if (backend == BACKEND_RING) {
+            AddPage(sample, *ring.Stats());
+            sample.depth = ring.Count();
+        }
+        else {
+            // Counting under the queue's lock would need write access; the
+            // totals give the depth as of the last completed send and read.
+            AddPage(sample, backend == BACKEND_SHM ? *shm.Stats() : *varlen.Stats());
+            const QueueStatsTotals& t = sample.totals;
+            sample.depth = t.enqueued > t.dequeued ? (int)(t.enqueued - t.dequeued) : 0;
+        }
+        sample.totals.senders = (int)sample.senders.size();
+        sample.takenNs = QueueClockNs();
+        return sample;
+    }
+
+    static void PrintTotals(const StatSample& sample) {
+        const QueueStatsTotals& t = sample.totals;
+        cout << "since creation: enqueued " << t.enqueued << ", dequeued " << t.dequeued
+            << ", full waits " << t.fullWaits << " (" << t.waitNs / 1000000 << " ms)"
+            << ", empty waits " << t.emptyWaits << " (" << t.emptyWaitNs / 1000000 << " ms)"
+            << ", high water " << t.highWater << endl;
+    }
+
+    static void PrintHeader() {
+        printf("%8s %8s %10s %10s %8s %10s %8s %7s\n",
+            "depth", "hwm", "enq/s", "deq/s", "fullw/s", "wait_ms/s", "emptyw/s", "senders");
+    }
+
+    // Rates between two samples; senders that appeared in between are
+    // counted from zero, as their slots start at zero.
+    static void PrintRates(const StatSample& before, const StatSample& now, bool perSender) {
+        double seconds = max(1e-9, (now.takenNs - before.takenNs) / 1e9);
+        const QueueStatsTotals& a = before.totals;
+        const QueueStatsTotals& b = now.totals;
+        printf("%8d %8llu %10.0f %10.0f %8.0f %10.1f %8.0f %7d\n",
+            now.depth, (unsigned long long)b.highWater,
+            PerSecond(b.enqueued, a.enqueued, seconds), PerSecond(b.dequeued, a.dequeued, seconds),
+            PerSecond(b.fullWaits, a.fullWaits, seconds), PerSecond(b.waitNs, a.waitNs, seconds) / 1e6,
+            PerSecond(b.emptyWaits, a.emptyWaits, seconds), b.senders);
+
+        if (!perSender) return;
+        for (const auto& entry : now.senders) {
+            auto previous = before.senders.find(entry.first);
+            QueueStatsTotals zero;
+            const QueueStatsTotals& s = previous == before.senders.end() ? zero : previous->second;
+            const QueueStatsTotals& n = entry.second;
+            printf("%8s %8llu %10.0f %10s %8.0f %10.1f\n", ("pid " + to_string(entry.first)).c_str(),
+                (unsigned long long)n.highWater, PerSecond(n.enqueued, s.enqueued, seconds), "",
+                PerSecond(n.fullWaits, s.fullWaits, seconds), PerSecond(n.waitNs, s.waitNs, seconds) / 1e6);
+        }
+    }
+};
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        cerr << "Usage: queue_stat <queue file> [--backend shm|ring|varlen|partitioned|priority] [--interval MS]"
+            << " [--count N] [--senders]" << endl;
+        return 1;
+    }
+
+    string filename = argv[1];
+    QueueBackend backend = BACKEND_RING;
+    int intervalMs = 1000;
+    int count = 0;  // 0: until interrupted
+    bool perSender = false;
+    for (int i = 2; i < argc; i++) {
+        string option = argv[i];
+        if (option == "--senders") perSender = true;
+        else if (i + 1 < argc && option == "--backend") {
+            if (!ParseQueueBackend(argv[++i], backend)) {
+                cerr << "Unknown backend: " << argv[i] << endl;
+                return 1;
+            }
+        }
+        else if (i + 1 < argc && option == "--interval") intervalMs = atoi(argv[++i]);
+        else if (i + 1 < argc && option == "--count") count = atoi(argv[++i]);
+        else {
+            cerr << "Unknown option: " << option << endl;
+            return 1;
+        }
+    }
+    if (backend == BACKEND_FILE) {
+        cerr << "The file backend keeps no stats" << endl;
+        return 1;
+    }
+    if (intervalMs <= 0) {
+        cerr << "--interval must be positive" << endl;
+        return 1;
+    }
+
+    QueueStat stat;
+    if (!stat.Attach(filename, backend)) {
+        cerr << "No " << QueueBackendName(backend) << " queue for " << filename << endl;
+        return 1;
+    }
+
+    StatSample previous = stat.Sample();
+    QueueStat::PrintTotals(previous);
+    for (int row = 0; count == 0 || row < count; row++) {
+        if (row % 20 == 0) QueueStat::PrintHeader();
+        this_thread::sleep_for(chrono::milliseconds(intervalMs));
+        StatSample sample = stat.Sample();
+        QueueStat::PrintRates(previous, sample, perSender);
+        fflush(stdout);
+        previous = sample;
+    }
+    return 0;
+}
@@ -1,4 +1,10 @@
 #include "common.h"
+#include "byte_ring.h"
+#include "mpsc_ring.h"
+#include "partitioned_queue.h"
+#include "priority_queue.h"
+#include "queue_backend.h"
+#include "shm_queue.h"
 #include <iostream>
 #include <fstream>
 #include <vector>
@@ -17,6 +23,14 @@ private:
     HANDLE hSpaceAvailable;
     vector<HANDLE> readyEvents;
     vector<PROCESS_INFORMATION> senderProcesses;
+    QueueBackend backend;
+    QueueDurability durability;
+    ShmQueue shmQueue;
+    MpscRing ring;
+    ByteRing varlenRing;
+    PartitionedQueue partitioned;
+    PriorityQueue priorityQueue;
+    string joinFilename;  // set for an extra receiver joining a running partitioned queue
 
     bool CreateQueueFile() {
         ofstream file(filename, ios::binary | ios::trunc);
@@ -80,6 +94,55 @@ private:
         return true;
     }
 
+    // Everything currently queued, under one mutex hold and one header rewrite.
+    size_t ReadBatchFromFile(vector<ReceivedMessage>& out) {
+        out.clear();
+        WaitForSingleObject(hMutex, INFINITE);
+
+        fstream file(filename, ios::binary | ios::in | ios::out);
+        if (!file) {
+            ReleaseMutex(hMutex);
+            return 0;
+        }
+
+        QueueHeader header;
+        file.read(reinterpret_cast<char*>(&header), sizeof(QueueHeader));
+
+        int firstId = header.nextMsgId - header.count + 1;
+        for (int i = 0; i < header.count; i++) {
+            streampos msgPos = sizeof(QueueHeader) + header.readIndex * sizeof(Message);
+            Message msg;
+            file.seekg(msgPos);
+            file.read(reinterpret_cast<char*>(&msg), sizeof(Message));
+
+            msg.isValid = FALSE;
+            file.seekp(msgPos);
+            file.write(reinterpret_cast<char*>(&msg), sizeof(Message));
+
+            out.push_back({ firstId + i, msg.data });
+            header.readIndex = (header.readIndex + 1) % header.capacity;
+        }
+        header.count = 0;
+
+        file.seekp(0);
+        file.write(reinterpret_cast<char*>(&header), sizeof(QueueHeader));
+        file.close();
+
+        ReleaseMutex(hMutex);
+
+        if (!out.empty()) SetEvent(hSpaceAvailable);
+        return out.size();
+    }
+
+    size_t DrainAll(vector<ReceivedMessage>& out) {
+        if (backend == BACKEND_PRIORITY) return priorityQueue.ReadBatch(out, SIZE_MAX, 0);
+        if (backend == BACKEND_PARTITIONED) return partitioned.ReadBatch(out, SIZE_MAX, 0);
+        if (backend == BACKEND_VARLEN) return varlenRing.ReadBatch(out, SIZE_MAX, 0);
+        if (backend == BACKEND_RING) return ring.ReadBatch(out, SIZE_MAX, 0);
+        if (backend == BACKEND_SHM) return shmQueue.ReadBatch(out, SIZE_MAX, 0);
+        return ReadBatchFromFile(out);
+    }
+
     bool WaitForAllSenders() {
         cout << "Waiting for all senders to be ready..." << endl;
         DWORD result = WaitForMultipleObjects(readyEvents.size(),
@@ -90,7 +153,9 @@ private:
     }
 
 public:
-    Receiver() : hMutex(NULL), hDataAvailable(NULL), hSpaceAvailable(NULL) {}
+    Receiver(QueueBackend backend, QueueDurability durability, const string& joinFilename) : hMutex(NULL),
+        hDataAvailable(NULL), hSpaceAvailable(NULL), backend(backend), durability(durability),
+        joinFilename(joinFilename) {}
 
     ~Receiver() {
         if (hMutex) CloseHandle(hMutex);
@@ -101,9 +166,24 @@ public:
             CloseHandle(pi.hProcess);
             CloseHandle(pi.hThread);
         }
+        // A durable queue keeps its file for the next run, and a joined
+        // partitioned queue belongs to the receiver that created it.
+        partitioned.Close();
+        if (backend != BACKEND_FILE && durability == DURABILITY_MEMORY && joinFilename.empty()) {
+            SharedRegion::Remove(SharedRegionName(filename));
+        }
     }
 
     bool Initialize() {
+        if (!joinFilename.empty()) {
+            filename = joinFilename;
+            if (!partitioned.Open(SharedRegionName(filename)) || !partitioned.Join()) {
+                cerr << "Failed to join partitioned queue!" << endl;
+                return false;
+            }
+            return true;
+        }
+
         cout << "Enter binary filename: ";
         cin >> filename;
 
@@ -115,6 +195,49 @@ public:
             return false;
         }
 
+        // The queue lives in shared memory instead of the file; senders map it once.
+        if (backend != BACKEND_FILE) {
+            string region = SharedRegionName(filename);
+            bool created;
+            if (backend == BACKEND_VARLEN) {
+                // capacity messages of the longest length; shorter ones pack tighter.
+                size_t maxMessage;
+                cout << "Enter max message length (8.." << kDefaultMaxMessage << " bytes): ";
+                cin >> maxMessage;
+                if (maxMessage < 8 || maxMessage > kDefaultMaxMessage) {
+                    cerr << "Invalid message length!" << endl;
+                    return false;
+                }
+                created = varlenRing.Create(region, capacity * ByteRing::RecordBytes(maxMessage), maxMessage);
+            }
+            else if (backend == BACKEND_PARTITIONED) {
+                // capacity records per partition; further receivers join with --join.
+                int partitions;
+                cout << "Enter number of partitions (1.." << kMaxPartitions << "): ";
+                cin >> partitions;
+                created = partitioned.Create(region, partitions, capacity) && partitioned.Join();
+            }
+            else if (backend == BACKEND_PRIORITY) {
+                // capacity is the budget all levels share.
+                int levels, reserve, weight;
+                cout << "Enter number of priority levels (1.." << kMaxPriorities << "): ";
+                cin >> levels;
+                cout << "Enter budget each level keeps from the ones below it (0 for none): ";
+                cin >> reserve;
+                cout << "Enter anti-starvation weight (0 for strict priority): ";
+                cin >> weight;
+                created = priorityQueue.Create(region, levels, capacity, reserve, weight);
+            }
+            else if (backend == BACKEND_RING) created = ring.Create(region, capacity);
+            else if (durability != DURABILITY_MEMORY) created = shmQueue.CreateDurable(filename, capacity, durability);
+            else created = shmQueue.Create(region, capacity);
+            if (!created) {
+                cerr << "Failed to create shared queue!" << endl;
+                return false;
+            }
+            return true;
+        }
+
         hMutex = CreateMutexA(NULL, FALSE, MUTEX_NAME);
         hDataAvailable = CreateEventA(NULL, FALSE, FALSE, DATA_AVAILABLE_EVENT);
         hSpaceAvailable = CreateEventA(NULL, FALSE, TRUE, SPACE_AVAILABLE_EVENT);
@@ -151,6 +274,8 @@ public:
             readyEvents.push_back(hReadyEvent);
 
             string cmdLine = senderPath + " " + filename + " " + to_string(i) + " " + eventName;
+            if (backend != BACKEND_FILE) cmdLine += string(" ") + QueueBackendName(backend);
+            if (durability != DURABILITY_MEMORY) cmdLine += string(" ") + QueueDurabilityName(durability);
 
             STARTUPINFOA si = { sizeof(si) };
             PROCESS_INFORMATION pi;
@@ -179,7 +304,7 @@ public:
         bool running = true;
 
         cout << "\nReceiver Ready" << endl;
-        cout << "Commands: 'read' - read message, 'quit' - exit" << endl;
+        cout << "Commands: 'read' - read message, 'drain' - read all available, 'quit' - exit" << endl;
 
         while (running) {
             cout << "\n> ";
@@ -188,14 +313,68 @@ public:
             if (command == "read") {
                 cout << "Waiting for message..." << endl;
 
-                WaitForSingleObject(hDataAvailable, INFINITE);
-
                 string message;
                 int msgId;
-                if (ReadMessage(message, msgId)) {
+                int partition = -1;
+                int priority = -1;
+                bool received;
+                if (backend == BACKEND_PRIORITY) {
+                    received = priorityQueue.Read(message, msgId, &priority);
+                }
+                else if (backend == BACKEND_PARTITIONED) {
+                    received = partitioned.Read(message, msgId, &partition);
+                }
+                else if (backend == BACKEND_VARLEN) {
+                    received = varlenRing.Read(message, msgId);
+                }
+                else if (backend == BACKEND_RING) {
+                    // Printed straight from the shared slot, then released.
+                    MessageView view;
+                    if (ring.Acquire(view)) {
+                        cout << "Received [" << view.msgId << "]: ";
+                        cout.write(view.data, view.length) << endl;
+                        ring.Release(view);
+                    }
+                    continue;
+                }
+                else if (backend == BACKEND_SHM) {
+                    received = shmQueue.Read(message, msgId);
+                }
+                else {
+                    WaitForSingleObject(hDataAvailable, INFINITE);
+                    received = ReadMessage(message, msgId);
+                }
+
+                if (received && priority >= 0) {
+                    cout << "Received [prio " << priority << ":" << msgId << "]: " << message << endl;
+                }
+                else if (received && partition >= 0) {
+                    cout << "Received [p" << partition << ":" << msgId << "]: " << message << endl;
+                }
+                else if (received) {
                     cout << "Received [" << msgId << "]: " << message << endl;
                 }
             }
+            else if (command == "drain" && backend == BACKEND_RING) {
+                vector<MessageView> views;
+                ring.AcquireBatch(views, SIZE_MAX, 0);
+                for (const auto& view : views) {
+                    cout << "Received [" << view.msgId << "]: ";
+                    cout.write(view.data, view.length) << endl;
+                    ring.Release(view);
+                }
+                cout << "Drained " << views.size() << " messages" << endl;
+            }
+            else if (command == "drain") {
+                vector<ReceivedMessage> messages;
+                DrainAll(messages);
+                for (const auto& m : messages) {
+                    if (backend == BACKEND_PRIORITY) cout << "Received [prio " << m.priority << ":" << m.msgId << "]: " << m.text << endl;
+                    else if (backend == BACKEND_PARTITIONED) cout << "Received [p" << m.partition << ":" << m.msgId << "]: " << m.text << endl;
+                    else cout << "Received [" << m.msgId << "]: " << m.text << endl;
+                }
+                cout << "Drained " << messages.size() << " messages" << endl;
+            }
             else if (command == "quit") {
                 running = false;
                 cout << "Shutting down..." << endl;
@@ -205,24 +384,45 @@ public:
                 }
             }
             else {
-                cout << "Unknown command. Use 'read' or 'quit'" << endl;
+                cout << "Unknown command. Use 'read', 'drain' or 'quit'" << endl;
             }
         }
     }
 };
 
-int main() {
+int main(int argc, char* argv[]) {
     SetConsoleCP(1251);
     SetConsoleOutputCP(1251);
 
-    Receiver receiver;
+    QueueBackend backend = BACKEND_FILE;
+    QueueDurability durability = DURABILITY_MEMORY;
+    string joinFilename;
+    bool usage = argc % 2 == 0;
+    for (int i = 1; i + 1 < argc && !usage; i += 2) {
+        string option = argv[i];
+        if (option == "--backend") usage = !ParseQueueBackend(argv[i + 1], backend);
+        else if (option == "--durability") usage = !ParseQueueDurability(argv[i + 1], durability);
+        else if (option == "--join") joinFilename = argv[i + 1];
+        else usage = true;
+    }
+    // Durability modes are those of the shm queue kept in the file itself.
+    if (usage || (durability != DURABILITY_MEMORY && backend != BACKEND_SHM)
+        || (!joinFilename.empty() && backend != BACKEND_PARTITIONED)) {
+        cerr << "Usage: receiver.exe [--backend file|shm|ring|varlen|partitioned|priority] [--durability memory|async|group]" << endl;
+        cerr << "       receiver.exe --backend partitioned --join <filename>" << endl;
+        cerr << "       (--durability async|group needs --backend shm)" << endl;
+        return 1;
+    }
+
+    Receiver receiver(backend, durability, joinFilename);
 
     if (!receiver.Initialize()) {
         cerr << "Initialization failed!" << endl;
         return 1;
     }
 
-    if (!receiver.StartSenders(0)) {
+    // A joining receiver shares the senders of the one that created the queue.
+    if (joinFilename.empty() && !receiver.StartSenders(0)) {
         cerr << "Failed to start senders!" << endl;
         return 1;
     }
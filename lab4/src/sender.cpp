@@ -1,7 +1,15 @@
 #include "common.h"
+#include "byte_ring.h"
+#include "mpsc_ring.h"
+#include "partitioned_queue.h"
+#include "priority_queue.h"
+#include "queue_backend.h"
+#include "shm_queue.h"
 #include <iostream>
+#include <algorithm>
 #include <fstream>
 #include <string>
+#include <vector>
 
 using namespace std;
 
@@ -13,8 +21,42 @@ private:
     HANDLE hDataAvailable;
     HANDLE hSpaceAvailable;
     HANDLE hReadyEvent;
+    QueueBackend backend;
+    ShmQueue shmQueue;
+    MpscRing ring;
+    ByteRing varlenRing;
+    PartitionedQueue partitioned;
+    PriorityQueue priorityQueue;
+
+    // The variable-length ring takes anything up to the limit its receiver chose.
+    size_t MaxLength() const {
+        return backend == BACKEND_VARLEN ? varlenRing.MaxMessage() : MAX_MESSAGE_LEN;
+    }
+
+    // Asked only of a priority queue's sender; anything out of range fails the send.
+    int ReadPriority() {
+        if (backend != BACKEND_PRIORITY) return 0;
+        int priority = 0;
+        cout << "Enter priority (0.." << priorityQueue.Levels() - 1 << ", higher is read first): ";
+        cin >> priority;
+        return priority;
+    }
+
+    // key routes a partitioned queue's message; empty = round-robin.
+    // priority is the level of a priority queue's message.
+    bool SendMessage(const string& text, const string& key = "", int priority = 0) {
+        if (backend != BACKEND_FILE) {
+            bool sent;
+            if (backend == BACKEND_PRIORITY) sent = priorityQueue.Send(text, priority);
+            else if (backend == BACKEND_PARTITIONED) sent = key.empty() ? partitioned.Send(text) : partitioned.SendKeyed(key, text);
+            else if (backend == BACKEND_VARLEN) sent = varlenRing.Send(text);
+            else if (backend == BACKEND_RING) sent = ring.Send(text);
+            else sent = shmQueue.Send(text);
+            if (!sent) return false;
+            cout << "Sender " << senderId << " sent: " << text << endl;
+            return true;
+        }
 
-    bool SendMessage(const string& text) {
         WaitForSingleObject(hSpaceAvailable, INFINITE);
         WaitForSingleObject(hMutex, INFINITE);
 
@@ -59,20 +101,107 @@ private:
         return true;
     }
 
+    // One mutex hold and one header rewrite per run of messages that fits.
+    size_t SendBatchToFile(const vector<string>& texts) {
+        size_t sent = 0;
+
+        while (sent < texts.size()) {
+            WaitForSingleObject(hSpaceAvailable, INFINITE);
+            WaitForSingleObject(hMutex, INFINITE);
+
+            fstream file(filename, ios::binary | ios::in | ios::out);
+            if (!file) {
+                ReleaseMutex(hMutex);
+                break;
+            }
+
+            QueueHeader header;
+            file.read(reinterpret_cast<char*>(&header), sizeof(QueueHeader));
+
+            size_t batch = min((size_t)(header.capacity - header.count), texts.size() - sent);
+            for (size_t i = 0; i < batch; i++) {
+                Message msg;
+                strncpy_s(msg.data, MAX_MESSAGE_LEN + 1, texts[sent + i].c_str(), _TRUNCATE);
+                msg.isValid = TRUE;
+
+                file.seekp(sizeof(QueueHeader) + header.writeIndex * sizeof(Message));
+                file.write(reinterpret_cast<char*>(&msg), sizeof(Message));
+                header.writeIndex = (header.writeIndex + 1) % header.capacity;
+            }
+            header.count += (int)batch;
+            header.nextMsgId += (int)batch;
+
+            file.seekp(0);
+            file.write(reinterpret_cast<char*>(&header), sizeof(QueueHeader));
+            file.close();
+
+            bool spaceLeft = header.count < header.capacity;
+            ReleaseMutex(hMutex);
+
+            if (batch > 0) SetEvent(hDataAvailable);
+            if (spaceLeft) SetEvent(hSpaceAvailable);
+            sent += batch;
+        }
+        return sent;
+    }
+
+    size_t SendBatch(const vector<string>& texts, int priority = 0) {
+        size_t sent = 0;
+        if (backend == BACKEND_PRIORITY) sent = priorityQueue.SendBatch(texts, priority);
+        else if (backend == BACKEND_VARLEN) {
+            while (sent < texts.size() && varlenRing.Send(texts[sent])) sent++;
+        }
+        else if (backend == BACKEND_PARTITIONED) {
+            while (sent < texts.size() && partitioned.Send(texts[sent])) sent++;
+        }
+        else if (backend == BACKEND_RING) sent = ring.SendBatch(texts);
+        else if (backend == BACKEND_SHM) sent = shmQueue.SendBatch(texts);
+        else sent = SendBatchToFile(texts);
+
+        cout << "Sender " << senderId << " sent batch of " << sent << " messages" << endl;
+        return sent;
+    }
+
 public:
     Sender() : hMutex(NULL), hDataAvailable(NULL),
-        hSpaceAvailable(NULL), hReadyEvent(NULL) {
+        hSpaceAvailable(NULL), hReadyEvent(NULL), backend(BACKEND_FILE) {
     }
 
     bool Initialize(int argc, char* argv[]) {
-        if (argc != 4) {
-            cerr << "Usage: sender.exe <filename> <senderId> <readyEventName>" << endl;
+        if (argc < 4 || argc > 6) {
+            cerr << "Usage: sender.exe <filename> <senderId> <readyEventName> [file|shm|ring|varlen|partitioned|priority [memory|async|group]]" << endl;
             return false;
         }
 
         filename = argv[1];
         senderId = atoi(argv[2]);
         string readyEventName = argv[3];
+        if (argc >= 5 && !ParseQueueBackend(argv[4], backend)) {
+            cerr << "Unknown backend: " << argv[4] << endl;
+            return false;
+        }
+        QueueDurability durability = DURABILITY_MEMORY;
+        if (argc == 6 && !ParseQueueDurability(argv[5], durability)) {
+            cerr << "Unknown durability: " << argv[5] << endl;
+            return false;
+        }
+
+        if (backend != BACKEND_FILE) {
+            string region = SharedRegionName(filename);
+            bool opened;
+            if (backend == BACKEND_PRIORITY) opened = priorityQueue.Open(region);
+            else if (backend == BACKEND_PARTITIONED) opened = partitioned.Open(region);
+            else if (backend == BACKEND_VARLEN) opened = varlenRing.Open(region);
+            else if (backend == BACKEND_RING) opened = ring.Open(region);
+            else if (durability != DURABILITY_MEMORY) opened = shmQueue.OpenDurable(filename);
+            else opened = shmQueue.Open(region);
+            hReadyEvent = OpenEventA(EVENT_MODIFY_STATE, FALSE, readyEventName.c_str());
+            if (!opened || !hReadyEvent) {
+                cerr << "Failed to open shared queue! Error: " << GetLastError() << endl;
+                return false;
+            }
+            return true;
+        }
 
         hMutex = OpenMutexA(SYNCHRONIZE, FALSE, MUTEX_NAME);
         hDataAvailable = OpenEventA(SYNCHRONIZE | EVENT_MODIFY_STATE, FALSE, DATA_AVAILABLE_EVENT);
@@ -97,7 +226,7 @@ public:
         string command;
         bool running = true;
 
-        cout << "\nSender " << senderId << " - Commands: 'send' or 'quit'" << endl;
+        cout << "\nSender " << senderId << " - Commands: 'send', 'batch' or 'quit'" << endl;
 
         while (running) {
             cout << "[" << senderId << "]> ";
@@ -105,25 +234,46 @@ public:
 
             if (command == "send") {
                 string message;
-                cout << "Enter message (max " << MAX_MESSAGE_LEN << " chars): ";
+                cout << "Enter message (max " << MaxLength() << " chars): ";
                 cin.ignore();
                 getline(cin, message);
 
-                if (message.length() > MAX_MESSAGE_LEN) {
+                if (message.length() > MaxLength()) {
                     cout << "Message too long! Truncating..." << endl;
-                    message = message.substr(0, MAX_MESSAGE_LEN);
+                    message = message.substr(0, MaxLength());
                 }
 
-                if (!SendMessage(message)) {
+                string key;
+                if (backend == BACKEND_PARTITIONED) {
+                    cout << "Enter key (empty for round-robin): ";
+                    getline(cin, key);
+                }
+
+                int priority = ReadPriority();
+                if (!SendMessage(message, key, priority)) {
                     cout << "Failed to send message!" << endl;
                 }
             }
+            else if (command == "batch") {
+                vector<string> messages;
+                string message;
+                cout << "Enter messages, one per line, empty line to finish:" << endl;
+                cin.ignore();
+                while (getline(cin, message) && !message.empty()) {
+                    messages.push_back(message.substr(0, MaxLength()));
+                }
+
+                int priority = ReadPriority();
+                if (SendBatch(messages, priority) < messages.size()) {
+                    cout << "Failed to send the whole batch!" << endl;
+                }
+            }
             else if (command == "quit") {
                 running = false;
                 cout << "Sender " << senderId << " terminated." << endl;
             }
             else {
-                cout << "Unknown command. Use 'send' or 'quit'" << endl;
+                cout << "Unknown command. Use 'send', 'batch' or 'quit'" << endl;
             }
         }
     }
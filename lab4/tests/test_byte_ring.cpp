@@ -0,0 +1,245 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+#include "byte_ring.h"
+
+#if defined(__linux__)
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+class ByteRingTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        name = SharedRegionName(std::string("test_byte_ring_")
+            + ::testing::UnitTest::GetInstance()->current_test_info()->name());
+    }
+
+    void TearDown() override {
+        ring.Close();
+        ByteRing::Remove(name);
+    }
+
+    // Message n of sender s: "s:n:" followed by filler, length between 8 and maxLength.
+    static std::string Payload(int s, int n, size_t maxLength) {
+        std::string text = std::to_string(s) + ":" + std::to_string(n) + ":";
+        size_t length = 8 + (size_t)(n * 7919 + s * 104729) % (maxLength - 7);
+        text.resize(std::max(length, text.size()), (char)('a' + n % 26));
+        return text;
+    }
+
+    std::string name;
+    ByteRing ring;
+};
+
+TEST_F(ByteRingTest, SizesFromEightBytesToMax) {
+    ASSERT_TRUE(ring.Create(name, 0));
+    EXPECT_EQ(ring.MaxMessage(), kDefaultMaxMessage);
+    EXPECT_GE(ring.CapacityBytes(), 2 * ByteRing::RecordBytes(kDefaultMaxMessage));
+
+    for (size_t length = 8; length <= kDefaultMaxMessage; length *= 2) {
+        std::string text(length, 'x');
+        text[0] = 'a';
+        text[length - 1] = 'z';
+
+        int msgId;
+        ASSERT_TRUE(ring.Send(text, 0, &msgId));
+        EXPECT_GE(ring.UsedBytes(), ByteRing::RecordBytes(length));  // plus padding on a wrap
+
+        std::string readMsg;
+        int readId;
+        ASSERT_TRUE(ring.Read(readMsg, readId, 0));
+        EXPECT_EQ(readMsg, text);
+        EXPECT_EQ(readId, msgId);
+    }
+    EXPECT_EQ(ring.UsedBytes(), 0u);
+}
+
+TEST_F(ByteRingTest, TooLongIsRefused) {
+    ASSERT_TRUE(ring.Create(name, 0, 100));
+    EXPECT_TRUE(ring.Send(std::string(100, 'y'), 0));
+    EXPECT_FALSE(ring.Send(std::string(101, 'y'), 0));
+
+    std::string readMsg;
+    int readId;
+    EXPECT_TRUE(ring.Read(readMsg, readId, 0));
+    EXPECT_EQ(readMsg.size(), 100u);
+    EXPECT_FALSE(ring.Read(readMsg, readId, 0));
+}
+
+TEST_F(ByteRingTest, WrapLeavesPaddingRecord) {
+    // 256 bytes of ring: three 64-byte records fill 216, so the fourth does not
+    // fit before the end and must start at offset 0 after a padding record.
+    ASSERT_TRUE(ring.Create(name, 256, 64));
+    ASSERT_EQ(ring.CapacityBytes(), 256u);
+
+    std::string readMsg;
+    int readId;
+    for (int i = 0; i < 3; i++) ASSERT_TRUE(ring.Send(std::string(64, (char)('a' + i)), 0));
+    ASSERT_TRUE(ring.Read(readMsg, readId, 0));
+    ASSERT_TRUE(ring.Read(readMsg, readId, 0));
+
+    // 144 bytes free in total but only 40 before the wrap.
+    ASSERT_TRUE(ring.Send(std::string(64, 'd'), 0));
+    EXPECT_EQ(ring.UsedBytes(), 40u + 2 * ByteRing::RecordBytes(64));
+
+    ASSERT_TRUE(ring.Read(readMsg, readId, 0));
+    EXPECT_EQ(readMsg, std::string(64, 'c'));
+    ASSERT_TRUE(ring.Read(readMsg, readId, 0));
+    EXPECT_EQ(readMsg, std::string(64, 'd'));
+    EXPECT_EQ(readId, 4);
+    EXPECT_EQ(ring.UsedBytes(), 0u);
+}
+
+TEST_F(ByteRingTest, FullAndEmpty) {
+    ASSERT_TRUE(ring.Create(name, 256, 64));
+
+    std::string readMsg;
+    int readId;
+    EXPECT_FALSE(ring.Read(readMsg, readId, 0));
+    EXPECT_FALSE(ring.Read(readMsg, readId, 20));
+
+    // Small records pack: 256 / 16 of them fit.
+    for (int i = 0; i < 16; i++) EXPECT_TRUE(ring.Send("12345678", 0));
+    EXPECT_FALSE(ring.Send("x", 0));
+    EXPECT_FALSE(ring.Send("x", 20));
+}
+
+TEST_F(ByteRingTest, StatsCountSendsReadsAndWaits) {
+    ASSERT_TRUE(ring.Create(name, 256, 64));
+    ByteRing watcher;
+    ASSERT_TRUE(watcher.Open(name, true));
+
+    // 16 records of 16 bytes fill the ring; the high water is in messages.
+    for (int i = 0; i < 16; i++) ASSERT_TRUE(ring.Send("12345678", 0));
+    EXPECT_FALSE(ring.Send("x", 0));  // only tried: not a wait
+    QueueStatsTotals totals = SumQueueStats(*watcher.Stats());
+    EXPECT_EQ(totals.enqueued, 16u);
+    EXPECT_EQ(totals.highWater, 16u);
+    EXPECT_EQ(totals.fullWaits, 0u);
+    EXPECT_EQ(totals.senders, 1);
+
+    std::thread sender([this]() { EXPECT_TRUE(ring.Send("waited", 2000)); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    std::vector<ReceivedMessage> out;
+    ASSERT_EQ(ring.ReadBatch(out, SIZE_MAX, 0), 16u);
+    sender.join();
+
+    std::string readMsg;
+    int readId;
+    ASSERT_TRUE(ring.Read(readMsg, readId, 1000));
+    EXPECT_EQ(readMsg, "waited");
+    EXPECT_FALSE(ring.Read(readMsg, readId, 10));
+
+    totals = SumQueueStats(*watcher.Stats());
+    EXPECT_EQ(totals.enqueued, 17u);
+    EXPECT_EQ(totals.dequeued, 17u);
+    EXPECT_EQ(totals.fullWaits, 1u);
+    EXPECT_GE(totals.waitNs, 10000000u);
+    EXPECT_EQ(totals.emptyWaits, 1u);
+}
+
+TEST_F(ByteRingTest, BlockedSenderWakesWhenSpaceFrees) {
+    ASSERT_TRUE(ring.Create(name, 256, 64));
+    for (int i = 0; i < 3; i++) ASSERT_TRUE(ring.Send(std::string(64, 'f'), 0));
+
+    std::atomic<bool> sent(false);
+    std::thread sender([this, &sent]() { sent = ring.Send(std::string(64, 'l')); });
+
+    std::string readMsg;
+    int readId;
+    for (int i = 0; i < 4; i++) ASSERT_TRUE(ring.Read(readMsg, readId, 5000));
+    EXPECT_EQ(readMsg, std::string(64, 'l'));
+    sender.join();
+    EXPECT_TRUE(sent);
+}
+
+TEST_F(ByteRingTest, BatchAcrossWrap) {
+    ASSERT_TRUE(ring.Create(name, 512, 100));
+
+    std::thread sender([this]() {
+        for (int n = 0; n < 500; n++) ring.Send(Payload(0, n, 100));
+    });
+
+    int received = 0;
+    int expectedId = 1;
+    std::vector<ReceivedMessage> out;
+    while (received < 500) {
+        ASSERT_GT(ring.ReadBatch(out, 4, 5000), 0u);
+        for (const auto& m : out) {
+            EXPECT_EQ(m.msgId, expectedId++);
+            EXPECT_EQ(m.text, Payload(0, received++, 100));
+        }
+    }
+    sender.join();
+    EXPECT_EQ(ring.ReadBatch(out, SIZE_MAX, 0), 0u);
+}
+
+TEST_F(ByteRingTest, ManySendersMixedSizes) {
+    const int senders = 4;
+    const int perSender = 1000;
+    const size_t maxLength = 4096;
+    ASSERT_TRUE(ring.Create(name, 16 * 1024, maxLength));
+
+    std::vector<std::thread> threads;
+    for (int s = 0; s < senders; s++) {
+        threads.emplace_back([this, s, maxLength]() {
+            for (int n = 0; n < perSender; n++) ring.Send(Payload(s, n, maxLength));
+        });
+    }
+
+    std::vector<int> next(senders, 0);
+    for (int i = 0; i < senders * perSender; i++) {
+        std::string readMsg;
+        int readId;
+        ASSERT_TRUE(ring.Read(readMsg, readId, 5000));
+        EXPECT_EQ(readId, i + 1);
+
+        int s = std::stoi(readMsg.substr(0, readMsg.find(':')));
+        EXPECT_EQ(readMsg, Payload(s, next[s]++, maxLength));
+    }
+    for (auto& t : threads) t.join();
+}
+
+#if defined(__linux__)
+TEST_F(ByteRingTest, SenderProcesses) {
+    const int processes = 3;
+    const int perProcess = 300;
+    ASSERT_TRUE(ring.Create(name, 8 * 1024));
+
+    std::vector<pid_t> children;
+    for (int p = 0; p < processes; p++) {
+        pid_t child = fork();
+        ASSERT_GE(child, 0);
+        if (child == 0) {
+            ByteRing sender;
+            if (!sender.Open(name)) _exit(1);
+            for (int n = 0; n < perProcess; n++) {
+                if (!sender.Send(Payload(p, n, kDefaultMaxMessage))) _exit(2);
+            }
+            _exit(0);
+        }
+        children.push_back(child);
+    }
+
+    std::vector<int> next(processes, 0);
+    for (int i = 0; i < processes * perProcess; i++) {
+        std::string readMsg;
+        int readId;
+        ASSERT_TRUE(ring.Read(readMsg, readId, 5000));
+        int p = std::stoi(readMsg.substr(0, readMsg.find(':')));
+        EXPECT_EQ(readMsg, Payload(p, next[p]++, kDefaultMaxMessage));
+    }
+
+    for (pid_t child : children) {
+        int status = 0;
+        waitpid(child, &status, 0);
+        EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    }
+}
+#endif
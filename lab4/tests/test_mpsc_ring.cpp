@@ -0,0 +1,425 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "mpsc_ring.h"
+
+#if defined(__linux__)
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+class MpscRingTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        name = SharedRegionName(std::string("test_mpsc_ring_")
+            + ::testing::UnitTest::GetInstance()->current_test_info()->name());
+        capacity = 5;
+        ASSERT_TRUE(ring.Create(name, capacity));
+    }
+
+    void TearDown() override {
+        ring.Close();
+        MpscRing::Remove(name);
+    }
+
+    std::string name;
+    int capacity;
+    MpscRing ring;
+};
+
+TEST_F(MpscRingTest, FIFOOrderAcrossWrap) {
+    // Three laps around a five-slot ring.
+    for (int lap = 0; lap < 3; lap++) {
+        for (int i = 0; i < capacity; i++) {
+            int msgId;
+            EXPECT_TRUE(ring.Send("m" + std::to_string(i), 0, &msgId));
+            EXPECT_EQ(msgId, lap * capacity + i + 1);
+        }
+        for (int i = 0; i < capacity; i++) {
+            std::string readMsg;
+            int readId;
+            EXPECT_TRUE(ring.Read(readMsg, readId, 0));
+            EXPECT_EQ(readMsg, "m" + std::to_string(i));
+            EXPECT_EQ(readId, lap * capacity + i + 1);
+        }
+    }
+}
+
+TEST_F(MpscRingTest, FullAndEmpty) {
+    std::string readMsg;
+    int readId;
+    EXPECT_FALSE(ring.Read(readMsg, readId, 0));
+    EXPECT_FALSE(ring.Read(readMsg, readId, 20));
+
+    for (int i = 0; i < capacity; i++) EXPECT_TRUE(ring.Send("x", 0));
+    EXPECT_FALSE(ring.Send("extra", 0));
+    EXPECT_FALSE(ring.Send("extra", 20));
+    EXPECT_EQ(ring.Count(), capacity);
+}
+
+TEST_F(MpscRingTest, BinaryPayloadAndTruncation) {
+    std::string payload("a\0b", 3);
+    EXPECT_TRUE(ring.Send(payload, 0));
+    EXPECT_TRUE(ring.Send(std::string(MAX_MESSAGE_LEN + 5, 'y'), 0));
+
+    std::string readMsg;
+    int readId;
+    EXPECT_TRUE(ring.Read(readMsg, readId, 0));
+    EXPECT_EQ(readMsg, payload);
+    EXPECT_TRUE(ring.Read(readMsg, readId, 0));
+    EXPECT_EQ(readMsg, std::string(MAX_MESSAGE_LEN, 'y'));
+}
+
+TEST_F(MpscRingTest, BlockedSenderWakesWhenSpaceFrees) {
+    for (int i = 0; i < capacity; i++) ASSERT_TRUE(ring.Send("fill", 0));
+
+    std::atomic<bool> sent(false);
+    std::thread sender([this, &sent]() { sent = ring.Send("late"); });
+
+    std::string readMsg;
+    int readId;
+    ASSERT_TRUE(ring.Read(readMsg, readId));
+    sender.join();
+    EXPECT_TRUE(sent);
+}
+
+TEST_F(MpscRingTest, ManySendersKeepPerSenderOrder) {
+    const int senders = 4;
+    const int perSender = 2000;
+    std::vector<std::thread> threads;
+    for (int s = 0; s < senders; s++) {
+        threads.emplace_back([this, s]() {
+            for (int i = 0; i < perSender; i++) ring.Send(std::to_string(s) + ":" + std::to_string(i));
+        });
+    }
+
+    std::vector<int> next(senders, 0);
+    for (int n = 0; n < senders * perSender; n++) {
+        std::string readMsg;
+        int readId;
+        ASSERT_TRUE(ring.Read(readMsg, readId));
+        EXPECT_EQ(readId, n + 1);
+
+        size_t colon = readMsg.find(':');
+        int s = std::stoi(readMsg.substr(0, colon));
+        EXPECT_EQ(std::stoi(readMsg.substr(colon + 1)), next[s]++);
+    }
+    for (auto& t : threads) t.join();
+}
+
+TEST_F(MpscRingTest, BatchRoundTrip) {
+    std::vector<std::string> texts = { "a", "b", "c" };
+    int firstId = 0;
+    EXPECT_EQ(ring.SendBatch(texts, 0, &firstId), texts.size());
+    EXPECT_EQ(firstId, 1);
+
+    std::vector<ReceivedMessage> out;
+    EXPECT_EQ(ring.ReadBatch(out, 2, 0), 2u);
+    EXPECT_EQ(out[0].text, "a");
+    EXPECT_EQ(out[1].msgId, 2);
+
+    // Drain whatever is left, then nothing is left.
+    EXPECT_EQ(ring.ReadBatch(out, SIZE_MAX, 0), 1u);
+    EXPECT_EQ(out[0].text, "c");
+    EXPECT_EQ(out[0].msgId, 3);
+    EXPECT_EQ(ring.ReadBatch(out, SIZE_MAX, 0), 0u);
+}
+
+TEST_F(MpscRingTest, BatchLargerThanCapacity) {
+    std::vector<std::string> texts;
+    for (int i = 0; i < capacity * 4 + 2; i++) texts.push_back(std::to_string(i));
+
+    // Without a reader only one ring's worth fits.
+    EXPECT_EQ(ring.SendBatch(texts, 0), (size_t)capacity);
+    std::vector<ReceivedMessage> out;
+    EXPECT_EQ(ring.ReadBatch(out, SIZE_MAX, 0), (size_t)capacity);
+
+    std::thread sender([this, &texts]() { EXPECT_EQ(ring.SendBatch(texts), texts.size()); });
+    size_t received = 0;
+    while (received < texts.size()) {
+        ASSERT_GT(ring.ReadBatch(out, 3, 5000), 0u);
+        for (const auto& m : out) EXPECT_EQ(m.text, texts[received++]);
+    }
+    sender.join();
+}
+
+TEST_F(MpscRingTest, ConcurrentBatchSenders) {
+    const int senders = 4;
+    const int batches = 100;
+    const int batchSize = 7;
+    std::vector<std::thread> threads;
+    for (int s = 0; s < senders; s++) {
+        threads.emplace_back([this, s]() {
+            for (int b = 0; b < batches; b++) {
+                std::vector<std::string> texts;
+                for (int i = 0; i < batchSize; i++) texts.push_back(std::to_string(s) + ":" + std::to_string(b * batchSize + i));
+                ring.SendBatch(texts);
+            }
+        });
+    }
+
+    std::vector<int> next(senders, 0);
+    std::vector<ReceivedMessage> out;
+    int expectedId = 1;
+    for (int received = 0; received < senders * batches * batchSize;) {
+        ASSERT_GT(ring.ReadBatch(out, 16, 5000), 0u);
+        for (const auto& m : out) {
+            EXPECT_EQ(m.msgId, expectedId++);
+            size_t colon = m.text.find(':');
+            int s = std::stoi(m.text.substr(0, colon));
+            EXPECT_EQ(std::stoi(m.text.substr(colon + 1)), next[s]++);
+            received++;
+        }
+    }
+    for (auto& t : threads) t.join();
+}
+
+#if defined(__linux__)
+TEST_F(MpscRingTest, SenderProcesses) {
+    const int processes = 3;
+    const int perProcess = 300;
+    std::vector<pid_t> children;
+    for (int p = 0; p < processes; p++) {
+        pid_t child = fork();
+        ASSERT_GE(child, 0);
+        if (child == 0) {
+            MpscRing sender;
+            if (!sender.Open(name)) _exit(1);
+            for (int i = 0; i < perProcess; i++) {
+                if (!sender.Send(std::to_string(p) + ":" + std::to_string(i))) _exit(2);
+            }
+            _exit(0);
+        }
+        children.push_back(child);
+    }
+
+    std::vector<int> next(processes, 0);
+    for (int n = 0; n < processes * perProcess; n++) {
+        std::string readMsg;
+        int readId;
+        ASSERT_TRUE(ring.Read(readMsg, readId, 5000));
+        size_t colon = readMsg.find(':');
+        int p = std::stoi(readMsg.substr(0, colon));
+        EXPECT_EQ(std::stoi(readMsg.substr(colon + 1)), next[p]++);
+    }
+
+    for (pid_t child : children) {
+        int status = 0;
+        waitpid(child, &status, 0);
+        EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    }
+}
+#endif
+
+TEST_F(MpscRingTest, ViewReadsInPlace) {
+    std::string payload("in\0place", 8);
+    ASSERT_TRUE(ring.Send(payload, 0));
+
+    MessageView view;
+    ASSERT_TRUE(ring.Acquire(view, 0));
+    EXPECT_EQ(std::string(view.data, view.length), payload);
+    EXPECT_EQ(view.msgId, 1);
+    EXPECT_EQ(ring.Count(), 1);
+
+    // The slot is still taken, and plain reads wait for the view to go.
+    std::string readMsg;
+    int readId;
+    EXPECT_FALSE(ring.Read(readMsg, readId, 0));
+
+    ring.Release(view);
+    EXPECT_EQ(ring.Count(), 0);
+    EXPECT_EQ(ring.Outstanding(), 0u);
+    EXPECT_FALSE(ring.Acquire(view, 0));
+}
+
+TEST_F(MpscRingTest, OutOfOrderReleaseFreesOnlyThePrefix) {
+    for (int i = 0; i < capacity; i++) ASSERT_TRUE(ring.Send("v" + std::to_string(i), 0));
+
+    std::vector<MessageView> views;
+    ASSERT_EQ(ring.AcquireBatch(views, SIZE_MAX, 0), (size_t)capacity);
+    MessageView extra;
+    EXPECT_FALSE(ring.Acquire(extra, 0));
+
+    ring.Release(views[2]);
+    ring.Release(views[4]);
+    EXPECT_EQ(ring.Count(), capacity);
+    EXPECT_FALSE(ring.Send("full", 0));
+
+    ring.Release(views[0]);
+    EXPECT_EQ(ring.Count(), capacity - 1);
+    ring.Release(views[1]);
+    EXPECT_EQ(ring.Count(), capacity - 3);
+    EXPECT_EQ(std::string(views[3].data, views[3].length), "v3");
+    ring.Release(views[3]);
+    EXPECT_EQ(ring.Count(), 0);
+
+    // Plain reads work again and continue the order.
+    ASSERT_TRUE(ring.Send("after", 0));
+    std::string readMsg;
+    int readId;
+    ASSERT_TRUE(ring.Read(readMsg, readId, 0));
+    EXPECT_EQ(readMsg, "after");
+    EXPECT_EQ(readId, capacity + 1);
+}
+
+TEST_F(MpscRingTest, HeldViewIsNotOverwritten) {
+    for (int i = 0; i < capacity; i++) ASSERT_TRUE(ring.Send("held" + std::to_string(i), 0));
+
+    MessageView first;
+    ASSERT_TRUE(ring.Acquire(first, 0));
+    std::vector<MessageView> rest;
+    ASSERT_EQ(ring.AcquireBatch(rest, SIZE_MAX, 0), (size_t)capacity - 1);
+    for (const auto& view : rest) ring.Release(view);
+
+    // Every other slot is free, but the first one is still held.
+    std::atomic<bool> sent(false);
+    std::thread sender([this, &sent]() { sent = ring.Send("new", 2000); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_FALSE(sent);
+    EXPECT_EQ(std::string(first.data, first.length), "held0");
+
+    ring.Release(first);
+    sender.join();
+    EXPECT_TRUE(sent);
+}
+
+TEST_F(MpscRingTest, ViewsWithConcurrentSenders) {
+    const int total = 3000;
+    std::thread sender([this]() {
+        for (int i = 0; i < total; i++) ring.Send(std::to_string(i));
+    });
+
+    // Release each batch newest first.
+    int next = 0;
+    std::vector<MessageView> views;
+    while (next < total) {
+        ASSERT_GT(ring.AcquireBatch(views, 3, 5000), 0u);
+        for (const auto& view : views) EXPECT_EQ(std::string(view.data, view.length), std::to_string(next++));
+        for (auto it = views.rbegin(); it != views.rend(); ++it) ring.Release(*it);
+    }
+    sender.join();
+    EXPECT_EQ(ring.Count(), 0);
+}
+
+TEST_F(MpscRingTest, StatsCountSendsReadsAndWaits) {
+    for (int i = 0; i < 3; i++) ASSERT_TRUE(ring.Send("s", 0));
+    ASSERT_EQ(ring.SendBatch({ "b", "b" }, 0), 2u);
+    EXPECT_FALSE(ring.Send("tried", 0));  // only tried: not a wait
+
+    QueueStatsTotals totals = SumQueueStats(*ring.Stats());
+    EXPECT_EQ(totals.enqueued, 5u);
+    EXPECT_EQ(totals.highWater, (uint64_t)capacity);
+    EXPECT_EQ(totals.fullWaits, 0u);
+    EXPECT_EQ(totals.senders, 1);
+
+    // A send that has to wait for the reader counts as a full wait.
+    std::thread sender([this]() { EXPECT_TRUE(ring.Send("waited", 2000)); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    std::vector<ReceivedMessage> out;
+    ASSERT_EQ(ring.ReadBatch(out, SIZE_MAX, 0), (size_t)capacity);
+    sender.join();
+
+    std::string readMsg;
+    int readId;
+    ASSERT_TRUE(ring.Read(readMsg, readId, 0));
+    EXPECT_FALSE(ring.Read(readMsg, readId, 10));
+
+    totals = SumQueueStats(*ring.Stats());
+    EXPECT_EQ(totals.enqueued, 6u);
+    EXPECT_EQ(totals.dequeued, 6u);
+    EXPECT_EQ(totals.fullWaits, 1u);
+    EXPECT_GE(totals.waitNs, 10000000u);
+    EXPECT_EQ(totals.emptyWaits, 1u);
+}
+
+TEST_F(MpscRingTest, StatsSlotsPerSenderAndReadOnlyWatcher) {
+    MpscRing watcher;
+    ASSERT_TRUE(watcher.Open(name, true));
+
+    {
+        MpscRing other;
+        ASSERT_TRUE(other.Open(name));
+        ASSERT_TRUE(other.Send("other", 0));
+        ASSERT_TRUE(ring.Send("own", 0));
+        ASSERT_TRUE(ring.Send("own", 0));
+
+        int held = 0;
+        for (const auto& slot : watcher.Stats()->senders) {
+            if (slot.pid.load() == 0) continue;
+            held++;
+            EXPECT_TRUE(slot.enqueued.load() == 1 || slot.enqueued.load() == 2);
+        }
+        EXPECT_EQ(held, 2);
+    }
+
+    // Closing frees the slot and keeps its count in the totals.
+    QueueStatsTotals totals = SumQueueStats(*watcher.Stats());
+    EXPECT_EQ(totals.senders, 1);
+    EXPECT_EQ(totals.enqueued, 3u);
+    EXPECT_EQ(watcher.Count(), 3);
+}
+
+#if defined(__linux__)
+TEST_F(MpscRingTest, StatsSlotOfDeadSenderIsReused) {
+    pid_t child = fork();
+    ASSERT_GE(child, 0);
+    if (child == 0) {
+        MpscRing sender;
+        if (!sender.Open(name) || !sender.Send("from child", 0)) _exit(1);
+        _exit(0);  // without closing
+    }
+    int status = 0;
+    waitpid(child, &status, 0);
+    ASSERT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    // Fill every other slot, then one more sender takes the dead one's.
+    std::vector<std::unique_ptr<MpscRing>> senders;
+    for (int i = 0; i < kMaxStatSenders - 1; i++) {
+        senders.emplace_back(new MpscRing());
+        ASSERT_TRUE(senders.back()->Open(name));
+        senders.back()->Send("s", 0);
+    }
+    ring.Send("last", 0);
+
+    QueueStatsTotals totals = SumQueueStats(*ring.Stats());
+    EXPECT_EQ(totals.senders, kMaxStatSenders);
+    EXPECT_EQ(totals.enqueued, (uint64_t)capacity);  // the ring filled up; the rest were only tries
+    EXPECT_EQ(ring.Stats()->retired.enqueued.load(), 1u);
+    for (const auto& slot : ring.Stats()->senders) EXPECT_NE(slot.pid.load(), (int32_t)child);
+}
+#endif
+
+TEST(MpscRingCapacityTest, OneSlotIsRefusedTwoSlotsWork) {
+    std::string name = SharedRegionName("test_mpsc_ring_capacity");
+    MpscRing ring;
+    EXPECT_FALSE(ring.Create(name, 1));
+    EXPECT_FALSE(ring.Create(name, 0));
+
+    // A published message must not read as free for the next lap.
+    ASSERT_TRUE(ring.Create(name, 2));
+    for (int lap = 0; lap < 3; lap++) {
+        ASSERT_TRUE(ring.Send("a", 0));
+        ASSERT_TRUE(ring.Send("b", 0));
+        EXPECT_FALSE(ring.Send("c", 0));
+        EXPECT_EQ(ring.Count(), 2);
+
+        std::string readMsg;
+        int readId;
+        ASSERT_TRUE(ring.Read(readMsg, readId, 0));
+        EXPECT_EQ(readMsg, "a");
+        ASSERT_TRUE(ring.Send("c", 0));
+        EXPECT_FALSE(ring.Send("d", 0));
+        ASSERT_TRUE(ring.Read(readMsg, readId, 0));
+        EXPECT_EQ(readMsg, "b");
+        ASSERT_TRUE(ring.Read(readMsg, readId, 0));
+        EXPECT_EQ(readMsg, "c");
+        EXPECT_FALSE(ring.Read(readMsg, readId, 0));
+    }
+    ring.Close();
+    MpscRing::Remove(name);
+}
@@ -0,0 +1,227 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "partitioned_queue.h"
+
+#if defined(__linux__)
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+class PartitionedQueueTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        name = SharedRegionName(std::string("test_partitioned_")
+            + ::testing::UnitTest::GetInstance()->current_test_info()->name());
+        partitions = 4;
+        ASSERT_TRUE(queue.Create(name, partitions, 16));
+    }
+
+    void TearDown() override {
+        queue.Close();
+        PartitionedQueue::Remove(name);
+    }
+
+    std::string name;
+    int partitions;
+    PartitionedQueue queue;
+};
+
+TEST_F(PartitionedQueueTest, KeyedMessagesKeepKeyOrder) {
+    ASSERT_TRUE(queue.Join());
+    EXPECT_EQ(queue.OwnedPartitions().size(), (size_t)partitions);
+
+    const char* keys[] = { "alpha", "beta", "gamma", "delta", "epsilon" };
+    for (int i = 0; i < 3; i++) {
+        for (const char* key : keys) ASSERT_TRUE(queue.SendKeyed(key, std::string(key) + ":" + std::to_string(i), 0));
+    }
+
+    std::map<std::string, int> next;
+    for (int n = 0; n < 15; n++) {
+        std::string readMsg;
+        int readId;
+        int partition;
+        ASSERT_TRUE(queue.Read(readMsg, readId, &partition, 0));
+
+        std::string key = readMsg.substr(0, readMsg.find(':'));
+        EXPECT_EQ(partition, queue.PartitionFor(key));
+        EXPECT_EQ(std::stoi(readMsg.substr(key.size() + 1)), next[key]++);
+    }
+    std::string readMsg;
+    int readId;
+    EXPECT_FALSE(queue.Read(readMsg, readId, nullptr, 0));
+}
+
+TEST_F(PartitionedQueueTest, OneSlotPartitionsAreRefused) {
+    PartitionedQueue small;
+    std::string smallName = name + "_small";
+    EXPECT_FALSE(small.Create(smallName, 2, 1));
+    ASSERT_TRUE(small.Create(smallName, 2, 2));
+    small.Close();
+    PartitionedQueue::Remove(smallName);
+}
+
+TEST_F(PartitionedQueueTest, RoundRobinSkipsFullPartitions) {
+    for (int i = 0; i < 2 * partitions; i++) {
+        int partition;
+        ASSERT_TRUE(queue.Send("rr", 0, nullptr, &partition));
+        EXPECT_EQ(partition, i % partitions);
+    }
+
+    // Fill partition 0 through its key; round-robin then goes around it.
+    std::string key;
+    for (int k = 0; queue.PartitionFor(key = "k" + std::to_string(k)) != 0; k++) {}
+    while (queue.SendKeyed(key, "fill", 0)) {}
+
+    int partition;
+    for (int i = 0; i < partitions; i++) {
+        ASSERT_TRUE(queue.Send("rr", 0, nullptr, &partition));
+        EXPECT_NE(partition, 0);
+    }
+    EXPECT_EQ(queue.Count(), 16 + 2 * partitions - 2 + partitions);
+}
+
+TEST_F(PartitionedQueueTest, RebalanceOnJoinAndLeave) {
+    PartitionedQueue other;
+    ASSERT_TRUE(other.Open(name));
+
+    uint32_t generation = queue.Generation();
+    ASSERT_TRUE(queue.Join());
+    EXPECT_EQ(queue.OwnedPartitions(), std::vector<int>({ 0, 1, 2, 3 }));
+
+    ASSERT_TRUE(other.Join());
+    EXPECT_EQ(queue.OwnedPartitions(), std::vector<int>({ 0, 2 }));
+    EXPECT_EQ(other.OwnedPartitions(), std::vector<int>({ 1, 3 }));
+    EXPECT_EQ(queue.Generation(), generation + 2);
+
+    // Messages in partition 1 now go to the other receiver only.
+    ASSERT_TRUE(queue.Send("to-0", 0));
+    ASSERT_TRUE(queue.Send("to-1", 0));
+    std::string readMsg;
+    int readId;
+    int partition;
+    ASSERT_TRUE(other.Read(readMsg, readId, &partition, 0));
+    EXPECT_EQ(readMsg, "to-1");
+    EXPECT_FALSE(other.Read(readMsg, readId, &partition, 0));
+
+    other.Leave();
+    EXPECT_FALSE(other.Joined());
+    EXPECT_EQ(queue.OwnedPartitions(), std::vector<int>({ 0, 1, 2, 3 }));
+    ASSERT_TRUE(queue.Read(readMsg, readId, &partition, 0));
+    EXPECT_EQ(readMsg, "to-0");
+}
+
+TEST_F(PartitionedQueueTest, MemberSlotsRunOut) {
+    std::vector<std::unique_ptr<PartitionedQueue>> receivers;
+    for (int i = 0; i < kMaxPartitionReceivers; i++) {
+        receivers.emplace_back(new PartitionedQueue());
+        ASSERT_TRUE(receivers.back()->Open(name));
+        ASSERT_TRUE(receivers.back()->Join());
+    }
+    EXPECT_FALSE(queue.Join());
+
+    // Closing leaves, which frees the slot.
+    receivers.pop_back();
+    EXPECT_TRUE(queue.Join());
+}
+
+TEST_F(PartitionedQueueTest, ReceiversSplitTheLoadThroughChurn) {
+    const int senders = 4;
+    const int perSender = 1000;
+    const int total = senders * perSender;
+
+    std::atomic<int> received(0);
+    std::vector<std::atomic<int>> seen(total);
+    for (auto& s : seen) s = 0;
+    std::atomic<int> byReceiver[2];
+    byReceiver[0] = byReceiver[1] = 0;
+
+    auto receive = [&](int index) {
+        PartitionedQueue receiver;
+        ASSERT_TRUE(receiver.Open(name));
+        ASSERT_TRUE(receiver.Join());
+        std::vector<ReceivedMessage> out;
+        while (received < total) {
+            receiver.ReadBatch(out, 8, 20);
+            for (const auto& m : out) {
+                seen[std::stoi(m.text)]++;
+                byReceiver[index]++;
+                received++;
+            }
+        }
+    };
+    std::thread first(receive, 0);
+    std::thread second(receive, 1);
+
+    // A third receiver keeps joining and leaving, moving partitions around.
+    std::atomic<bool> stop(false);
+    std::thread churn([&]() {
+        PartitionedQueue visitor;
+        ASSERT_TRUE(visitor.Open(name));
+        while (!stop) {
+            visitor.Join();
+            std::this_thread::yield();
+            visitor.Leave();
+        }
+    });
+
+    std::vector<std::thread> threads;
+    for (int s = 0; s < senders; s++) {
+        threads.emplace_back([this, s]() {
+            for (int i = 0; i < perSender; i++) queue.Send(std::to_string(s * perSender + i));
+        });
+    }
+    for (auto& t : threads) t.join();
+    first.join();
+    second.join();
+    stop = true;
+    churn.join();
+
+    for (int i = 0; i < total; i++) EXPECT_EQ(seen[i], 1) << i;
+    EXPECT_GT(byReceiver[0], 0);
+    EXPECT_GT(byReceiver[1], 0);
+}
+
+#if defined(__linux__)
+TEST_F(PartitionedQueueTest, DeadReceiverIsReaped) {
+    pid_t child = fork();
+    ASSERT_GE(child, 0);
+    if (child == 0) {
+        PartitionedQueue receiver;
+        if (!receiver.Open(name) || !receiver.Join()) _exit(1);
+        _exit(0);  // without leaving
+    }
+    int status = 0;
+    waitpid(child, &status, 0);
+    ASSERT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    ASSERT_TRUE(queue.Join());
+    EXPECT_EQ(queue.OwnedPartitions().size(), (size_t)partitions);
+}
+
+TEST_F(PartitionedQueueTest, WaitingReceiverReapsDeadMember) {
+    ASSERT_TRUE(queue.Join());
+    pid_t child = fork();
+    ASSERT_GE(child, 0);
+    if (child == 0) {
+        PartitionedQueue receiver;
+        if (!receiver.Open(name) || !receiver.Join()) _exit(1);
+        _exit(0);  // without leaving, holding half the partitions
+    }
+    int status = 0;
+    waitpid(child, &status, 0);
+    ASSERT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    EXPECT_EQ(queue.OwnedPartitions().size(), (size_t)partitions / 2);
+
+    for (int p = 0; p < partitions; p++) ASSERT_TRUE(queue.Send(std::to_string(p), 0));
+    std::vector<ReceivedMessage> out;
+    size_t received = 0;
+    while (received < (size_t)partitions && queue.ReadBatch(out, SIZE_MAX, 2000) > 0) received += out.size();
+    EXPECT_EQ(received, (size_t)partitions);
+    EXPECT_EQ(queue.OwnedPartitions().size(), (size_t)partitions);
+}
+#endif
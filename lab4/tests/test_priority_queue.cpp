@@ -0,0 +1,159 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include "priority_queue.h"
+
+class PriorityQueueTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        name = SharedRegionName(std::string("test_priority_")
+            + ::testing::UnitTest::GetInstance()->current_test_info()->name());
+    }
+
+    void TearDown() override {
+        queue.Close();
+        PriorityQueue::Remove(name);
+    }
+
+    std::string ReadText(int* priority = nullptr) {
+        std::string readMsg;
+        int readId;
+        EXPECT_TRUE(queue.Read(readMsg, readId, priority, 0));
+        return readMsg;
+    }
+
+    std::string name;
+    PriorityQueue queue;
+};
+
+TEST_F(PriorityQueueTest, HighestPriorityFirstFIFOWithinLevel) {
+    ASSERT_TRUE(queue.Create(name, 3, 16));
+    for (int i = 0; i < 3; i++) ASSERT_TRUE(queue.Send("bulk" + std::to_string(i), 0, 0));
+    ASSERT_TRUE(queue.Send("normal", 1, 0));
+    ASSERT_TRUE(queue.Send("urgent0", 2, 0));
+    ASSERT_TRUE(queue.Send("urgent1", 2, 0));
+    EXPECT_FALSE(queue.Send("no such level", 3, 0));
+    EXPECT_EQ(queue.Count(), 6);
+
+    int priority;
+    EXPECT_EQ(ReadText(&priority), "urgent0");
+    EXPECT_EQ(priority, 2);
+    EXPECT_EQ(ReadText(), "urgent1");
+    EXPECT_EQ(ReadText(&priority), "normal");
+    EXPECT_EQ(priority, 1);
+    for (int i = 0; i < 3; i++) EXPECT_EQ(ReadText(), "bulk" + std::to_string(i));
+
+    std::string readMsg;
+    int readId;
+    EXPECT_FALSE(queue.Read(readMsg, readId, nullptr, 0));
+}
+
+TEST_F(PriorityQueueTest, LevelsShareOneBudget) {
+    ASSERT_TRUE(queue.Create(name, 2, 4));
+    ASSERT_TRUE(queue.Send("a", 0, 0));
+    ASSERT_TRUE(queue.Send("b", 0, 0));
+    ASSERT_TRUE(queue.Send("c", 1, 0));
+    ASSERT_TRUE(queue.Send("d", 1, 0));
+    EXPECT_FALSE(queue.Send("full", 0, 0));
+    EXPECT_FALSE(queue.Send("full", 1, 20));
+
+    // A waiting sender gets in once the receiver frees a unit.
+    std::atomic<bool> sent(false);
+    std::thread sender([this, &sent]() { sent = queue.Send("later", 1, 2000); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_FALSE(sent);
+    EXPECT_EQ(ReadText(), "c");
+    sender.join();
+    EXPECT_TRUE(sent);
+    EXPECT_EQ(queue.Count(), 4);
+}
+
+TEST_F(PriorityQueueTest, ReserveKeepsRoomForHigherLevels) {
+    // Level 0 may fill 8 - 2 * 2, level 1 8 - 2, level 2 all 8.
+    ASSERT_TRUE(queue.Create(name, 3, 8, 2));
+    std::vector<std::string> bulk(10, "bulk");
+    EXPECT_EQ(queue.SendBatch(bulk, 0, 0), 4u);
+    EXPECT_EQ(queue.SendBatch(bulk, 1, 0), 2u);
+    EXPECT_EQ(queue.SendBatch(bulk, 2, 0), 2u);
+    EXPECT_EQ(queue.Count(), 8);
+    EXPECT_EQ(queue.LevelCount(0), 4);
+
+    EXPECT_FALSE(queue.Create(name, 3, 8, 4));  // nothing left for level 0
+}
+
+TEST_F(PriorityQueueTest, StarvationWeightServesLowerLevels) {
+    ASSERT_TRUE(queue.Create(name, 2, 32, 0, 3));
+    for (int i = 0; i < 12; i++) ASSERT_TRUE(queue.Send("high", 1, 0));
+    for (int i = 0; i < 3; i++) ASSERT_TRUE(queue.Send("low" + std::to_string(i), 0, 0));
+
+    // One low message after every three high ones, in order.
+    std::vector<ReceivedMessage> out;
+    ASSERT_EQ(queue.ReadBatch(out, SIZE_MAX, 0), 15u);
+    int low = 0;
+    for (size_t i = 0; i < out.size(); i++) {
+        if (i % 4 == 3 && low < 3) {
+            EXPECT_EQ(out[i].priority, 0) << i;
+            EXPECT_EQ(out[i].text, "low" + std::to_string(low++));
+        }
+        else {
+            EXPECT_EQ(out[i].priority, 1) << i;
+        }
+    }
+    EXPECT_EQ(low, 3);
+}
+
+TEST_F(PriorityQueueTest, StrictPriorityWithoutWeight) {
+    ASSERT_TRUE(queue.Create(name, 2, 32));
+    for (int i = 0; i < 3; i++) ASSERT_TRUE(queue.Send("low", 0, 0));
+    for (int i = 0; i < 12; i++) ASSERT_TRUE(queue.Send("high", 1, 0));
+
+    std::vector<ReceivedMessage> out;
+    ASSERT_EQ(queue.ReadBatch(out, SIZE_MAX, 0), 15u);
+    for (size_t i = 0; i < out.size(); i++) EXPECT_EQ(out[i].priority, i < 12 ? 1 : 0) << i;
+}
+
+TEST_F(PriorityQueueTest, UrgentMessagesOvertakeSaturatedBulk) {
+    ASSERT_TRUE(queue.Create(name, 2, 16, 4));
+    const int bulkTotal = 2000;
+    const int urgentTotal = 50;
+
+    std::thread bulk([this]() {
+        PriorityQueue sender;
+        ASSERT_TRUE(sender.Open(name));
+        for (int i = 0; i < bulkTotal; i++) ASSERT_TRUE(sender.Send(std::to_string(i), 0, 5000));
+    });
+    std::thread urgent([this]() {
+        PriorityQueue sender;
+        ASSERT_TRUE(sender.Open(name));
+        for (int i = 0; i < urgentTotal; i++) {
+            // Bulk can fill only 12 of the 16, so this waits on urgent messages alone.
+            ASSERT_TRUE(sender.Send(std::to_string(i), 1, 5000));
+            std::this_thread::yield();
+        }
+    });
+
+    // Bulk still queued as urgent messages are read was overtaken by them, and
+    // can never hold more than its 12 of the budget.
+    int next[2] = { 0, 0 };
+    int overtaken = 0;
+    std::vector<ReceivedMessage> out;
+    while (next[0] + next[1] < bulkTotal + urgentTotal) {
+        ASSERT_GT(queue.ReadBatch(out, 8, 5000), 0u);
+        int bulkQueued = queue.LevelCount(0);
+        for (const auto& m : out) {
+            EXPECT_EQ(m.text, std::to_string(next[m.priority]++));
+            if (m.priority == 0) continue;
+            EXPECT_LE(bulkQueued, 12);
+            if (bulkQueued > 0) overtaken++;
+        }
+    }
+    bulk.join();
+    urgent.join();
+    EXPECT_EQ(next[0], bulkTotal);
+    EXPECT_EQ(next[1], urgentTotal);
+    EXPECT_GT(overtaken, 0);
+    EXPECT_EQ(queue.Count(), 0);
+}
@@ -0,0 +1,399 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+#include "queue_futex.h"
+#include "shm_queue.h"
+
+#if defined(__linux__)
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+class ShmQueueTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        name = SharedRegionName(std::string("test_shm_queue_")
+            + ::testing::UnitTest::GetInstance()->current_test_info()->name());
+        capacity = 5;
+        ASSERT_TRUE(queue.Create(name, capacity));
+    }
+
+    void TearDown() override {
+        queue.Close();
+        ShmQueue::Remove(name);
+    }
+
+    std::string name;
+    int capacity;
+    ShmQueue queue;
+};
+
+TEST_F(ShmQueueTest, FIFOOrder) {
+    std::string messages[] = { "First", "Second", "Third" };
+
+    for (int i = 0; i < 3; i++) {
+        int msgId;
+        EXPECT_TRUE(queue.Send(messages[i], 0, &msgId));
+        EXPECT_EQ(msgId, i + 1);
+    }
+
+    for (int i = 0; i < 3; i++) {
+        std::string readMsg;
+        int readId;
+        EXPECT_TRUE(queue.Read(readMsg, readId, 0));
+        EXPECT_EQ(messages[i], readMsg);
+        EXPECT_EQ(readId, i + 1);
+    }
+}
+
+TEST_F(ShmQueueTest, QueueFull) {
+    for (int i = 0; i < capacity; i++) {
+        EXPECT_TRUE(queue.Send("Msg" + std::to_string(i), 0));
+    }
+    EXPECT_FALSE(queue.Send("Extra", 0));
+    EXPECT_FALSE(queue.Send("Extra", 20));
+    EXPECT_EQ(queue.Count(), capacity);
+}
+
+TEST_F(ShmQueueTest, EmptyQueue) {
+    std::string readMsg;
+    int readId;
+    EXPECT_FALSE(queue.Read(readMsg, readId, 0));
+    EXPECT_FALSE(queue.Read(readMsg, readId, 20));
+}
+
+TEST_F(ShmQueueTest, StatsCountSendsReadsAndWaits) {
+    ShmQueue watcher;
+    ASSERT_TRUE(watcher.Open(name, true));
+    for (int i = 0; i < 3; i++) ASSERT_TRUE(queue.Send("s", 0));
+    ASSERT_EQ(queue.SendBatch({ "b", "b" }, 0), 2u);
+    EXPECT_FALSE(queue.Send("tried", 0));  // only tried: not a wait
+
+    QueueStatsTotals totals = SumQueueStats(*watcher.Stats());
+    EXPECT_EQ(totals.enqueued, 5u);
+    EXPECT_EQ(totals.highWater, (uint64_t)capacity);
+    EXPECT_EQ(totals.fullWaits, 0u);
+    EXPECT_EQ(totals.senders, 1);
+
+    // A send that has to wait for the reader counts as a full wait.
+    std::thread sender([this]() { EXPECT_TRUE(queue.Send("waited", 2000)); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    std::vector<ReceivedMessage> out;
+    ASSERT_EQ(queue.ReadBatch(out, SIZE_MAX, 0), (size_t)capacity);
+    sender.join();
+
+    std::string readMsg;
+    int readId;
+    ASSERT_TRUE(queue.Read(readMsg, readId, 0));
+    EXPECT_FALSE(queue.Read(readMsg, readId, 10));
+
+    totals = SumQueueStats(*watcher.Stats());
+    EXPECT_EQ(totals.enqueued, 6u);
+    EXPECT_EQ(totals.dequeued, 6u);
+    EXPECT_EQ(totals.fullWaits, 1u);
+    EXPECT_GE(totals.waitNs, 10000000u);
+    EXPECT_EQ(totals.emptyWaits, 1u);
+
+    queue.Close();  // frees the slot, keeping its count
+    totals = SumQueueStats(*watcher.Stats());
+    EXPECT_EQ(totals.senders, 0);
+    EXPECT_EQ(totals.enqueued, 6u);
+}
+
+TEST_F(ShmQueueTest, LongMessageIsTruncated) {
+    std::string longMsg(MAX_MESSAGE_LEN + 10, 'x');
+    EXPECT_TRUE(queue.Send(longMsg, 0));
+
+    std::string readMsg;
+    int readId;
+    EXPECT_TRUE(queue.Read(readMsg, readId, 0));
+    EXPECT_EQ(readMsg, longMsg.substr(0, MAX_MESSAGE_LEN));
+}
+
+TEST_F(ShmQueueTest, SecondMappingSeesSameRing) {
+    ShmQueue other;
+    ASSERT_TRUE(other.Open(name));
+    EXPECT_EQ(other.Capacity(), capacity);
+
+    EXPECT_TRUE(other.Send("via other", 0));
+    std::string readMsg;
+    int readId;
+    EXPECT_TRUE(queue.Read(readMsg, readId, 0));
+    EXPECT_EQ(readMsg, "via other");
+}
+
+TEST_F(ShmQueueTest, BlockedSenderWakesWhenSpaceFrees) {
+    for (int i = 0; i < capacity; i++) ASSERT_TRUE(queue.Send("fill", 0));
+
+    std::atomic<bool> sent(false);
+    std::thread sender([this, &sent]() { sent = queue.Send("late"); });
+
+    std::string readMsg;
+    int readId;
+    ASSERT_TRUE(queue.Read(readMsg, readId));
+    sender.join();
+    EXPECT_TRUE(sent);
+    EXPECT_EQ(queue.Count(), capacity);
+}
+
+TEST_F(ShmQueueTest, ManySendersOneReader) {
+    const int senders = 4;
+    const int perSender = 500;
+    std::vector<std::thread> threads;
+    for (int s = 0; s < senders; s++) {
+        threads.emplace_back([this, s]() {
+            for (int i = 0; i < perSender; i++) queue.Send(std::to_string(s) + ":" + std::to_string(i));
+        });
+    }
+
+    std::vector<int> next(senders, 0);
+    for (int n = 0; n < senders * perSender; n++) {
+        std::string readMsg;
+        int readId;
+        ASSERT_TRUE(queue.Read(readMsg, readId));
+        EXPECT_EQ(readId, n + 1);
+
+        // Per sender the order is preserved.
+        size_t colon = readMsg.find(':');
+        int s = std::stoi(readMsg.substr(0, colon));
+        EXPECT_EQ(std::stoi(readMsg.substr(colon + 1)), next[s]++);
+    }
+    for (auto& t : threads) t.join();
+}
+
+TEST_F(ShmQueueTest, BatchRoundTrip) {
+    std::vector<std::string> texts = { "a", "b", "c" };
+    int firstId = 0;
+    EXPECT_EQ(queue.SendBatch(texts, 0, &firstId), texts.size());
+    EXPECT_EQ(firstId, 1);
+
+    std::vector<ReceivedMessage> out;
+    EXPECT_EQ(queue.ReadBatch(out, 2, 0), 2u);
+    EXPECT_EQ(out[0].text, "a");
+    EXPECT_EQ(out[1].msgId, 2);
+
+    // Drain whatever is left, then nothing is left.
+    EXPECT_EQ(queue.ReadBatch(out, SIZE_MAX, 0), 1u);
+    EXPECT_EQ(out[0].text, "c");
+    EXPECT_EQ(out[0].msgId, 3);
+    EXPECT_EQ(queue.ReadBatch(out, SIZE_MAX, 0), 0u);
+}
+
+TEST_F(ShmQueueTest, BatchLargerThanCapacity) {
+    std::vector<std::string> texts;
+    for (int i = 0; i < capacity * 4 + 2; i++) texts.push_back(std::to_string(i));
+
+    // Without a reader only one ring's worth fits.
+    EXPECT_EQ(queue.SendBatch(texts, 0), (size_t)capacity);
+    std::vector<ReceivedMessage> out;
+    EXPECT_EQ(queue.ReadBatch(out, SIZE_MAX, 0), (size_t)capacity);
+
+    std::thread sender([this, &texts]() { EXPECT_EQ(queue.SendBatch(texts), texts.size()); });
+    size_t received = 0;
+    while (received < texts.size()) {
+        ASSERT_GT(queue.ReadBatch(out, 3, 5000), 0u);
+        for (const auto& m : out) EXPECT_EQ(m.text, texts[received++]);
+    }
+    sender.join();
+}
+
+#if defined(__linux__)
+TEST_F(ShmQueueTest, SenderProcess) {
+    pid_t child = fork();
+    ASSERT_GE(child, 0);
+    if (child == 0) {
+        ShmQueue sender;
+        if (!sender.Open(name)) _exit(1);
+        for (int i = 0; i < 100; i++) {
+            if (!sender.Send("p" + std::to_string(i))) _exit(2);
+        }
+        _exit(0);
+    }
+
+    for (int i = 0; i < 100; i++) {
+        std::string readMsg;
+        int readId;
+        ASSERT_TRUE(queue.Read(readMsg, readId, 5000));
+        EXPECT_EQ(readMsg, "p" + std::to_string(i));
+    }
+
+    int status = 0;
+    waitpid(child, &status, 0);
+    EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+}
+#endif
+
+class DurableQueueTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        path = std::string("test_durable_")
+            + ::testing::UnitTest::GetInstance()->current_test_info()->name() + ".bin";
+        std::remove(path.c_str());
+    }
+
+    void TearDown() override {
+        queue.Close();
+        std::remove(path.c_str());
+    }
+
+    std::string path;
+    ShmQueue queue;
+};
+
+TEST_F(DurableQueueTest, QueuedMessagesSurviveReopen) {
+    ASSERT_TRUE(queue.CreateDurable(path, 5, DURABILITY_GROUP));
+    for (const char* text : { "one", "two", "three" }) EXPECT_TRUE(queue.Send(text, 0));
+    std::string readMsg;
+    int readId;
+    ASSERT_TRUE(queue.Read(readMsg, readId, 0));
+    queue.Close();
+
+    ASSERT_TRUE(queue.CreateDurable(path, 5, DURABILITY_GROUP));
+    EXPECT_EQ(queue.Count(), 2);
+    ASSERT_TRUE(queue.Read(readMsg, readId, 0));
+    EXPECT_EQ(readMsg, "two");
+    EXPECT_EQ(readId, 2);
+
+    int msgId;
+    EXPECT_TRUE(queue.Send("four", 0, &msgId));
+    EXPECT_EQ(msgId, 4);
+}
+
+TEST_F(DurableQueueTest, OtherCapacityStartsEmpty) {
+    ASSERT_TRUE(queue.CreateDurable(path, 5, DURABILITY_ASYNC));
+    EXPECT_TRUE(queue.Send("old", 0));
+    queue.Close();
+
+    ASSERT_TRUE(queue.CreateDurable(path, 8, DURABILITY_ASYNC));
+    EXPECT_EQ(queue.Capacity(), 8);
+    EXPECT_EQ(queue.Count(), 0);
+}
+
+TEST_F(DurableQueueTest, SecondMappingSharesDurability) {
+    ASSERT_TRUE(queue.CreateDurable(path, 5, DURABILITY_GROUP));
+    ShmQueue other;
+    ASSERT_TRUE(other.OpenDurable(path));
+    EXPECT_EQ(other.Durability(), DURABILITY_GROUP);
+    EXPECT_TRUE(other.Send("shared", 0));
+
+    std::string readMsg;
+    int readId;
+    EXPECT_TRUE(queue.Read(readMsg, readId, 0));
+    EXPECT_EQ(readMsg, "shared");
+    EXPECT_FALSE(ShmQueue().OpenDurable(path + ".missing"));
+}
+
+TEST_F(DurableQueueTest, GroupCommitSendReturnsAfterSync) {
+    ASSERT_TRUE(queue.CreateDurable(path, 5, DURABILITY_GROUP));
+    EXPECT_EQ(queue.Flushes(), 0u);
+    EXPECT_TRUE(queue.Send("x", 0));
+    EXPECT_EQ(queue.Flushes(), 1u);
+
+    // Nothing new: no sync needed.
+    EXPECT_TRUE(queue.Flush());
+    EXPECT_EQ(queue.Flushes(), 1u);
+
+    EXPECT_EQ(queue.SendBatch({ "a", "b", "c" }, 0), 3u);
+    EXPECT_EQ(queue.Flushes(), 2u);
+}
+
+TEST_F(DurableQueueTest, ConcurrentSendersShareSyncs) {
+    const int senders = 4;
+    const int perSender = 50;
+    ASSERT_TRUE(queue.CreateDurable(path, 1000, DURABILITY_GROUP));
+
+    // Holding the leader role while the senders queue their first messages
+    // makes them all wait for the same sync.
+    SharedRegion file;
+    ASSERT_TRUE(file.MapFile(path, 0));
+    ShmQueueControl* control = static_cast<ShmQueueControl*>(file.Data());
+    control->flushLeader.store((uint32_t)CurrentProcessId());
+
+    std::vector<std::thread> threads;
+    std::atomic<int> acknowledged(0);
+    for (int s = 0; s < senders; s++) {
+        threads.emplace_back([this, &acknowledged]() {
+            for (int i = 0; i < perSender; i++) {
+                if (queue.Send("m")) acknowledged++;
+            }
+        });
+    }
+    for (int i = 0; i < 500 && control->written.load() < (uint64_t)senders; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_EQ(control->written.load(), (uint64_t)senders);
+    EXPECT_EQ(acknowledged, 0);
+    control->flushLeader.store(0);
+    QueueNotify(control->durableSignal, control->durableWaiters);
+    for (auto& t : threads) t.join();
+
+    // One sync covered the first `senders` messages; the rest need at most one each.
+    EXPECT_EQ(acknowledged, senders * perSender);
+    EXPECT_GE(queue.Flushes(), 1u);
+    EXPECT_LE(queue.Flushes(), (uint64_t)(senders * perSender - senders + 1));
+    EXPECT_EQ(queue.Count(), senders * perSender);
+}
+
+TEST_F(DurableQueueTest, AsyncFlusherCatchesUp) {
+    ASSERT_TRUE(queue.CreateDurable(path, 5, DURABILITY_ASYNC, 5));
+    EXPECT_TRUE(queue.Send("later", 0));
+
+    for (int i = 0; i < 200 && queue.Flushes() == 0; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_GE(queue.Flushes(), 1u);
+}
+
+#if defined(__linux__)
+TEST_F(DurableQueueTest, SenderProcessGroupCommit) {
+    const int perProcess = 20;
+    ASSERT_TRUE(queue.CreateDurable(path, 100, DURABILITY_GROUP));
+
+    pid_t child = fork();
+    ASSERT_GE(child, 0);
+    if (child == 0) {
+        ShmQueue sender;
+        if (!sender.OpenDurable(path)) _exit(1);
+        for (int i = 0; i < perProcess; i++) {
+            if (!sender.Send(std::to_string(i))) _exit(2);
+        }
+        _exit(0);
+    }
+
+    for (int i = 0; i < perProcess; i++) {
+        std::string readMsg;
+        int readId;
+        ASSERT_TRUE(queue.Read(readMsg, readId, 5000));
+        EXPECT_EQ(readMsg, std::to_string(i));
+    }
+
+    int status = 0;
+    waitpid(child, &status, 0);
+    EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    EXPECT_GE(queue.Flushes(), 1u);
+}
+
+TEST_F(DurableQueueTest, DeadFlushLeaderIsTakenOver) {
+    ASSERT_TRUE(queue.CreateDurable(path, 5, DURABILITY_GROUP));
+
+    // A process that exits at once stands in for a leader killed mid-sync.
+    pid_t child = fork();
+    ASSERT_GE(child, 0);
+    if (child == 0) _exit(0);
+    waitpid(child, nullptr, 0);
+
+    SharedRegion file;
+    ASSERT_TRUE(file.MapFile(path, 0));
+    ShmQueueControl* control = static_cast<ShmQueueControl*>(file.Data());
+    control->flushLeader.store((uint32_t)child);
+
+    EXPECT_TRUE(queue.Send("after the crash"));
+    EXPECT_EQ(control->flushLeader.load(), 0u);
+    EXPECT_EQ(queue.Flushes(), 1u);
+}
+#endif
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+struct CpuInfo {
+    int cpu;      // OS cpu number
+    int node;     // NUMA node, numbered 0..nodeCount-1 in the order of the OS node ids
+    int package;  // socket
+    int core;     // physical core id within the package
+    int sibling;  // 0 for the first hardware thread of a core, 1 for the next, ...
+};
+
+// CPUs this process may run on, read from sysfs (/sys/devices/system/cpu and
+// /sys/devices/system/node) and the current affinity mask. The OS may number
+// its nodes with gaps (node0, node2); here they are numbered densely. Elsewhere, or if
+// sysfs is missing, every hardware thread is reported on node 0.
+struct CpuTopology {
+    std::vector<CpuInfo> cpus;
+    int nodeCount;
+
+    std::vector<int> NodeCpus(int node) const;
+};
+
+CpuTopology DiscoverTopology();
+
+enum PlacementPolicy {
+    PLACEMENT_NONE,     // leave it to the scheduler
+    PLACEMENT_COMPACT,  // fill one core, then the next core of the same socket/node
+    PLACEMENT_SCATTER,  // spread over nodes and cores first, SMT siblings last
+    PLACEMENT_NUMA      // contiguous groups of workers per node, data partitioned per node
+};
+
+bool ParsePlacementPolicy(const std::string& name, PlacementPolicy& policy);
+const char* PlacementPolicyName(PlacementPolicy policy);
+
+// Maps worker i of n to a cpu and node under one policy.
+class ThreadPlacement {
+public:
+    ThreadPlacement(PlacementPolicy policy, const CpuTopology& topology);
+
+    PlacementPolicy Policy() const { return policy; }
+    int NodeCount() const { return topology.nodeCount; }
+
+    int CpuFor(int worker, int workers) const;   // -1 for PLACEMENT_NONE
+    int NodeFor(int worker, int workers) const;
+    // Workers [first, last) that PLACEMENT_NUMA puts on the node.
+    void NodeWorkers(int node, int workers, int& first, int& last) const;
+
+    // Pins the calling thread to CpuFor(worker, workers). Returns false if the
+    // OS refused; the thread then keeps running unpinned.
+    bool Apply(int worker, int workers) const;
+    // Pins the calling thread to every cpu of the node.
+    bool ApplyNode(int node) const;
+
+    // "policy=scatter nodes=2 cpus=64"
+    std::string Describe() const;
+
+private:
+    PlacementPolicy policy;
+    CpuTopology topology;
+    std::vector<int> order;  // cpu indices in the order workers take them
+};
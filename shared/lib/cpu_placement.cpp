@@ -0,0 +1,221 @@
+#include "cpu_placement.h"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#if defined(__linux__)
+#include <sched.h>
+#elif defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+// "0-3,8,10-11" -> { 0, 1, 2, 3, 8, 10, 11 }
+static std::vector<int> ParseCpuList(const std::string& text) {
+    std::vector<int> cpus;
+    std::stringstream ss(text);
+    std::string range;
+    while (std::getline(ss, range, ',')) {
+        if (range.empty() || range == "\n") continue;
+        size_t dash = range.find('-');
+        int first = std::atoi(range.c_str());
+        int last = dash == std::string::npos ? first : std::atoi(range.c_str() + dash + 1);
+        for (int c = first; c <= last; c++) cpus.push_back(c);
+    }
+    return cpus;
+}
+
+static bool ReadLine(const std::string& path, std::string& line) {
+    std::ifstream in(path);
+    return in && std::getline(in, line);
+}
+
+static int ReadInt(const std::string& path, int fallback) {
+    std::string line;
+    return ReadLine(path, line) ? std::atoi(line.c_str()) : fallback;
+}
+
+std::vector<int> CpuTopology::NodeCpus(int node) const {
+    std::vector<int> result;
+    for (size_t i = 0; i < cpus.size(); i++) {
+        if (cpus[i].node == node) result.push_back((int)i);
+    }
+    return result;
+}
+
+CpuTopology DiscoverTopology() {
+    CpuTopology topology;
+    topology.nodeCount = 1;
+
+#if defined(__linux__)
+    std::string line;
+    std::vector<int> online;
+    if (ReadLine("/sys/devices/system/cpu/online", line)) online = ParseCpuList(line);
+
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    bool haveMask = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+
+    std::vector<int> nodeIds;
+    if (ReadLine("/sys/devices/system/node/online", line)) nodeIds = ParseCpuList(line);
+
+    std::vector<int> nodeOf;
+    int nodes = 0;
+    for (int id : nodeIds) {
+        std::string base = "/sys/devices/system/node/node" + std::to_string(id);
+        if (!ReadLine(base + "/cpulist", line)) continue;
+        for (int c : ParseCpuList(line)) {
+            if (c >= (int)nodeOf.size()) nodeOf.resize(c + 1, 0);
+            nodeOf[c] = nodes;
+        }
+        nodes++;
+    }
+    topology.nodeCount = std::max(nodes, 1);
+
+    for (int c : online) {
+        if (haveMask && c < CPU_SETSIZE && !CPU_ISSET(c, &allowed)) continue;
+
+        std::string base = "/sys/devices/system/cpu/cpu" + std::to_string(c) + "/topology/";
+        CpuInfo info;
+        info.cpu = c;
+        info.node = c < (int)nodeOf.size() ? nodeOf[c] : 0;
+        info.package = ReadInt(base + "physical_package_id", 0);
+        info.core = ReadInt(base + "core_id", c);
+        info.sibling = 0;
+        if (ReadLine(base + "thread_siblings_list", line)) {
+            std::vector<int> siblings = ParseCpuList(line);
+            info.sibling = (int)(std::find(siblings.begin(), siblings.end(), c) - siblings.begin());
+        }
+        topology.cpus.push_back(info);
+    }
+#endif
+
+    if (topology.cpus.empty()) {
+        topology.nodeCount = 1;
+        unsigned count = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned c = 0; c < count; c++) topology.cpus.push_back({ (int)c, 0, 0, (int)c, 0 });
+    }
+    return topology;
+}
+
+bool ParsePlacementPolicy(const std::string& name, PlacementPolicy& policy) {
+    if (name == "none") policy = PLACEMENT_NONE;
+    else if (name == "compact") policy = PLACEMENT_COMPACT;
+    else if (name == "scatter") policy = PLACEMENT_SCATTER;
+    else if (name == "numa") policy = PLACEMENT_NUMA;
+    else return false;
+    return true;
+}
+
+const char* PlacementPolicyName(PlacementPolicy policy) {
+    switch (policy) {
+    case PLACEMENT_COMPACT: return "compact";
+    case PLACEMENT_SCATTER: return "scatter";
+    case PLACEMENT_NUMA: return "numa";
+    default: return "none";
+    }
+}
+
+ThreadPlacement::ThreadPlacement(PlacementPolicy policy, const CpuTopology& topology)
+    : policy(policy), topology(topology) {
+    const std::vector<CpuInfo>& cpus = this->topology.cpus;
+    for (size_t i = 0; i < cpus.size(); i++) order.push_back((int)i);
+
+    if (policy == PLACEMENT_SCATTER) {
+        // Rank of each core within its node, so the first pass takes one
+        // hardware thread of core 0 on every node, then core 1, ...
+        std::vector<int> rank(cpus.size(), 0);
+        for (size_t i = 0; i < cpus.size(); i++) {
+            for (size_t j = 0; j < cpus.size(); j++) {
+                if (cpus[j].node == cpus[i].node && cpus[j].sibling == 0
+                    && (cpus[j].package < cpus[i].package
+                        || (cpus[j].package == cpus[i].package && cpus[j].core < cpus[i].core))) {
+                    rank[i]++;
+                }
+            }
+        }
+        std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+            if (cpus[a].sibling != cpus[b].sibling) return cpus[a].sibling < cpus[b].sibling;
+            if (rank[a] != rank[b]) return rank[a] < rank[b];
+            return cpus[a].node < cpus[b].node;
+        });
+    }
+    else {
+        std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+            if (cpus[a].node != cpus[b].node) return cpus[a].node < cpus[b].node;
+            if (cpus[a].package != cpus[b].package) return cpus[a].package < cpus[b].package;
+            if (cpus[a].core != cpus[b].core) return cpus[a].core < cpus[b].core;
+            return cpus[a].sibling < cpus[b].sibling;
+        });
+    }
+}
+
+void ThreadPlacement::NodeWorkers(int node, int workers, int& first, int& last) const {
+    int nodes = topology.nodeCount;
+    first = (int)((long long)workers * node / nodes);
+    last = (int)((long long)workers * (node + 1) / nodes);
+}
+
+int ThreadPlacement::NodeFor(int worker, int workers) const {
+    if (policy == PLACEMENT_NUMA) {
+        return (int)((long long)worker * topology.nodeCount / std::max(1, workers));
+    }
+    if (policy == PLACEMENT_NONE) return 0;
+    return topology.cpus[order[worker % order.size()]].node;
+}
+
+int ThreadPlacement::CpuFor(int worker, int workers) const {
+    if (policy == PLACEMENT_NONE) return -1;
+
+    if (policy == PLACEMENT_NUMA) {
+        int node = NodeFor(worker, workers);
+        std::vector<int> nodeCpus = topology.NodeCpus(node);
+        if (nodeCpus.empty()) return topology.cpus[order[worker % order.size()]].cpu;
+        int first, last;
+        NodeWorkers(node, workers, first, last);
+        return topology.cpus[nodeCpus[(worker - first) % nodeCpus.size()]].cpu;
+    }
+
+    return topology.cpus[order[worker % order.size()]].cpu;
+}
+
+static bool PinCurrentThread(const std::vector<int>& cpus) {
+    if (cpus.empty()) return false;
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int c : cpus) {
+        if (c >= 0 && c < CPU_SETSIZE) CPU_SET(c, &set);
+    }
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+#elif defined(_WIN32)
+    DWORD_PTR mask = 0;
+    for (int c : cpus) {
+        if (c >= 0 && c < (int)(sizeof(mask) * 8)) mask |= (DWORD_PTR)1 << c;
+    }
+    return mask && SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+#else
+    return false;
+#endif
+}
+
+bool ThreadPlacement::Apply(int worker, int workers) const {
+    int cpu = CpuFor(worker, workers);
+    if (cpu < 0) return true;
+    return PinCurrentThread({ cpu });
+}
+
+bool ThreadPlacement::ApplyNode(int node) const {
+    if (policy == PLACEMENT_NONE) return true;
+    std::vector<int> cpus;
+    for (int i : topology.NodeCpus(node)) cpus.push_back(topology.cpus[i].cpu);
+    return PinCurrentThread(cpus);
+}
+
+std::string ThreadPlacement::Describe() const {
+    return std::string("policy=") + PlacementPolicyName(policy)
+        + " nodes=" + std::to_string(topology.nodeCount)
+        + " cpus=" + std::to_string(topology.cpus.size());
+}